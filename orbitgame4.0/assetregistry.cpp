@@ -0,0 +1,309 @@
+// 文件: assetregistry.cpp
+#include "assetregistry.h"
+#include "cookedassets.h"
+#include "threadpooltask.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFontDatabase>
+#include <QImageReader>
+#include <QResource>
+#include <QSoundEffect>
+#include <QUrl>
+#include <QDebug>
+
+AssetRegistry* AssetRegistry::instance()
+{
+    static AssetRegistry* registry = nullptr;
+    if (!registry) {
+        registry = new AssetRegistry(QCoreApplication::instance());
+    }
+    return registry;
+}
+
+AssetRegistry::AssetRegistry(QObject* parent)
+    : QObject(parent),
+    m_renderScale(1.0),
+    m_pixmapLoadCount(0)
+{
+}
+
+AssetRegistry::~AssetRegistry()
+{
+    // 等还在解码的后台任务结束（见 threadpooltask.h）
+    for (QFuture<QImage>& future : m_pendingImages) future.waitForFinished();
+    for (QFuture<QVector<QImage>>& future : m_pendingFrames) future.waitForFinished();
+}
+
+QString AssetRegistry::fontFamily(const QString& path, const QString& fallbackFamily)
+{
+    auto it = m_fontFamilies.constFind(path);
+    if (it == m_fontFamilies.constEnd()) {
+        QString family;
+        const int fontId = QFontDatabase::addApplicationFont(path);
+        if (fontId != -1) {
+            const QStringList fontFamilies = QFontDatabase::applicationFontFamilies(fontId);
+            if (!fontFamilies.isEmpty()) {
+                family = fontFamilies.at(0);
+                qDebug() << "AssetRegistry: font" << path << "loaded:" << family;
+            } else {
+                qWarning() << "AssetRegistry: failed to retrieve font family name for" << path;
+            }
+        } else {
+            qWarning() << "AssetRegistry: failed to load font from" << path;
+        }
+        it = m_fontFamilies.insert(path, family);
+    }
+    return it->isEmpty() ? fallbackFamily : *it;
+}
+
+QString AssetRegistry::pixmapKey(const QString& path, const QSize& size, Qt::AspectRatioMode aspectMode,
+                                 qreal pixelScale)
+{
+    QString key = path;
+    if (size.isValid()) {
+        key += QString("@%1x%2/%3").arg(size.width()).arg(size.height()).arg(int(aspectMode));
+    }
+    if (pixelScale > 0) {
+        key += QString("@%1x").arg(pixelScale);
+    }
+    return key;
+}
+
+qreal AssetRegistry::rasterScale(const QString& path, const QSize& size, Qt::AspectRatioMode aspectMode) const
+{
+    // 只有烘焙时输出的 @2x 版本与渲染比例有关
+    if (m_renderScale > 1 && aspectMode == Qt::KeepAspectRatio) {
+        const QString hiDpiPath = cookedAssetPath(path, size, COOKED_HIDPI_SCALE);
+        if (!hiDpiPath.isEmpty() && QFile::exists(hiDpiPath)) return COOKED_HIDPI_SCALE;
+    }
+    return 0;
+}
+
+void AssetRegistry::setRenderScale(qreal scale)
+{
+    if (scale <= 0 || qFuzzyCompare(scale, m_renderScale)) return;
+    qDebug() << "AssetRegistry: render scale" << m_renderScale << "->" << scale;
+    // 越过 1 时烘焙位图在 1x 与 @2x 之间切换；两种版本的缓存键不同，旧的留在缓存里，只需通知持有者。
+    // 其余情况下图片与渲染比例无关
+    const bool hiDpiChanged = (m_renderScale > 1) != (scale > 1);
+    m_renderScale = scale;
+    if (hiDpiChanged) emit renderScaleChanged();
+}
+
+QPixmap AssetRegistry::pixmap(const QString& path, const QSize& size, Qt::AspectRatioMode aspectMode)
+{
+    const qreal pixelScale = rasterScale(path, size, aspectMode);
+    const QString key = pixmapKey(path, size, aspectMode, pixelScale);
+    auto it = m_pixmaps.constFind(key);
+    if (it != m_pixmaps.constEnd()) return *it;
+
+    QPixmap result;
+    auto pending = m_pendingImages.find(key);
+    if (pending != m_pendingImages.end()) {
+        // 预加载过: 只剩在主线程转换成 QPixmap（还没解码完时等它）
+        result = QPixmap::fromImage(pending->result());
+        m_pendingImages.erase(pending);
+        qDebug() << "AssetRegistry: cached" << key << "(preloaded)";
+    } else if (pixelScale <= 0 && size.isValid() && m_pixmaps.contains(pixmapKey(path, QSize(), Qt::KeepAspectRatio))) {
+        // 原图已经解码过（例如开始界面的背景，每个窗口尺寸一份）：只缩放，不再读文件
+        const QPixmap original = m_pixmaps.value(pixmapKey(path, QSize(), Qt::KeepAspectRatio));
+        if (!original.isNull()) result = original.scaled(size, aspectMode, Qt::SmoothTransformation);
+        qDebug() << "AssetRegistry: cached" << key << "(scaled from the cached original)";
+    } else {
+        result = QPixmap::fromImage(loadImage(path, size, aspectMode, pixelScale));
+        ++m_pixmapLoadCount;
+        qDebug() << "AssetRegistry: cached" << key << "(" << m_pixmapLoadCount << "synchronous image loads so far)";
+    }
+    m_pixmaps.insert(key, result);
+    return result;
+}
+
+bool AssetRegistry::hasPixmap(const QString& path, const QSize& size, Qt::AspectRatioMode aspectMode) const
+{
+    const qreal pixelScale = rasterScale(path, size, aspectMode);
+    return m_pixmaps.contains(pixmapKey(path, size, aspectMode, pixelScale));
+}
+
+void AssetRegistry::preload(const QString& path, const QSize& size, Qt::AspectRatioMode aspectMode)
+{
+    const qreal pixelScale = rasterScale(path, size, aspectMode);
+    const QString key = pixmapKey(path, size, aspectMode, pixelScale);
+    if (m_pixmaps.contains(key) || m_pendingImages.contains(key)) return;
+    m_pendingImages.insert(key, runInThreadPool<QImage>([path, size, aspectMode, pixelScale]() {
+        return loadImage(path, size, aspectMode, pixelScale);
+    }));
+}
+
+QVector<QPixmap> AssetRegistry::frames(const QString& path, const QSize& size)
+{
+    const QString key = pixmapKey(path, size, Qt::KeepAspectRatio);
+    auto it = m_frames.constFind(key);
+    if (it != m_frames.constEnd()) return *it;
+
+    QVector<QImage> images;
+    auto pending = m_pendingFrames.find(key);
+    if (pending != m_pendingFrames.end()) {
+        images = pending->result();
+        m_pendingFrames.erase(pending);
+    } else {
+        images = loadFrames(path, size);
+        ++m_pixmapLoadCount;
+    }
+    QVector<QPixmap> result;
+    result.reserve(images.size());
+    for (const QImage& image : images) {
+        result.append(QPixmap::fromImage(image));
+    }
+    qDebug() << "AssetRegistry: cached" << result.size() << "frames of" << key;
+    m_frames.insert(key, result);
+    return result;
+}
+
+void AssetRegistry::preloadFrames(const QString& path, const QSize& size)
+{
+    const QString key = pixmapKey(path, size, Qt::KeepAspectRatio);
+    if (m_frames.contains(key) || m_pendingFrames.contains(key)) return;
+    m_pendingFrames.insert(key, runInThreadPool<QVector<QImage>>([path, size]() {
+        return loadFrames(path, size);
+    }));
+}
+
+QImage AssetRegistry::loadImage(const QString& path, const QSize& size, Qt::AspectRatioMode aspectMode,
+                                qreal pixelScale)
+{
+    if (aspectMode == Qt::KeepAspectRatio) {
+        if (pixelScale > 1) {
+            // 高 DPI: 烘焙好的 2 倍像素版本，按逻辑尺寸摆放
+            QImage hiDpi(cookedAssetPath(path, size, COOKED_HIDPI_SCALE));
+            if (!hiDpi.isNull()) {
+                hiDpi.setDevicePixelRatio(COOKED_HIDPI_SCALE);
+                return hiDpi;
+            }
+        }
+        // 构建时烘焙好的版本已经是这个尺寸，直接解码，不用缩放
+        const QString cookedPath = cookedAssetPath(path, size);
+        if (!cookedPath.isEmpty() && QFile::exists(cookedPath)) {
+            const QImage cooked(cookedPath);
+            if (!cooked.isNull()) return cooked;
+            qWarning() << "AssetRegistry: failed to load cooked image" << cookedPath << ", falling back to" << path;
+        } else if (!cookedPath.isEmpty()) {
+            // 没烘焙过的尺寸（例如热重载时改了装饰的大小）从 sprites.rcc 里的原图缩放
+            qDebug() << "AssetRegistry:" << path << "was not cooked at" << size << ", scaling the original";
+        }
+    }
+
+    QImage image(path);
+    if (image.isNull()) {
+        qWarning() << "AssetRegistry: failed to load image" << path;
+    } else if (size.isValid()) {
+        image = image.scaled(size, aspectMode, Qt::SmoothTransformation);
+    }
+    return image;
+}
+
+QVector<QImage> AssetRegistry::loadFrames(const QString& path, const QSize& size)
+{
+    // QMovie 内部也是用 QImageReader 逐帧读取，帧号一一对应
+    QVector<QImage> frames;
+    QImageReader reader(path);
+    while (reader.canRead()) {
+        const QImage frame = reader.read();
+        if (frame.isNull()) break;
+        frames.append(frame.scaled(size, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+    }
+    if (frames.isEmpty()) {
+        qWarning() << "AssetRegistry: failed to read animation frames from" << path << reader.errorString();
+    }
+    return frames;
+}
+
+bool AssetRegistry::registerBundle(const char* fileName)
+{
+    // qmake 在 Windows 上把程序放在 debug/ 或 release/ 子目录，资源包在上一级
+    const QDir appDir(QCoreApplication::applicationDirPath());
+    const QStringList candidates = { appDir.filePath(fileName), appDir.filePath(QString("../") + fileName),
+                                     appDir.filePath(QString("../Resources/") + fileName) }; // macOS 程序包
+    for (const QString& candidate : candidates) {
+        if (!QFile::exists(candidate)) continue;
+        // 按文件名注册时 Qt 映射整个文件，不会把几 MB 的内容读进内存
+        if (QResource::registerResource(QDir::cleanPath(candidate))) {
+            qDebug() << "AssetRegistry: registered resource bundle" << QDir::cleanPath(candidate);
+            return true;
+        }
+        qWarning() << "AssetRegistry: failed to register resource bundle" << candidate;
+    }
+    return false;
+}
+
+bool AssetRegistry::registerMediaBundle()
+{
+    if (registerBundle(MEDIA_BUNDLE_FILE)) return true;
+    qWarning() << "AssetRegistry: media bundle" << MEDIA_BUNDLE_FILE << "not found next to"
+               << QCoreApplication::applicationDirPath() << "; videos and music will not play";
+    return false;
+}
+
+bool AssetRegistry::registerSpriteBundle()
+{
+    if (registerBundle(SPRITE_BUNDLE_FILE)) return true;
+    qWarning() << "AssetRegistry: sprite bundle" << SPRITE_BUNDLE_FILE << "not found next to"
+               << QCoreApplication::applicationDirPath() << "; only cooked sprite sizes will load";
+    return false;
+}
+
+QUrl AssetRegistry::mediaUrl(const QString& resourcePath)
+{
+    const QString relativePath = resourcePath.startsWith(":/") ? resourcePath.mid(2) : resourcePath;
+    const QString looseFile = QDir(QCoreApplication::applicationDirPath()).filePath(QString(MEDIA_LOOSE_FILES_DIR) + '/' + relativePath);
+    if (QFile::exists(looseFile)) {
+        return QUrl::fromLocalFile(looseFile);
+    }
+    return QUrl("qrc:/" + relativePath);
+}
+
+AssetRegistry::SoundVoices& AssetRegistry::soundVoices(const QString& url, qreal volume)
+{
+    SoundVoices& voices = m_sounds[url];
+    if (voices.effects.isEmpty()) {
+        for (int i = 0; i < SOUND_VOICES_PER_FILE; ++i) {
+            QSoundEffect* effect = new QSoundEffect(this);
+            effect->setSource(QUrl(url));
+            effect->setVolume(volume);
+            voices.effects.append(effect);
+        }
+    }
+    return voices;
+}
+
+QSoundEffect* AssetRegistry::sound(const QString& url, qreal volume)
+{
+    // 一个 QSoundEffect 同时只能播放一次，再 play() 会从头开始；轮流使用几个实例，前一次还没放完也不会被打断
+    SoundVoices& voices = soundVoices(url, volume);
+    QSoundEffect* effect = voices.effects[voices.next];
+    voices.next = (voices.next + 1) % voices.effects.size();
+    return effect;
+}
+
+void AssetRegistry::preloadSound(const QString& url, qreal volume)
+{
+    soundVoices(url, volume);
+}
+
+void AssetRegistry::releasePixmap(const QString& path, const QSize& size, Qt::AspectRatioMode aspectMode)
+{
+    const qreal pixelScale = rasterScale(path, size, aspectMode);
+    const QString key = pixmapKey(path, size, aspectMode, pixelScale);
+    m_pixmaps.remove(key);
+}
+
+void AssetRegistry::releasePixmaps(const QString& path)
+{
+    for (auto it = m_pixmaps.begin(); it != m_pixmaps.end();) {
+        if (it.key() == path || it.key().startsWith(path + '@')) {
+            it = m_pixmaps.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
@@ -0,0 +1,137 @@
+#ifndef ASSETREGISTRY_H
+#define ASSETREGISTRY_H
+
+#include <QObject>
+#include <QFuture>
+#include <QHash>
+#include <QImage>
+#include <QPixmap>
+#include <QSize>
+#include <QString>
+#include <QUrl>
+#include <QVector>
+
+class QSoundEffect;
+
+// 同一个音效最多同时播放几次（见 AssetRegistry::sound）
+const int SOUND_VOICES_PER_FILE = 4;
+
+// ==========================================================================
+// AssetRegistry: 字体、图片、音效的集中缓存。
+// 每个资源只加载一次，之后交出去的都是共享的句柄:
+//  - 字体: 同一个文件只 addApplicationFont 一次，之后直接返回家族名
+//  - 图片: 按 (路径, 目标尺寸) 缓存缩放好的 QPixmap。QPixmap 本身是隐式共享（引用计数）的，
+//          几百个物品拿到的是同一份像素数据，重开一局也不会再解码/缩放
+//  - 音效: 同一个文件只加载 SOUND_VOICES_PER_FILE 个 QSoundEffect（注册表持有），每次播放轮流交出一个，
+//          快速连续收集/受击时重叠的几次播放不会互相打断
+//  - 高 DPI: 渲染比例（设备像素比 × 视图缩放）大于 1 时使用构建时烘焙的 @2x 版本（见 cookedassets.h），
+//          越过 1 时发出 renderScaleChanged() 让场景换上新图
+//  - 原图: 飞船、物品和行星的原图在外部资源包 sprites.rcc 里（程序里只有烘焙好的尺寸，见 cookedassets.h），
+//          registerSpriteBundle() 映射注册，只有请求了没烘焙过的尺寸时才会读到
+//  - 媒体: 视频和背景音乐在程序旁边的外部资源包 media.rcc 里，启动时 registerMediaBundle() 按文件注册
+//          （Qt 直接映射文件，播放时才从磁盘读到用到的部分）；mediaUrl() 给出播放地址
+//  - 预加载: preload()/preloadFrames() 在线程池里把图片解码、缩放成 QImage（QPixmap 只能在主线程创建），
+//          之后第一次 pixmap()/frames() 时只需在主线程转换一次；还没做完时等它做完
+// 注册表挂在 QApplication 下，随程序退出释放。除了后台解码，只能在主线程使用。
+// ==========================================================================
+
+const char* const CHINESE_FONT_PATH = ":/fonts/MyChineseFont.ttf";
+const char* const ENGLISH_FONT_PATH = ":/fonts/MyEnglishFont.ttf";
+const char* const DEFAULT_CHINESE_FONT_FAMILY = "SimSun";
+const char* const DEFAULT_ENGLISH_FONT_FAMILY = "Arial";
+const char* const MEDIA_BUNDLE_FILE = "media.rcc";
+const char* const SPRITE_BUNDLE_FILE = "sprites.rcc";
+const char* const MEDIA_LOOSE_FILES_DIR = "media";
+
+class AssetRegistry : public QObject
+{
+    Q_OBJECT
+
+public:
+    static AssetRegistry* instance();
+
+    // 字体文件的家族名。加载失败时返回 fallbackFamily（失败也只尝试一次）
+    QString fontFamily(const QString& path, const QString& fallbackFamily);
+
+    // path 缩放到 size 以内（保持比例，平滑缩放）后的图片；size 无效时返回原图。
+    // 原图已经在缓存里时直接从它缩放，不再解码文件。
+    // 加载失败时返回空 QPixmap（失败也会被记住，不会每次重试）
+    QPixmap pixmap(const QString& path, const QSize& size = QSize(),
+                   Qt::AspectRatioMode aspectMode = Qt::KeepAspectRatio);
+    // 是否已经有 (path, size) 的缓存
+    bool hasPixmap(const QString& path, const QSize& size = QSize(),
+                   Qt::AspectRatioMode aspectMode = Qt::KeepAspectRatio) const;
+
+    // 在线程池中提前解码并缩放 (path, size) 的图片。已经缓存或正在解码时什么也不做
+    void preload(const QString& path, const QSize& size = QSize(),
+                 Qt::AspectRatioMode aspectMode = Qt::KeepAspectRatio);
+
+    // 动画（GIF）的每一帧，缩放到 size 以内。顺序与 QMovie 的帧号一致，可以在 frameChanged 里直接取用。
+    // 加载失败时返回空列表
+    QVector<QPixmap> frames(const QString& path, const QSize& size);
+    // 在线程池中提前解码并缩放动画的所有帧
+    void preloadFrames(const QString& path, const QSize& size);
+
+    // 矢量图光栅化使用的比例 = 设备像素比 × 视图缩放（MainWindow 维护）
+    qreal renderScale() const { return m_renderScale; }
+    void setRenderScale(qreal scale);
+
+    // 注册外部媒体包 media.rcc（在程序目录及其上一级查找）。找不到时返回 false，视频和音乐会无法播放，
+    // 但游戏本身不受影响。应在创建播放器之前调用一次
+    static bool registerMediaBundle();
+    // 媒体的播放地址。resourcePath 如 ":/videos/intro_video.mp4"。
+    // 程序目录下有同名的散文件（media/videos/intro_video.mp4）时直接播放磁盘文件，否则用资源包里的 qrc 地址
+    static QUrl mediaUrl(const QString& resourcePath);
+    // 注册原图资源包 sprites.rcc（查找方式同上）。程序里只有烘焙好的尺寸，其他尺寸要从原图缩放。
+    // 找不到时返回 false，没烘焙过的尺寸会加载失败
+    static bool registerSpriteBundle();
+
+    // 要播放一次音效时调用，轮流返回这个文件的各个实例（不要保存下来反复 play()）。
+    // 第一次请求时创建并开始加载，volume 以第一次为准
+    QSoundEffect* sound(const QString& url, qreal volume = 1.0);
+    // 提前创建并开始加载，第一次播放时已经加载好
+    void preloadSound(const QString& url, qreal volume = 1.0);
+
+    // 丢掉某个文件的所有缓存尺寸
+    void releasePixmaps(const QString& path);
+    // 只丢掉某一个尺寸（例如窗口大小变了以后不再使用的背景）
+    void releasePixmap(const QString& path, const QSize& size,
+                       Qt::AspectRatioMode aspectMode = Qt::KeepAspectRatio);
+
+    ~AssetRegistry();
+
+signals:
+    // 渲染比例越过了 1，之前拿到的烘焙位图（1x 或 @2x）已经不合适，持有者应重新调用 pixmap()
+    void renderScaleChanged();
+
+private:
+    explicit AssetRegistry(QObject* parent = nullptr);
+    static QString pixmapKey(const QString& path, const QSize& size, Qt::AspectRatioMode aspectMode,
+                             qreal pixelScale = 0);
+    // (path, size) 的图片使用的像素比例: 渲染比例大于 1 且有烘焙好的 @2x 版本时为 COOKED_HIDPI_SCALE，
+    // 否则为 0（普通位图）
+    qreal rasterScale(const QString& path, const QSize& size, Qt::AspectRatioMode aspectMode) const;
+    // 在当前线程解码（后台任务调用，只用 QImage）。pixelScale > 1 时读 @2x 烘焙图，没有再读普通位图
+    static QImage loadImage(const QString& path, const QSize& size, Qt::AspectRatioMode aspectMode,
+                            qreal pixelScale = 0);
+    // 在程序目录（及 qmake/macOS 的常见位置）查找 fileName 并映射注册
+    static bool registerBundle(const char* fileName);
+    static QVector<QImage> loadFrames(const QString& path, const QSize& size);
+
+    struct SoundVoices {
+        QVector<QSoundEffect*> effects; // 子对象，随注册表释放
+        int next = 0;                   // 下一次播放用哪一个
+    };
+    SoundVoices& soundVoices(const QString& url, qreal volume);
+
+    QHash<QString, QString> m_fontFamilies; // 路径 -> 家族名（失败时为空字符串）
+    QHash<QString, QPixmap> m_pixmaps;      // pixmapKey -> 缩放好的图片
+    QHash<QString, SoundVoices> m_sounds;   // url -> 轮流播放的音效实例
+    QHash<QString, QVector<QPixmap>> m_frames; // pixmapKey -> 动画的每一帧
+    QHash<QString, QFuture<QImage>> m_pendingImages;          // 后台还在解码的图片
+    QHash<QString, QFuture<QVector<QImage>>> m_pendingFrames; // 后台还在解码的动画
+    qreal m_renderScale;
+    int m_pixmapLoadCount;                  // 实际解码图片的次数，调试用
+};
+
+#endif // ASSETREGISTRY_H
@@ -1,8 +1,9 @@
 // 文件: collectibleitem.cpp
 #include "collectibleitem.h"
+#include "assetregistry.h"
 #include <QDebug>
 #include <QPixmap>
-#include <QUrl> // <--- 添加 QUrl 头文件 (用于 QSoundEffect::setSource)
+#include <QSoundEffect>
 
 CollectibleItem::CollectibleItem(int associatedTrackIndex, qreal angleOnTrackRadians,
                                  QGraphicsItem *parent)
@@ -18,33 +19,14 @@ CollectibleItem::CollectibleItem(int associatedTrackIndex, qreal angleOnTrackRad
     << "associatedTrackIndex received:" << associatedTrackIndex
     << "angle (rad):" << angleOnTrackRadians;
 
-    QPixmap originalPixmap(":/images/collectible.png");
-
-    if (originalPixmap.isNull()) {
-        qWarning() << "Failed to load collectible image ':/images/collectible.png'. Using fallback red square.";
-        QPixmap fallbackPixmap(static_cast<int>(DEFAULT_COLLECTIBLE_TARGET_SIZE), static_cast<int>(DEFAULT_COLLECTIBLE_TARGET_SIZE));
-        fallbackPixmap.fill(Qt::red);
-        setPixmap(fallbackPixmap);
-    } else {
-        QPixmap scaledPixmap = originalPixmap.scaled(static_cast<int>(DEFAULT_COLLECTIBLE_TARGET_SIZE),
-                                                     static_cast<int>(DEFAULT_COLLECTIBLE_TARGET_SIZE),
-                                                     Qt::KeepAspectRatio,
-                                                     Qt::SmoothTransformation);
-        setPixmap(scaledPixmap);
-    }
-
-    if (!pixmap().isNull()) {
-        setTransformOriginPoint(pixmap().width() / 2.0, pixmap().height() / 2.0);
-    }
+    refreshPixmap();
+    setShapeMode(QGraphicsPixmapItem::BoundingRectShape); // 命中判定在 OrbitSimulation 中按半径计算
 
     setZValue(0.5);
     setVisible(false);
 
-    // 初始化收集音效
-    m_collectSoundEffect.setSource(QUrl("qrc:/sounds/collect.wav")); // <--- 设置音效文件路径 (对应 .qrc 中的 alias)
-    m_collectSoundEffect.setVolume(0.75); // 可选: 设置音量 (0.0 到 1.0)
-    // m_collectSoundEffect.setLoopCount(1); // 确保只播放一次 (QSoundEffect 默认播放一次)
-    // 如果需要明确设置，可以取消注释
+    // 收集音效: 同类物品共用 AssetRegistry 里的几个 QSoundEffect，不必每个物品各加载一遍
+    AssetRegistry::instance()->preloadSound("qrc:/sounds/collect.wav", 0.75);
 }
 
 CollectibleItem::~CollectibleItem()
@@ -58,17 +40,49 @@ void CollectibleItem::collect()
         m_isCollected = true;
         setVisible(false);
 
-        // 播放收集音效
-        if (m_collectSoundEffect.isLoaded()) { // 检查音效是否已成功加载
-            m_collectSoundEffect.play();
+        // 播放收集音效（每次取一个实例，连续收集时不会打断上一次）
+        QSoundEffect* collectSound = AssetRegistry::instance()->sound("qrc:/sounds/collect.wav", 0.75);
+        if (collectSound->isLoaded()) { // 检查音效是否已成功加载
+            collectSound->play();
         } else {
-            qWarning() << "Collect sound (qrc:/sounds/collect.wav) not loaded or error: " << m_collectSoundEffect.status();
+            qWarning() << "Collect sound (qrc:/sounds/collect.wav) not loaded or error: " << collectSound->status();
         }
 
         emit collectedSignal(this);
     }
 }
 
+void CollectibleItem::reuse(int associatedTrackIndex, qreal angleOnTrackRadians)
+{
+    m_associatedTrackIndex = associatedTrackIndex;
+    m_angleOnTrack = angleOnTrackRadians;
+    m_isCollected = false;
+    m_orbitOffset = 0;
+    setVisible(false); // 与构造后一样，定位之后再显示
+}
+
+void CollectibleItem::refreshPixmap()
+{
+    // 贴图由 AssetRegistry 共享: 每关几百个物品只解码、缩放一次
+    QPixmap scaledPixmap = AssetRegistry::instance()->pixmap(":/images/collectible.png",
+                                                            QSize(static_cast<int>(DEFAULT_COLLECTIBLE_TARGET_SIZE),
+                                                                  static_cast<int>(DEFAULT_COLLECTIBLE_TARGET_SIZE)));
+
+    if (scaledPixmap.isNull()) {
+        qWarning() << "Failed to load collectible image ':/images/collectible.png'. Using fallback red square.";
+        QPixmap fallbackPixmap(static_cast<int>(DEFAULT_COLLECTIBLE_TARGET_SIZE), static_cast<int>(DEFAULT_COLLECTIBLE_TARGET_SIZE));
+        fallbackPixmap.fill(Qt::red);
+        setPixmap(fallbackPixmap);
+    } else {
+        setPixmap(scaledPixmap);
+    }
+
+    if (!pixmap().isNull()) {
+        const QSizeF logicalSize = pixmap().deviceIndependentSize(); // 矢量贴图的像素数是逻辑尺寸的 DPR 倍
+        setTransformOriginPoint(logicalSize.width() / 2.0, logicalSize.height() / 2.0);
+    }
+}
+
 // ... (其他 CollectibleItem 的方法保持不变) ...
 
 bool CollectibleItem::isCollected() const
@@ -109,8 +123,9 @@ void CollectibleItem::updateVisualPosition(const QPointF& trackCenter, qreal tra
     qreal y_center = trackCenter.y() + effectiveOrbitRadius * qSin(m_angleOnTrack);
 
     if (!pixmap().isNull()) {
-        setPos(x_center - pixmap().width() / 2.0,
-               y_center - pixmap().height() / 2.0);
+        const QSizeF logicalSize = pixmap().deviceIndependentSize();
+        setPos(x_center - logicalSize.width() / 2.0,
+               y_center - logicalSize.height() / 2.0);
     } else {
         setPos(x_center, y_center);
     }
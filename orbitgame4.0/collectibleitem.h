@@ -7,11 +7,10 @@
 #include <QtMath>
 #include <QRandomGenerator>
 #include <QPixmap>
-#include <QSoundEffect> // <--- 添加 QSoundEffect 头文件
+
+#include "orbitsimulation.h" // DEFAULT_SCORE_PER_COLLECTIBLE, DEFAULT_COLLECTIBLE_TARGET_SIZE
 
 // 收集品常量
-const qreal DEFAULT_COLLECTIBLE_TARGET_SIZE = 25.0;
-const int DEFAULT_SCORE_PER_COLLECTIBLE = 1;
 const qreal COLLECTIBLE_ORBIT_PADDING = 0.0;
 
 class CollectibleItem : public QObject, public QGraphicsPixmapItem
@@ -25,6 +24,10 @@ public:
 
     void collect();
     bool isCollected() const;
+    // 流式关卡回收图元：换到另一条轨道上的新位置，恢复成未收集（不必重新加载贴图和音效）
+    void reuse(int associatedTrackIndex, qreal angleOnTrackRadians);
+    // 重新向 AssetRegistry 取贴图（渲染比例变化后矢量贴图会重新光栅化）
+    void refreshPixmap();
     int getScoreValue() const;
 
     int getAssociatedTrackIndex() const;
@@ -45,7 +48,6 @@ private:
     bool m_isCollected;
     int m_scoreValue;
     qreal m_orbitOffset;
-    QSoundEffect m_collectSoundEffect; // <--- 添加 QSoundEffect 成员变量
 };
 
 #endif // COLLECTIBLEITEM_H
@@ -0,0 +1,275 @@
+// 文件: compiledlevel.cpp
+#include "compiledlevel.h"
+#include <cstring>
+#include <limits>
+#include <QDebug>
+
+namespace {
+
+qint64 alignTo8(qint64 offset)
+{
+    return (offset + 7) & ~qint64(7);
+}
+
+} // namespace
+
+CompiledLevel::CompiledLevel()
+    : m_data(nullptr),
+    m_size(0)
+{
+    std::memset(&m_header, 0, sizeof(m_header));
+}
+
+CompiledLevel::~CompiledLevel()
+{
+    close();
+}
+
+QByteArray CompiledLevel::compile(const TrackData& level)
+{
+    CompiledLevelHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, COMPILED_LEVEL_MAGIC, sizeof(header.magic));
+    header.version = COMPILED_LEVEL_VERSION;
+    header.segmentCount = static_cast<quint32>(level.segments.size());
+    for (const TrackSegmentData& segment : level.segments) {
+        header.collectibleCount += static_cast<quint32>(segment.collectibles.size());
+        header.obstacleCount += static_cast<quint32>(segment.obstacles.size());
+    }
+    header.sceneryCount = static_cast<quint32>(level.scenery.size());
+    QByteArray strings;
+    for (const SceneryData& scenery : level.scenery) strings.append(scenery.image.toUtf8());
+    header.segmentTableOffset = alignTo8(sizeof(CompiledLevelHeader));
+    header.collectibleTableOffset = alignTo8(header.segmentTableOffset + qint64(header.segmentCount) * sizeof(CompiledSegment));
+    header.obstacleTableOffset = alignTo8(header.collectibleTableOffset + qint64(header.collectibleCount) * sizeof(CompiledItem));
+    header.sceneryTableOffset = alignTo8(header.obstacleTableOffset + qint64(header.obstacleCount) * sizeof(CompiledItem));
+    header.stringTableOffset = header.sceneryTableOffset + qint64(header.sceneryCount) * sizeof(CompiledScenery);
+    header.stringTableSize = strings.size();
+    header.endTriggerX = level.endTrigger.x;
+    header.endTriggerY = level.endTrigger.y;
+    header.endTriggerRadius = level.endTrigger.radius;
+    const qint64 totalSize = header.stringTableOffset + header.stringTableSize;
+
+    QByteArray data(totalSize, '\0');
+    char* out = data.data();
+    std::memcpy(out, &header, sizeof(header));
+
+    quint32 nextCollectible = 0;
+    quint32 nextObstacle = 0;
+    char* segmentOut = out + header.segmentTableOffset;
+    char* collectibleOut = out + header.collectibleTableOffset;
+    char* obstacleOut = out + header.obstacleTableOffset;
+    for (const TrackSegmentData& segment : level.segments) {
+        CompiledSegment compiled;
+        compiled.centerX = segment.centerX;
+        compiled.centerY = segment.centerY;
+        compiled.radius = segment.radius;
+        compiled.tangentAngleDegrees = segment.tangentAngleDegrees;
+        compiled.firstCollectible = nextCollectible;
+        compiled.collectibleCount = static_cast<quint32>(segment.collectibles.size());
+        compiled.firstObstacle = nextObstacle;
+        compiled.obstacleCount = static_cast<quint32>(segment.obstacles.size());
+        std::memcpy(segmentOut, &compiled, sizeof(compiled));
+        segmentOut += sizeof(compiled);
+
+        for (const CollectibleData& data : segment.collectibles) {
+            const CompiledItem item = {data.angleDegrees, data.radialOffset};
+            std::memcpy(collectibleOut, &item, sizeof(item));
+            collectibleOut += sizeof(item);
+        }
+        for (const ObstacleData& data : segment.obstacles) {
+            const CompiledItem item = {data.angleDegrees, data.radialOffset};
+            std::memcpy(obstacleOut, &item, sizeof(item));
+            obstacleOut += sizeof(item);
+        }
+        nextCollectible += compiled.collectibleCount;
+        nextObstacle += compiled.obstacleCount;
+    }
+
+    quint32 nextString = 0;
+    char* sceneryOut = out + header.sceneryTableOffset;
+    for (const SceneryData& scenery : level.scenery) {
+        CompiledScenery compiled;
+        std::memset(&compiled, 0, sizeof(compiled));
+        compiled.x = scenery.x;
+        compiled.y = scenery.y;
+        compiled.width = scenery.width;
+        compiled.height = scenery.height;
+        compiled.z = scenery.z;
+        compiled.imageOffset = nextString;
+        compiled.imageLength = static_cast<quint32>(scenery.image.toUtf8().size());
+        std::memcpy(sceneryOut, &compiled, sizeof(compiled));
+        sceneryOut += sizeof(compiled);
+        nextString += compiled.imageLength;
+    }
+    if (!strings.isEmpty()) std::memcpy(out + header.stringTableOffset, strings.constData(), strings.size());
+    return data;
+}
+
+bool CompiledLevel::fail(const QString& message, QString* errorString)
+{
+    qWarning() << "CompiledLevel:" << message;
+    if (errorString) *errorString = message;
+    close();
+    return false;
+}
+
+bool CompiledLevel::open(const QString& path, QString* errorString)
+{
+    close();
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    return fail(QString("compiled levels are little-endian; rebuild %1 from JSON on this host").arg(path), errorString);
+#endif
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return fail(QString("cannot open %1: %2").arg(path, m_file.errorString()), errorString);
+    }
+    m_size = m_file.size();
+    m_data = m_file.map(0, m_size);
+    if (!m_data) {
+        // 例如被 rcc 压缩过的资源文件：读进内存后照常使用
+        qDebug() << "CompiledLevel: cannot map" << path << ", reading it instead";
+        m_buffer = m_file.readAll();
+        m_size = m_buffer.size();
+        m_data = reinterpret_cast<const uchar*>(m_buffer.constData());
+    }
+
+    // 魔数和版本号在各版本的文件头里位置相同，先检查它们，旧版本的文件给出明确的提示
+    if (m_size < qint64(sizeof(m_header.magic) + sizeof(m_header.version))) {
+        return fail(QString("%1 is too small to be a compiled level").arg(path), errorString);
+    }
+    std::memcpy(&m_header, m_data, sizeof(m_header.magic) + sizeof(m_header.version));
+    if (std::memcmp(m_header.magic, COMPILED_LEVEL_MAGIC, sizeof(m_header.magic)) != 0) {
+        return fail(QString("%1 is not a compiled level").arg(path), errorString);
+    }
+    if (m_header.version != COMPILED_LEVEL_VERSION) {
+        return fail(QString("%1 has version %2, expected %3; recompile it with orbitlevelcompiler")
+                        .arg(path).arg(m_header.version).arg(COMPILED_LEVEL_VERSION),
+                    errorString);
+    }
+    if (m_size < qint64(sizeof(CompiledLevelHeader))) {
+        return fail(QString("%1 is too small to be a compiled level").arg(path), errorString);
+    }
+    std::memcpy(&m_header, m_data, sizeof(m_header));
+    // 只检查各表都在文件范围内；表项本身在读取时再检查，打开时不需要碰整个文件
+    const auto tableFits = [this](quint64 offset, quint32 count, quint64 entrySize) {
+        return offset <= quint64(m_size) && quint64(count) <= (quint64(m_size) - offset) / entrySize;
+    };
+    if (!tableFits(m_header.segmentTableOffset, m_header.segmentCount, sizeof(CompiledSegment))
+        || !tableFits(m_header.collectibleTableOffset, m_header.collectibleCount, sizeof(CompiledItem))
+        || !tableFits(m_header.obstacleTableOffset, m_header.obstacleCount, sizeof(CompiledItem))
+        || !tableFits(m_header.sceneryTableOffset, m_header.sceneryCount, sizeof(CompiledScenery))
+        || m_header.stringTableOffset > quint64(m_size) || m_header.stringTableSize > quint64(m_size) - m_header.stringTableOffset
+        || m_header.segmentCount > quint32(std::numeric_limits<int>::max())
+        || m_header.collectibleCount > quint32(std::numeric_limits<int>::max())
+        || m_header.obstacleCount > quint32(std::numeric_limits<int>::max())
+        || m_header.sceneryCount > quint32(std::numeric_limits<int>::max())) {
+        return fail(QString("%1 is truncated or corrupt").arg(path), errorString);
+    }
+
+    qDebug() << "CompiledLevel: opened" << path << "with" << m_header.segmentCount << "segments,"
+             << m_header.collectibleCount << "collectibles," << m_header.obstacleCount << "obstacles,"
+             << m_header.sceneryCount << "scenery items";
+    return true;
+}
+
+void CompiledLevel::close()
+{
+    if (m_data && m_buffer.isEmpty()) {
+        m_file.unmap(const_cast<uchar*>(m_data));
+    }
+    m_file.close();
+    m_buffer.clear();
+    m_data = nullptr;
+    m_size = 0;
+    std::memset(&m_header, 0, sizeof(m_header));
+}
+
+CompiledSegment CompiledLevel::segment(int index) const
+{
+    CompiledSegment segment;
+    std::memcpy(&segment, m_data + m_header.segmentTableOffset + quint64(index) * sizeof(CompiledSegment), sizeof(segment));
+    if (quint64(segment.firstCollectible) + segment.collectibleCount > m_header.collectibleCount
+        || quint64(segment.firstObstacle) + segment.obstacleCount > m_header.obstacleCount) {
+        qWarning() << "CompiledLevel: segment" << index << "references items outside the item tables; ignoring its items";
+        segment.collectibleCount = 0;
+        segment.obstacleCount = 0;
+    }
+    return segment;
+}
+
+CompiledItem CompiledLevel::collectible(int index) const
+{
+    CompiledItem item;
+    std::memcpy(&item, m_data + m_header.collectibleTableOffset + quint64(index) * sizeof(CompiledItem), sizeof(item));
+    return item;
+}
+
+CompiledItem CompiledLevel::obstacle(int index) const
+{
+    CompiledItem item;
+    std::memcpy(&item, m_data + m_header.obstacleTableOffset + quint64(index) * sizeof(CompiledItem), sizeof(item));
+    return item;
+}
+
+TrackSegmentData CompiledLevel::segmentData(int index) const
+{
+    const CompiledSegment compiled = segment(index);
+    TrackSegmentData data;
+    data.centerX = compiled.centerX;
+    data.centerY = compiled.centerY;
+    data.radius = compiled.radius;
+    data.tangentAngleDegrees = compiled.tangentAngleDegrees;
+    data.collectibles.resize(compiled.collectibleCount);
+    for (quint32 i = 0; i < compiled.collectibleCount; ++i) {
+        const CompiledItem item = collectible(static_cast<int>(compiled.firstCollectible + i));
+        data.collectibles[i].angleDegrees = item.angleDegrees;
+        data.collectibles[i].radialOffset = item.radialOffset;
+    }
+    data.obstacles.resize(compiled.obstacleCount);
+    for (quint32 i = 0; i < compiled.obstacleCount; ++i) {
+        const CompiledItem item = obstacle(static_cast<int>(compiled.firstObstacle + i));
+        data.obstacles[i].angleDegrees = item.angleDegrees;
+        data.obstacles[i].radialOffset = item.radialOffset;
+    }
+    return data;
+}
+
+void CompiledLevel::appendSegments(int first, int count, TrackData* level) const
+{
+    first = qBound(0, first, segmentCount());
+    count = qBound(0, count, segmentCount() - first);
+    level->segments.reserve(level->segments.size() + count);
+    for (int i = first; i < first + count; ++i) {
+        level->segments.push_back(segmentData(i));
+    }
+}
+
+SceneryData CompiledLevel::sceneryData(int index) const
+{
+    CompiledScenery compiled;
+    std::memcpy(&compiled, m_data + m_header.sceneryTableOffset + quint64(index) * sizeof(CompiledScenery), sizeof(compiled));
+    SceneryData data;
+    data.x = compiled.x;
+    data.y = compiled.y;
+    data.width = compiled.width;
+    data.height = compiled.height;
+    data.z = compiled.z;
+    if (quint64(compiled.imageOffset) + compiled.imageLength > m_header.stringTableSize) {
+        qWarning() << "CompiledLevel: scenery" << index << "references a path outside the string table";
+    } else {
+        data.image = QString::fromUtf8(reinterpret_cast<const char*>(m_data + m_header.stringTableOffset + compiled.imageOffset),
+                                       static_cast<int>(compiled.imageLength));
+    }
+    return data;
+}
+
+EndTriggerData CompiledLevel::endTrigger() const
+{
+    EndTriggerData endTrigger;
+    endTrigger.x = m_header.endTriggerX;
+    endTrigger.y = m_header.endTriggerY;
+    endTrigger.radius = m_header.endTriggerRadius;
+    return endTrigger;
+}
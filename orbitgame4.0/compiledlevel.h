@@ -0,0 +1,119 @@
+#ifndef COMPILEDLEVEL_H
+#define COMPILEDLEVEL_H
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#include "trackdata.h"
+
+// ==========================================================================
+// CompiledLevel: 关卡的二进制格式（.orbl），由 orbitlevelcompiler 从关卡 JSON 生成。
+// 全部是定长表（装饰的图片路径放在末尾的字符串区，按偏移引用），不需要解析：打开时只把文件映射到内存并检查文件头，
+// 之后按索引直接读表项，因此打开的耗时和内存与关卡大小无关（一百万条轨道也一样）。
+//
+// 文件布局（小端，各表按 8 字节对齐）:
+//   CompiledLevelHeader       文件头，见下（含通关点）
+//   CompiledSegment[segmentCount]         轨道表，每条轨道记录自己在物品表中的区间
+//   CompiledItem[collectibleCount]        收集品表，按轨道顺序连续存放
+//   CompiledItem[obstacleCount]           障碍物表，按轨道顺序连续存放
+//   CompiledScenery[sceneryCount]         装饰表
+//   char[stringTableSize]                 装饰的图片路径（UTF-8，不带结尾的 0）
+// ==========================================================================
+
+const char COMPILED_LEVEL_MAGIC[4] = {'O', 'R', 'B', 'L'};
+const quint32 COMPILED_LEVEL_VERSION = 2; // 2: 加入装饰表和通关点
+
+struct CompiledLevelHeader {
+    char magic[4];                 // COMPILED_LEVEL_MAGIC
+    quint32 version;               // COMPILED_LEVEL_VERSION
+    quint32 segmentCount;
+    quint32 collectibleCount;
+    quint32 obstacleCount;
+    quint32 sceneryCount;
+    quint64 segmentTableOffset;    // 各表相对文件开头的字节偏移
+    quint64 collectibleTableOffset;
+    quint64 obstacleTableOffset;
+    quint64 sceneryTableOffset;
+    quint64 stringTableOffset;
+    quint64 stringTableSize;
+    double endTriggerX;            // 通关点，半径 <= 0 表示没有
+    double endTriggerY;
+    double endTriggerRadius;
+};
+
+struct CompiledSegment {
+    double centerX;
+    double centerY;
+    double radius;
+    double tangentAngleDegrees;
+    quint32 firstCollectible;      // 在收集品表中的起点
+    quint32 collectibleCount;
+    quint32 firstObstacle;         // 在障碍物表中的起点
+    quint32 obstacleCount;
+};
+
+struct CompiledItem {
+    double angleDegrees;
+    double radialOffset;
+};
+
+struct CompiledScenery {
+    double x;
+    double y;
+    double width;
+    double height;
+    double z;
+    quint32 imageOffset;           // 图片路径在字符串区中的区间
+    quint32 imageLength;
+};
+
+static_assert(sizeof(CompiledLevelHeader) == 96, "CompiledLevelHeader layout is part of the file format");
+static_assert(sizeof(CompiledSegment) == 48, "CompiledSegment layout is part of the file format");
+static_assert(sizeof(CompiledItem) == 16, "CompiledItem layout is part of the file format");
+static_assert(sizeof(CompiledScenery) == 48, "CompiledScenery layout is part of the file format");
+
+class CompiledLevel
+{
+public:
+    CompiledLevel();
+    ~CompiledLevel();
+
+    // 把 TrackData 编译成 .orbl 文件内容
+    static QByteArray compile(const TrackData& level);
+
+    // 映射并检查文件头。资源文件被压缩等无法映射的情况下退回到整体读入
+    bool open(const QString& path, QString* errorString = nullptr);
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+
+    int segmentCount() const { return static_cast<int>(m_header.segmentCount); }
+    int collectibleCount() const { return static_cast<int>(m_header.collectibleCount); }
+    int obstacleCount() const { return static_cast<int>(m_header.obstacleCount); }
+    int sceneryCount() const { return static_cast<int>(m_header.sceneryCount); }
+
+    // 按索引读表项（映射的数据不保证对齐，这里按值拷出）。
+    // 轨道引用的物品区间越界时视为没有物品，并给出警告
+    CompiledSegment segment(int index) const;
+    CompiledItem collectible(int index) const;
+    CompiledItem obstacle(int index) const;
+    // 把一条轨道展开成 TrackSegmentData
+    TrackSegmentData segmentData(int index) const;
+    // 把 [first, first + count) 的轨道追加到 level
+    void appendSegments(int first, int count, TrackData* level) const;
+    // 装饰（路径越界时图片为空，并给出警告）
+    SceneryData sceneryData(int index) const;
+    EndTriggerData endTrigger() const;
+
+private:
+    bool fail(const QString& message, QString* errorString);
+
+    QFile m_file;
+    QByteArray m_buffer;     // 无法映射时的后备存储
+    const uchar* m_data;     // 映射（或 m_buffer）的起点
+    qint64 m_size;
+    CompiledLevelHeader m_header;
+};
+
+#endif // COMPILEDLEVEL_H
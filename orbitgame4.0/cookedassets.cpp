@@ -0,0 +1,45 @@
+// 文件: cookedassets.cpp
+#include "cookedassets.h"
+#include "levelpack.h"
+#include "orbitsimulation.h"
+#include <QFileInfo>
+
+QString cookedAssetPath(const QString& source, const QSize& size, int scale)
+{
+    if (!source.startsWith(":/") || !size.isValid()) return QString();
+    const QFileInfo info(source.mid(2));
+    QString directory = info.path();
+    directory = (directory == ".") ? QString() : directory + '/';
+    const QString suffix = (scale > 1) ? QString("@%1x").arg(scale) : QString();
+    return QString("%1%2%3@%4x%5%6.png").arg(QString(COOKED_ASSET_PREFIX), directory, info.completeBaseName())
+        .arg(size.width()).arg(size.height()).arg(suffix);
+}
+
+std::vector<CookedAsset> fixedSizeSprites()
+{
+    const int spaceshipSize = static_cast<int>(2.0 * BALL_RADIUS);
+    const int collectibleSize = static_cast<int>(DEFAULT_COLLECTIBLE_TARGET_SIZE);
+    const int obstacleSize = static_cast<int>(DEFAULT_OBSTACLE_TARGET_SIZE);
+    return {
+        { ":/images/spaceship.png", QSize(spaceshipSize, spaceshipSize) },
+        { ":/images/collectible.png", QSize(collectibleSize, collectibleSize) },
+        { ":/images/obstacle.png", QSize(obstacleSize, obstacleSize) },
+    };
+}
+
+bool appendLevelPackScenery(const LevelPack& pack, std::vector<CookedAsset>* assets, QString* errorString)
+{
+    for (int i = 0; i < pack.levelCount(); ++i) {
+        const LevelPackEntry& entry = pack.level(i);
+        TrackData level;
+        if (!level.loadLevelFromFile(entry.file)) {
+            if (errorString) *errorString = QString("cannot load level %1 from %2").arg(entry.id, entry.file);
+            return false;
+        }
+        for (const SceneryData& scenery : level.scenery) {
+            // 与 GameScene::updateScenery 请求的尺寸一致
+            assets->push_back({ scenery.image, QSize(qRound(scenery.width), qRound(scenery.height)) });
+        }
+    }
+    return true;
+}
@@ -0,0 +1,39 @@
+#ifndef COOKEDASSETS_H
+#define COOKEDASSETS_H
+
+#include <vector>
+#include <QSize>
+#include <QString>
+
+class LevelPack;
+
+// ==========================================================================
+// 烘焙资源: 游戏里按固定尺寸显示的贴图（飞船、物品、关卡装饰）在构建时由 orbitassetcooker
+// 预先缩放成显示尺寸，打包成 cooked/cooked.qrc（资源前缀 /cooked）。
+// 运行时 AssetRegistry 先找烘焙好的版本，找到就直接解码，不再做平滑缩放；找不到才退回原图。
+// 烘焙是 orbitgame2.pro 的构建步骤（QMAKE_EXTRA_COMPILERS），关卡包、关卡文件或原图变了会重新烘焙。
+// 程序里只有烘焙好的小图；原图 (sprites.qrc) 构建为外部资源包 sprites.rcc，只在请求了没烘焙过的尺寸时读取。
+// ==========================================================================
+
+const char* const COOKED_ASSET_PREFIX = ":/cooked/";
+// 每个尺寸另外烘焙一份 2 倍像素的版本 (...@2x.png)，渲染比例（设备像素比 × 视图缩放）大于 1 时使用，
+// 高 DPI 屏上不再是放大的位图
+const int COOKED_HIDPI_SCALE = 2;
+
+struct CookedAsset {
+    QString source; // 游戏里使用的资源路径，如 ":/images/sun.png"
+    QSize size;     // 显示尺寸（保持比例缩放到这个范围以内）
+};
+
+// source 缩放到 size 后的烘焙资源路径，如 ":/cooked/images/sun@450x450.png"；
+// scale 为 COOKED_HIDPI_SCALE 时是 2 倍像素的版本 ":/cooked/images/sun@450x450@2x.png"。
+// source 不是资源路径 (":/" 开头) 或 size 无效时返回空字符串
+QString cookedAssetPath(const QString& source, const QSize& size, int scale = 1);
+
+// 游戏里固定尺寸的贴图，尺寸与 GameScene / CollectibleItem / ObstacleItem 请求的一致
+std::vector<CookedAsset> fixedSizeSprites();
+
+// 关卡包里所有关卡的装饰（按关卡 JSON 读取）。读不了的关卡写入 errorString 并返回 false
+bool appendLevelPackScenery(const LevelPack& pack, std::vector<CookedAsset>* assets, QString* errorString = nullptr);
+
+#endif // COOKEDASSETS_H
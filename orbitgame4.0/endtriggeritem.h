@@ -5,7 +5,7 @@
 #include <QBrush>
 #include <QPen>
 
-const qreal DEFAULT_END_POINT_RADIUS = 5.0; // 默认通关点半径
+#include "orbitsimulation.h" // DEFAULT_END_POINT_RADIUS（通关判定在 OrbitSimulation 中按半径计算）
 
 class EndTriggerItem : public QGraphicsEllipseItem
 {
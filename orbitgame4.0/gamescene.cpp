@@ -5,10 +5,10 @@
 #include "obstacleitem.h"
 #include "gameoverdisplay.h"
 #include "endtriggeritem.h" // 包含 EndTriggerItem
+#include "assetregistry.h"
 #include <QGraphicsView>
 #include <QKeyEvent>
 #include <QFont>
-#include <QFontDatabase>
 #include <QRandomGenerator>
 #include <QJsonDocument>
 #include <QJsonArray>
@@ -18,20 +18,40 @@
 #include <QtMath>
 #include <QGraphicsPixmapItem>
 #include <QMovie>
+#include <QStandardPaths>
+#include <QDir>
+#include <QDateTime>
 #include <QGraphicsEllipseItem>
 #include <QtGlobal> // For QT_VERSION_CHECK
+#include <limits>
 
 // --- 游戏常量 ---
-const qreal ANGLE_TOP = 3 * M_PI / 2.0;
-const qreal ANGLE_BOTTOM = M_PI / 2.0;
-// END_POINT_RADIUS 在 endtriggeritem.h 中定义为 DEFAULT_END_POINT_RADIUS
-// 其他常量如 BALL_RADIUS, ORBIT_PADDING 等应在 gamescene.h 中定义
-// 假设这些常量已在 gamescene.h 或其他地方定义
+// ANGLE_TOP, ANGLE_BOTTOM, BALL_RADIUS, TRACK_COLLISION_EFFECTIVE_RADIUS_FACTOR 等规则常量
+// 已移到 orbitsimulation.h, 由 OrbitSimulation 统一使用
+// 碰撞半径 (DEFAULT_COLLECTIBLE_TARGET_SIZE, DEFAULT_END_POINT_RADIUS 等) 也在 orbitsimulation.h 中，
+// 碰撞按半径解析计算（orbitcollision.h），场景图元只负责显示
 
-// 轨道碰撞有效半径调整因子。值小于1.0会减少轨道间碰撞的敏感度，1.0为原始行为。
-// 值越小，飞船需要更深入地“侵入”其他轨道的范围才会判定为碰撞。
-const qreal TRACK_COLLISION_EFFECTIVE_RADIUS_FACTOR = 0.8; // 您可以调整此值 (例如 0.8, 0.9, 0.7等)
+namespace {
 
+const char* const EXPLOSION_ANIMATION_PATH = ":/animations/explosion.gif";
+const char* const COLLECT_EFFECT_ANIMATION_PATH = ":/animations/collect_effect.gif";
+
+QSize squareSize(qreal diameter)
+{
+    return QSize(static_cast<int>(diameter), static_cast<int>(diameter));
+}
+
+QSize explosionFrameSize()
+{
+    return squareSize(EXPLOSION_EFFECT_SIZE_MULTIPLIER * BALL_RADIUS);
+}
+
+QSize collectEffectFrameSize()
+{
+    return squareSize(DEFAULT_COLLECTIBLE_TARGET_SIZE * DEFAULT_COLLECTIBLE_EFFECT_SIZE_MULTIPLIER);
+}
+
+} // namespace
 
 GameScene::GameScene(QObject *parent)
     : QGraphicsScene(parent),
@@ -40,27 +60,16 @@ GameScene::GameScene(QObject *parent)
     m_targetBrush(Qt::gray),
     m_targetPen(Qt::NoPen),
     m_gameOver(true),
-    m_currentTrackIndex(0),
-    m_currentAngle(ANGLE_BOTTOM),
-    m_orbitOffset(BALL_RADIUS + ORBIT_PADDING),
-    m_canTakeDamage(true),
-    m_linearSpeed(BASE_LINEAR_SPEED),
-    m_rotationDirection(1),
-    m_score(0),
-    m_speedLevel(0),
-    m_maxHealth(10z), // 假设最大生命值为3
-    m_health(m_maxHealth),
+    m_gamePrepared(false),
+    m_previousSimState(),
+    m_lastFrameNsecs(0),
+    m_stepAccumulator(0),
+    m_replaySaved(true),
+    m_inputClockOffsetMsecs(0),
+    m_inputClockSynced(false),
     m_ball(nullptr),
     m_targetDot(nullptr),
-    m_sunItem(nullptr),
-    m_mercuryItem(nullptr),
-    m_venusItem(nullptr),
-    m_earthItem(nullptr),
-    m_marsItem(nullptr),
-    m_jupiterItem(nullptr),
-    m_saturnItem(nullptr),
-    m_uranusItem(nullptr),
-    m_neptuneItem(nullptr),
+    m_pendingSceneryCount(0),
     m_healthText(nullptr),
     m_judgmentText(nullptr),
     m_endTriggerPoint(nullptr),
@@ -68,7 +77,15 @@ GameScene::GameScene(QObject *parent)
     m_gameOverDisplay(nullptr),
     m_timer(new QTimer(this)),
     m_judgmentTimer(new QTimer(this)),
-    m_damageCooldownTimer(new QTimer(this)),
+    m_streamingLevel(false),
+    m_windowFirstTrack(0),
+    m_windowFirstCollectible(0),
+    m_windowFirstObstacle(0),
+    m_endlessMode(false),
+    m_endlessSeed(0),
+    m_currentLevel(0),
+    m_levelWatcher(nullptr),
+    m_levelReloadTimer(nullptr),
     m_explosionMovie(nullptr),
     m_collectEffectMovie(nullptr),
     m_explosionDurationTimer(nullptr),
@@ -83,7 +100,7 @@ GameScene::GameScene(QObject *parent)
     setSceneRect(-2000, -2000, 4000, 4000);
 
     // --- 背景初始化 ---
-    m_backgroundTilePixmap.load(":/images/background.png");
+    m_backgroundTilePixmap = AssetRegistry::instance()->pixmap(":/images/background.png");
     if (m_backgroundTilePixmap.isNull()) {
         qWarning() << "Failed to load background tile image: :/images/background.png. Infinite background will not work.";
         setBackgroundBrush(Qt::darkGray);
@@ -103,17 +120,25 @@ GameScene::GameScene(QObject *parent)
         }
     }
 
+    m_timer->setTimerType(Qt::PreciseTimer); // 默认的 CoarseTimer 误差可达 5%
     connect(m_timer, &QTimer::timeout, this, &GameScene::updateGame);
     m_judgmentTimer->setSingleShot(true);
     connect(m_judgmentTimer, &QTimer::timeout, this, &GameScene::hideJudgmentText);
-    m_damageCooldownTimer->setSingleShot(true);
-    connect(m_damageCooldownTimer, &QTimer::timeout, this, &GameScene::enableDamageTaking);
+    m_levelReloadTimer = new QTimer(this);
+    m_levelReloadTimer->setSingleShot(true);
+    m_levelReloadTimer->setInterval(LEVEL_HOT_RELOAD_DELAY_MS);
+    connect(m_levelReloadTimer, &QTimer::timeout, this, &GameScene::reloadWatchedLevel);
+    connect(AssetRegistry::instance(), &AssetRegistry::renderScaleChanged, this, &GameScene::refreshSprites);
+
+    if (!m_levelPack.loadManifest(DEFAULT_LEVEL_PACK_PATH)) {
+        m_levelPack.setBuiltInLevels();
+    }
 
     // --- 背景音乐设置 ---
     m_backgroundMusicPlayer = new QMediaPlayer(this);
     m_audioOutput = new QAudioOutput(this);
     m_backgroundMusicPlayer->setAudioOutput(m_audioOutput);
-    m_backgroundMusicPlayer->setSource(QUrl("qrc:/music/softmusic.mp3"));
+    m_backgroundMusicPlayer->setSource(AssetRegistry::mediaUrl(":/music/softmusic.mp3")); // 外部媒体包，见 registerMediaBundle
     m_backgroundMusicPlayer->setLoops(QMediaPlayer::Infinite);
     m_audioOutput->setVolume(0.5); // Qt6: setVolume takes float 0.0-1.0
     connect(m_backgroundMusicPlayer, &QMediaPlayer::mediaStatusChanged, this,
@@ -131,7 +156,7 @@ GameScene::GameScene(QObject *parent)
 
 
     // --- 动画 QMovie 和相关 Timer 初始化 ---
-    m_explosionMovie = new QMovie(":/animations/explosion.gif", QByteArray(), this);
+    m_explosionMovie = new QMovie(EXPLOSION_ANIMATION_PATH, QByteArray(), this);
     if (!m_explosionMovie->isValid()) {
         qWarning() << "Failed to load explosion GIF: :/animations/explosion.gif";
     }
@@ -141,7 +166,7 @@ GameScene::GameScene(QObject *parent)
     m_explosionDurationTimer->setSingleShot(true);
     connect(m_explosionDurationTimer, &QTimer::timeout, this, &GameScene::forceHideExplosion);
 
-    m_collectEffectMovie = new QMovie(":/animations/collect_effect.gif", QByteArray(), this);
+    m_collectEffectMovie = new QMovie(COLLECT_EFFECT_ANIMATION_PATH, QByteArray(), this);
     if (!m_collectEffectMovie->isValid()) {
         qWarning() << "Failed to load collect effect GIF: :/animations/collect_effect.gif";
     }
@@ -151,7 +176,7 @@ GameScene::GameScene(QObject *parent)
     m_collectEffectDurationTimer->setSingleShot(true);
     connect(m_collectEffectDurationTimer, &QTimer::timeout, this, &GameScene::forceHideCollectEffect);
 
-    initializeGame();
+    // 关卡、物品和 HUD 在 initializeGame 时才创建（MainWindow::startGameplay），构造时不加载关卡
 }
 
 GameScene::~GameScene()
@@ -168,6 +193,8 @@ GameScene::~GameScene()
 
 void GameScene::clearAllCollectibles()
 {
+    m_collectibles.append(m_collectiblePool);
+    m_collectiblePool.clear();
     for (CollectibleItem* collectible : m_collectibles) {
         if (collectible) {
             if (collectible->scene() == this) {
@@ -181,6 +208,8 @@ void GameScene::clearAllCollectibles()
 
 void GameScene::clearAllObstacles()
 {
+    m_obstacles.append(m_obstaclePool);
+    m_obstaclePool.clear();
     for (ObstacleItem* obstacle : m_obstacles) {
         if (obstacle) {
             if (obstacle->scene() == this) {
@@ -198,6 +227,8 @@ void GameScene::clearAllGameItems() {
 
     qDeleteAll(m_trackItems); // Deletes all QGraphicsEllipseItem* in the list
     m_trackItems.clear();
+    qDeleteAll(m_trackItemPool);
+    m_trackItemPool.clear();
 
     if (m_ball && m_ball->scene() == this) { removeItem(m_ball); delete m_ball; m_ball = nullptr; }
     if (m_targetDot && m_targetDot->scene() == this) { removeItem(m_targetDot); delete m_targetDot; m_targetDot = nullptr; }
@@ -208,16 +239,7 @@ void GameScene::clearAllGameItems() {
         m_endTriggerPoint = nullptr;
     }
 
-    // Planet items
-    if (m_sunItem && m_sunItem->scene() == this) { removeItem(m_sunItem); delete m_sunItem; m_sunItem = nullptr; }
-    if (m_mercuryItem && m_mercuryItem->scene() == this) { removeItem(m_mercuryItem); delete m_mercuryItem; m_mercuryItem = nullptr; }
-    if (m_venusItem && m_venusItem->scene() == this) { removeItem(m_venusItem); delete m_venusItem; m_venusItem = nullptr; }
-    if (m_earthItem && m_earthItem->scene() == this) { removeItem(m_earthItem); delete m_earthItem; m_earthItem = nullptr; }
-    if (m_marsItem && m_marsItem->scene() == this) { removeItem(m_marsItem); delete m_marsItem; m_marsItem = nullptr; }
-    if (m_jupiterItem && m_jupiterItem->scene() == this) { removeItem(m_jupiterItem); delete m_jupiterItem; m_jupiterItem = nullptr; }
-    if (m_saturnItem && m_saturnItem->scene() == this) { removeItem(m_saturnItem); delete m_saturnItem; m_saturnItem = nullptr; }
-    if (m_uranusItem && m_uranusItem->scene() == this) { removeItem(m_uranusItem); delete m_uranusItem; m_uranusItem = nullptr; }
-    if (m_neptuneItem && m_neptuneItem->scene() == this) { removeItem(m_neptuneItem); delete m_neptuneItem; m_neptuneItem = nullptr; }
+    clearScenery();
 
     // Text items
     if (m_healthText && m_healthText->scene() == this) { removeItem(m_healthText); delete m_healthText; m_healthText = nullptr; }
@@ -231,11 +253,16 @@ void GameScene::clearAllGameItems() {
 
 
 void GameScene::initializeGame()
+{
+    prepareGame();
+    startGame();
+}
+
+void GameScene::prepareGame()
 {
     // Stop all timers and animations
     if (m_timer->isActive()) m_timer->stop();
     if (m_judgmentTimer->isActive()) m_judgmentTimer->stop();
-    if (m_damageCooldownTimer->isActive()) m_damageCooldownTimer->stop();
     if (m_explosionMovie && m_explosionMovie->state() == QMovie::Running) m_explosionMovie->stop();
     if (m_collectEffectMovie && m_collectEffectMovie->state() == QMovie::Running) m_collectEffectMovie->stop();
     if (m_explosionDurationTimer && m_explosionDurationTimer->isActive()) m_explosionDurationTimer->stop();
@@ -243,32 +270,12 @@ void GameScene::initializeGame()
 
     clearAllGameItems(); // Clear existing items
 
-    // Reset game state variables
+    // Reset game state variables (track/angle/health/score are reset by m_simulation when the level loads)
     m_gameOver = false;
-    m_currentTrackIndex = 0;
-    m_currentAngle = ANGLE_BOTTOM; // Start at the bottom of the first track
-    m_orbitOffset = (BALL_RADIUS + ORBIT_PADDING); // Start on the outer orbit
-    m_canTakeDamage = true;
-    m_health = m_maxHealth;
-    m_score = 0;
-    m_speedLevel = 0;
-    m_linearSpeed = BASE_LINEAR_SPEED;
-    m_rotationDirection = 1; // Initial rotation direction (e.g., counter-clockwise)
-
-    // Font loading
-    int englishFontId = QFontDatabase::addApplicationFont(":/fonts/MyEnglishFont.ttf");
-    if (englishFontId != -1) {
-        QStringList fontFamilies = QFontDatabase::applicationFontFamilies(englishFontId);
-        if (!fontFamilies.isEmpty()) { m_englishFontFamily = fontFamilies.at(0); qDebug() << "Custom English font loaded:" << m_englishFontFamily; }
-        else { qWarning() << "Failed to retrieve font family name for English font at :/fonts/MyEnglishFont.ttf. Using default:" << m_englishFontFamily; }
-    } else { qWarning() << "Failed to load custom English font from :/fonts/MyEnglishFont.ttf. Using default:" << m_englishFontFamily; }
-
-    int chineseFontId = QFontDatabase::addApplicationFont(":/fonts/MyChineseFont.ttf");
-    if (chineseFontId != -1) {
-        QStringList fontFamilies = QFontDatabase::applicationFontFamilies(chineseFontId);
-        if (!fontFamilies.isEmpty()) { m_chineseFontFamily = fontFamilies.at(0); qDebug() << "Custom Chinese font loaded:" << m_chineseFontFamily; }
-        else { qWarning() << "Failed to retrieve font family name for Chinese font at :/fonts/MyChineseFont.ttf. Using default:" << m_chineseFontFamily; }
-    } else { qWarning() << "Failed to load custom Chinese font from :/fonts/MyChineseFont.ttf. Using default:" << m_chineseFontFamily; }
+
+    // Font loading: AssetRegistry 只在第一次 addApplicationFont，重开一局不会再注册一遍字体
+    m_englishFontFamily = AssetRegistry::instance()->fontFamily(ENGLISH_FONT_PATH, DEFAULT_ENGLISH_FONT_FAMILY);
+    m_chineseFontFamily = AssetRegistry::instance()->fontFamily(CHINESE_FONT_PATH, DEFAULT_CHINESE_FONT_FAMILY);
 
 
     // Game Over Display
@@ -283,7 +290,11 @@ void GameScene::initializeGame()
 
 
     // Load level data
-    if (!loadLevelData(":/levels/level1.json")) {
+    // 关卡包里的当前关，优先使用编译好的版本（直接映射，不需要解析 JSON）；热重载时用磁盘上的 JSON
+    const QString levelPath = !m_hotReloadPath.isEmpty() ? m_hotReloadPath
+                                                         : m_levelPack.level(m_currentLevel).preferredFile();
+    qDebug() << "Loading level" << m_currentLevel << m_levelPack.level(m_currentLevel).name << "from" << levelPath;
+    if (!loadLevelData(levelPath)) {
         qCritical() << "Failed to load level data. Game cannot start.";
         m_gameOver = true; // Set game over if level loading fails
         QPointF centerPos = sceneRect().center();
@@ -294,118 +305,33 @@ void GameScene::initializeGame()
         } else { // Fallback if GameOverDisplay is still null for some reason
             QGraphicsTextItem* errorText = new QGraphicsTextItem(
                 QString("<p align='center'><span style=\"font-family: '%1'; font-size: 18pt; font-weight: bold; color: red;\">错误: 无法加载关卡数据!</span><br/>"
-                        "<span style=\"font-family: '%1'; font-size: 18pt; font-weight: bold; color: red;\">请检查文件 </span><span style=\"font-family: '%2'; font-size: 18pt; font-weight: bold; color: red;\">:/levels/level1.json</span></p>")
-                    .arg(m_chineseFontFamily).arg(m_englishFontFamily));
+                        "<span style=\"font-family: '%1'; font-size: 18pt; font-weight: bold; color: red;\">请检查文件 </span><span style=\"font-family: '%2'; font-size: 18pt; font-weight: bold; color: red;\">%3</span></p>")
+                    .arg(m_chineseFontFamily).arg(m_englishFontFamily).arg(levelPath));
             addItem(errorText);
             errorText->setPos(centerPos - QPointF(errorText->boundingRect().width()/2, errorText->boundingRect().height()/2));
             errorText->setZValue(5.0); // Ensure it's on top
         }
+        m_gamePrepared = true; // startGame 不会再重试，错误信息留在画面上
         return; // Stop initialization
     }
 
-    // --- 创建通关触发点 ---
-    if (!m_levelData.segments.empty()) {
-        // 使用 EndTriggerItem 类创建实例
-        // 假设 DEFAULT_END_POINT_RADIUS 在 endtriggeritem.h 中定义
-        m_endTriggerPoint = new EndTriggerItem(0, -16913, DEFAULT_END_POINT_RADIUS); // 示例坐标和半径
-        m_endTriggerPoint->setZValue(0.7); // 确保它在轨道之上，但在飞船之下或同层，以便碰撞
-        addItem(m_endTriggerPoint);
-        m_endTriggerPoint->setVisible(true); // Make sure it's visible
-        qDebug() << "EndTriggerItem created at scene pos (center): (0, -16913) with radius" << DEFAULT_END_POINT_RADIUS;
-    } else {
-        qDebug() << "Skipping end trigger point creation as no level data was loaded.";
+    // 当前关加载好了，趁玩家在玩的时候在后台准备下一关
+    if (!m_endlessMode && m_hotReloadPath.isEmpty() && m_currentLevel + 1 < m_levelPack.levelCount()) {
+        m_levelPrefetcher.prefetch(m_levelPack.level(m_currentLevel + 1).preferredFile(), LEVEL_STREAM_TRACKS_AHEAD + 1);
     }
 
+    // --- 创建通关触发点（位置写在关卡文件里）---
+    setupEndTrigger();
 
-    // --- 创建和定位太阳及行星 ---
-    if (!m_levelData.segments.empty()) {
-        QPixmap originalSunPixmap(":/images/sun.png");
-        if (originalSunPixmap.isNull()) { qWarning() << "Failed to load sun image: :/images/sun.png"; }
-        else {
-            const int sunTargetWidth = 450; const int sunTargetHeight = 450;
-            QPixmap scaledSunPixmap = originalSunPixmap.scaled(sunTargetWidth, sunTargetHeight, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-            m_sunItem = new QGraphicsPixmapItem(scaledSunPixmap);
-            const TrackSegmentData& firstTrack = m_levelData.segments[0];
-            qreal sunX = firstTrack.centerX - m_sunItem->boundingRect().width() / 2.0;
-            qreal sunY = firstTrack.centerY - m_sunItem->boundingRect().height() / 2.0;
-            m_sunItem->setPos(sunX, sunY);
-            m_sunItem->setZValue(-0.5); addItem(m_sunItem); m_sunItem->setVisible(true);
-        }
-    }
-    const qreal planetBaseX = 0; const qreal planetZValue = -0.5;
-    QPixmap originalMercuryPixmap(":/images/mercury.png");
-    if (!originalMercuryPixmap.isNull()) {
-        const int mercuryTargetWidth = 120; const int mercuryTargetHeight = 120;
-        QPixmap scaledMercuryPixmap = originalMercuryPixmap.scaled(mercuryTargetWidth, mercuryTargetHeight, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        m_mercuryItem = new QGraphicsPixmapItem(scaledMercuryPixmap);
-        m_mercuryItem->setPos(planetBaseX - scaledMercuryPixmap.width() / 2.0, -1330 - scaledMercuryPixmap.height() / 2.0);
-        m_mercuryItem->setZValue(planetZValue); addItem(m_mercuryItem); m_mercuryItem->setVisible(true);
-    } else { qWarning() << "Failed to load mercury image: :/images/mercury.png"; }
-
-    QPixmap originalVenusPixmap(":/images/venus.png");
-    if (!originalVenusPixmap.isNull()) {
-        const int venusTargetWidth = 150; const int venusTargetHeight = 150;
-        QPixmap scaledVenusPixmap = originalVenusPixmap.scaled(venusTargetWidth, venusTargetHeight, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        m_venusItem = new QGraphicsPixmapItem(scaledVenusPixmap);
-        m_venusItem->setPos(planetBaseX - scaledVenusPixmap.width() / 2.0, -2428 - scaledVenusPixmap.height() / 2.0);
-        m_venusItem->setZValue(planetZValue); addItem(m_venusItem); m_venusItem->setVisible(true);
-    } else { qWarning() << "Failed to load venus image: :/images/venus.png"; }
-
-    QPixmap originalEarthPixmap(":/images/earth.png");
-    if (!originalEarthPixmap.isNull()) {
-        const int earthTargetWidth = 170; const int earthTargetHeight = 170;
-        QPixmap scaledEarthPixmap = originalEarthPixmap.scaled(earthTargetWidth, earthTargetHeight, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        m_earthItem = new QGraphicsPixmapItem(scaledEarthPixmap);
-        m_earthItem->setPos(planetBaseX - scaledEarthPixmap.width() / 2.0, -3610 - scaledEarthPixmap.height() / 2.0);
-        m_earthItem->setZValue(planetZValue); addItem(m_earthItem); m_earthItem->setVisible(true);
-    } else { qWarning() << "Failed to load earth image: :/images/earth.png"; }
-
-    QPixmap originalMarsPixmap(":/images/mars.png");
-    if (!originalMarsPixmap.isNull()) {
-        const int marsTargetWidth = 130; const int marsTargetHeight = 130;
-        QPixmap scaledMarsPixmap = originalMarsPixmap.scaled(marsTargetWidth, marsTargetHeight, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        m_marsItem = new QGraphicsPixmapItem(scaledMarsPixmap);
-        m_marsItem->setPos(planetBaseX - scaledMarsPixmap.width() / 2.0, -5592 - scaledMarsPixmap.height() / 2.0);
-        m_marsItem->setZValue(planetZValue); addItem(m_marsItem); m_marsItem->setVisible(true);
-    } else { qWarning() << "Failed to load mars image: :/images/mars.png"; }
-
-    QPixmap originalJupiterPixmap(":/images/jupiter.png");
-    if (!originalJupiterPixmap.isNull()) {
-        const int jupiterTargetWidth = 370; const int jupiterTargetHeight = 370;
-        QPixmap scaledJupiterPixmap = originalJupiterPixmap.scaled(jupiterTargetWidth, jupiterTargetHeight, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        m_jupiterItem = new QGraphicsPixmapItem(scaledJupiterPixmap);
-        m_jupiterItem->setPos(planetBaseX - scaledJupiterPixmap.width() / 2.0,-8148 - scaledJupiterPixmap.height() / 2.0);
-        m_jupiterItem->setZValue(planetZValue); addItem(m_jupiterItem); m_jupiterItem->setVisible(true);
-    } else { qWarning() << "Failed to load jupiter image: :/images/jupiter.png"; }
-
-    QPixmap originalSaturnPixmap(":/images/saturn.png");
-    if (!originalSaturnPixmap.isNull()) {
-        const int saturnTargetWidth = 330; const int saturnTargetHeight = 240; // Adjusted for Saturn's shape
-        QPixmap scaledSaturnPixmap = originalSaturnPixmap.scaled(saturnTargetWidth, saturnTargetHeight, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        m_saturnItem = new QGraphicsPixmapItem(scaledSaturnPixmap);
-        m_saturnItem->setPos(planetBaseX - scaledSaturnPixmap.width() / 2.0, -10908- scaledSaturnPixmap.height() / 2.0);
-        m_saturnItem->setZValue(planetZValue); addItem(m_saturnItem); m_saturnItem->setVisible(true);
-    } else { qWarning() << "Failed to load saturn image: :/images/saturn.png"; }
-
-    QPixmap originalUranusPixmap(":/images/uranus.png");
-    if (!originalUranusPixmap.isNull()) {
-        const int uranusTargetWidth = 275; const int uranusTargetHeight = 275;
-        QPixmap scaledUranusPixmap = originalUranusPixmap.scaled(uranusTargetWidth, uranusTargetHeight, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        m_uranusItem = new QGraphicsPixmapItem(scaledUranusPixmap);
-        m_uranusItem->setPos(planetBaseX - scaledUranusPixmap.width() / 2.0, -13718- scaledUranusPixmap.height() / 2.0);
-        m_uranusItem->setZValue(planetZValue); addItem(m_uranusItem); m_uranusItem->setVisible(true);
-    } else { qWarning() << "Failed to load uranus image: :/images/uranus.png"; }
-
-    QPixmap originalNeptunePixmap(":/images/neptune.png");
-    if (!originalNeptunePixmap.isNull()) {
-        const int neptuneTargetWidth = 250; const int neptuneTargetHeight = 250;
-        QPixmap scaledNeptunePixmap = originalNeptunePixmap.scaled(neptuneTargetWidth, neptuneTargetHeight, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        m_neptuneItem = new QGraphicsPixmapItem(scaledNeptunePixmap);
-        m_neptuneItem->setPos(planetBaseX - scaledNeptunePixmap.width() / 2.0, -16688 - scaledNeptunePixmap.height() / 2.0); // Near end trigger
-        m_neptuneItem->setZValue(planetZValue); addItem(m_neptuneItem); m_neptuneItem->setVisible(true);
-    } else { qWarning() << "Failed to load neptune image: :/images/neptune.png"; }
+    // 新的一局从空白录像开始；关卡指纹在保存录像时计算（流式关卡不在内存里，要逐条读一遍）
+    m_replay.clear();
+    m_replaySaved = false;
 
 
+    // --- 装饰（太阳及行星等，由关卡文件描述）---
+    // 这里只登记位置，图片在镜头接近时才由 updateScenery 加载
+    setupScenery();
+
     // Adjust sceneRect to encompass all tracks and major elements
     if (!m_levelData.segments.empty()) {
         const TrackSegmentData& firstSegment = m_levelData.segments.front();
@@ -415,12 +341,12 @@ void GameScene::initializeGame()
             QRectF segmentRect(segment.centerX - segment.radius, segment.centerY - segment.radius, 2 * segment.radius, 2 * segment.radius);
             totalTracksRect = totalTracksRect.united(segmentRect);
         }
-        // Include planets in scene rect calculation if they exist
-        qreal padding = 200.0; // Padding around the content
-        if (m_neptuneItem) { // Furthest planet
-            totalTracksRect = totalTracksRect.united(m_neptuneItem->sceneBoundingRect().adjusted(-padding, -padding, padding, padding));
-        } else if (m_sunItem) { // Or sun if no planets
-            totalTracksRect = totalTracksRect.united(m_sunItem->sceneBoundingRect().adjusted(-padding, -padding, padding, padding));
+        // Include scenery in scene rect calculation (按关卡里写的尺寸，不需要加载图片)
+        // (流式加载时这里只有驻留的轨道，之后加载的轨道由 updateLevelWindow 并入)
+        qreal padding = SCENE_RECT_PADDING; // Padding around the content
+        for (const SceneryData& scenery : m_levelData.scenery) {
+            QRectF sceneryRect(scenery.x - scenery.width / 2.0, scenery.y - scenery.height / 2.0, scenery.width, scenery.height);
+            totalTracksRect = totalTracksRect.united(sceneryRect.adjusted(-padding, -padding, padding, padding));
         }
         totalTracksRect.adjust(-padding, -padding, padding, padding); // General padding
         setSceneRect(totalTracksRect);
@@ -431,8 +357,8 @@ void GameScene::initializeGame()
 
     // Create game items (ball, target dot, etc.)
     if (!m_levelData.segments.empty()) { // Only create ball if there are tracks
-        QPixmap originalSpaceshipPixmap(":/images/spaceship.png");
-        if (originalSpaceshipPixmap.isNull()) {
+        QPixmap scaledSpaceship = AssetRegistry::instance()->pixmap(":/images/spaceship.png", squareSize(2.0 * BALL_RADIUS));
+        if (scaledSpaceship.isNull()) {
             qWarning() << "Failed to load spaceship image. Using fallback blue circle.";
             // Fallback: create a simple blue circle if image fails
             QPixmap fallbackPixmap(static_cast<int>(2*BALL_RADIUS), static_cast<int>(2*BALL_RADIUS));
@@ -444,10 +370,9 @@ void GameScene::initializeGame()
             painter.end();
             m_ball = new QGraphicsPixmapItem(fallbackPixmap);
         } else {
-            qreal targetDiameter = 2.0 * BALL_RADIUS;
-            QPixmap scaledSpaceship = originalSpaceshipPixmap.scaled(static_cast<int>(targetDiameter), static_cast<int>(targetDiameter), Qt::KeepAspectRatio, Qt::SmoothTransformation);
             m_ball = new QGraphicsPixmapItem(scaledSpaceship);
         }
+        m_ball->setShapeMode(QGraphicsPixmapItem::BoundingRectShape); // 碰撞由 OrbitSimulation 按半径计算，不需要从透明度遮罩生成形状
         m_ball->setZValue(1.0); // Ensure ball is above tracks
         addItem(m_ball);
         m_ball->setTransformOriginPoint(m_ball->boundingRect().center()); // For rotation
@@ -500,7 +425,17 @@ void GameScene::initializeGame()
     if(m_ball) updateBallPosition(); // Position ball on the first track
     if(m_targetDot) updateTargetDotPosition(); // Position target dot
     updateHealthDisplay();
-    updateScoreDisplayAndSpeed();
+    updateScoreDisplay();
+
+    m_gamePrepared = true;
+    qDebug() << "Game prepared (timer not started yet).";
+}
+
+void GameScene::startGame()
+{
+    if (!m_gamePrepared) prepareGame();
+    m_gamePrepared = false; // 下一局要重新准备
+    if (m_gameOver) return; // 关卡加载失败
 
     // Ensure view is focused and background is updated
     if (!views().isEmpty()) {
@@ -514,48 +449,50 @@ void GameScene::initializeGame()
             m_backgroundMusicPlayer->playbackState() != QMediaPlayer::PlayingState) {
             // Timer not checked here, music should play if game is initialized and not over
             m_backgroundMusicPlayer->play();
-            qDebug() << "Music play attempt in initializeGame (after setup).";
+            qDebug() << "Music play attempt in startGame (after setup).";
         }
     }
 
-    m_timer->start(16); // Approx 60 FPS
+    // Restart the fixed-timestep clock so time spent loading is not simulated
+    m_previousSimState = m_simulation.state();
+    m_stepAccumulator = 0;
+    m_frameClock.start();
+    m_lastFrameNsecs = 0;
+    m_inputClockSynced = false;
+    m_timer->start(FRAME_INTERVAL_MS); // Approx 60 FPS
     qDebug() << "Game initialized and timer started.";
+
+    if (isOnLastLevel()) emit lastLevelStarted(); // 让 MainWindow 趁这一关提前准备结束视频
 }
 
 
 void GameScene::updateHealthDisplay() {
     if (m_healthText) {
+        const int health = m_simulation.state().health;
         QString healthColorName = "darkGreen"; // Default color for good health
-        if (m_health <= 0) healthColorName = "darkRed"; // Critical health or game over
-        else if (m_health <= m_maxHealth * 0.3) healthColorName = "red"; // Low health
-        else if (m_health <= m_maxHealth * 0.6) healthColorName = "orange"; // Medium health
+        if (health <= 0) healthColorName = "darkRed"; // Critical health or game over
+        else if (health <= MAX_HEALTH * 0.3) healthColorName = "red"; // Low health
+        else if (health <= MAX_HEALTH * 0.6) healthColorName = "orange"; // Medium health
 
         // Using HTML for rich text formatting
         QString htmlText = QString("<span style=\"font-family: '%1'; font-size: 50pt; font-weight: bold; color: %3;\">生命: </span>"
                                    "<span style=\"font-family: '%2'; font-size: 60pt; font-weight: bold; color: %3;\">%4 / %5</span>")
                                .arg(m_chineseFontFamily).arg(m_chineseFontFamily) // Font for "生命" and numbers
                                .arg(healthColorName) // Color based on health
-                               .arg(m_health).arg(m_maxHealth);
+                               .arg(health).arg(MAX_HEALTH);
         m_healthText->setHtml(htmlText);
     }
 }
 
-void GameScene::updateScoreDisplayAndSpeed() {
+void GameScene::updateScoreDisplay() {
     if (m_scoreText) {
         QString htmlText = QString("<span style=\"font-family: '%1'; font-size: 50pt; font-weight: bold; color: white;\">分数: </span>"
                                    "<span style=\"font-family: '%2'; font-size: 60pt; font-weight: bold; color: white;\">%3</span>")
                                .arg(m_chineseFontFamily).arg(m_chineseFontFamily) // Font for "分数" and numbers
-                               .arg(m_score);
+                               .arg(m_simulation.state().score);
         m_scoreText->setHtml(htmlText);
     }
-
-    // Speed up logic
-    int targetLevel = m_score / SCORE_THRESHOLD_FOR_SPEEDUP;
-    if (targetLevel > m_speedLevel) {
-        m_speedLevel = targetLevel;
-        m_linearSpeed = BASE_LINEAR_SPEED * qPow(SPEEDUP_FACTOR, m_speedLevel);
-        qDebug() << "Speed increased! Level:" << m_speedLevel << "Speed:" << m_linearSpeed;
-    }
+    // 提速逻辑在 OrbitSimulation::addScore 中
 }
 
 void GameScene::keyPressEvent(QKeyEvent *event)
@@ -574,110 +511,22 @@ void GameScene::keyPressEvent(QKeyEvent *event)
     }
 
     if (event->key() == Qt::Key_K && !event->isAutoRepeat()) {
-        // Check if it's possible to switch to the next track
-        if (static_cast<size_t>(m_currentTrackIndex + 1) >= m_levelData.segments.size()) {
+        if (m_simulation.state().trackIndex + 1 >= m_simulation.trackCount()) {
             qDebug() << "[KeyPress K] Already on the last track or no next track. Cannot switch.";
             event->accept(); // Consume the event
             return;
         }
-
-        const TrackSegmentData& currentSegment = m_levelData.segments[m_currentTrackIndex];
-        qreal effectiveBallRadiusOnTrack = currentSegment.radius + m_orbitOffset;
-        if (effectiveBallRadiusOnTrack < BALL_RADIUS) effectiveBallRadiusOnTrack = BALL_RADIUS; // Prevent division by zero or too small radius
-
-        // Calculate angle difference from the target (top of the circle)
-        qreal angleDiff = m_currentAngle - ANGLE_TOP;
-        // Normalize angle difference to be within -PI to PI
-        while (angleDiff <= -M_PI) angleDiff += 2.0 * M_PI;
-        while (angleDiff > M_PI) angleDiff -= 2.0 * M_PI;
-
-        qreal absAngleDiff = qAbs(angleDiff);
-
-        // Calculate angular speed for tolerance calculation
-        qreal angularSpeed = (effectiveBallRadiusOnTrack > 0.01) ? (m_linearSpeed / effectiveBallRadiusOnTrack) : 0;
-
-        // Tolerances (convert from milliseconds to radians based on angular speed)
-        qreal perfectAngleTolerance = angularSpeed * (PERFECT_MS / 1000.0);
-        qreal goodAngleTolerance = angularSpeed * (GOOD_MS / 1000.0);
-
-        QString judgmentTextStrKey;
-        QString judgmentTextColorName;
-        bool success = false;
-        int scoreGainedThisHit = 0;
-
-        if (absAngleDiff <= perfectAngleTolerance) {
-            qDebug() << "[KeyPress K] JUDGMENT: PERFECT! Current health:" << m_health << "Can take damage:" << m_canTakeDamage;
-            judgmentTextStrKey = "PERFECT!";
-            judgmentTextColorName = "yellow"; // Or some QColor
-            success = true;
-            scoreGainedThisHit = SCORE_PERFECT;
-        } else if (absAngleDiff <= goodAngleTolerance) {
-            qDebug() << "[KeyPress K] JUDGMENT: GOOD! Current health:" << m_health << "Can take damage:" << m_canTakeDamage;
-            judgmentTextStrKey = "GOOD!";
-            judgmentTextColorName = "cyan"; // Or some QColor
-            success = true;
-            scoreGainedThisHit = SCORE_GOOD;
-        } else { // Miss
-            qDebug() << "[KeyPress K] JUDGMENT: MISS! Current health BEFORE deduction:" << m_health << "Can take damage:" << m_canTakeDamage;
-            m_health--;
-            qDebug() << "[KeyPress K] JUDGMENT: MISS! Current health AFTER deduction:" << m_health;
-            updateHealthDisplay();
-            triggerExplosionEffect(); // Show explosion on miss
-            if (m_health <= 0) {
-                endGame();
-                event->accept();
-                return;
-            }
-        }
-
-        // Display judgment text
-        if (!judgmentTextStrKey.isEmpty() && m_judgmentText) {
-            QString htmlText = QString("<span style=\"font-family: '%1'; font-size: 50pt; font-weight: bold; color: %2;\">%3</span>")
-            .arg(m_englishFontFamily).arg(judgmentTextColorName).arg(judgmentTextStrKey);
-            m_judgmentText->setHtml(htmlText);
-            m_judgmentText->setVisible(true);
-
-            // Position judgment text (e.g., above target dot or center of view)
-            QPointF textPos;
-            if (m_targetDot && m_targetDot->isVisible()) {
-                QPointF targetDotCenter = m_targetDot->sceneBoundingRect().center();
-                QRectF judgmentRect = m_judgmentText->boundingRect();
-                textPos = targetDotCenter - QPointF(judgmentRect.width() / 2.0, judgmentRect.height() + TARGET_DOT_RADIUS + 15);
-            } else if (!views().isEmpty()) {
-                QRectF viewRect = views().first()->mapToScene(views().first()->viewport()->geometry()).boundingRect();
-                QRectF judgmentRect = m_judgmentText->boundingRect();
-                textPos = viewRect.center() - QPointF(judgmentRect.width() / 2.0, judgmentRect.height() / 2.0 + 60); // Offset from center
-            } else {
-                // Fallback position if no view or target dot
-                textPos = QPointF(-m_judgmentText->boundingRect().width() / 2.0, -60);
-            }
-            m_judgmentText->setPos(textPos);
-            m_judgmentTimer->start(500); // Hide after 0.5 seconds
-        }
-
-        if (success) {
-            qDebug() << "[KeyPress K] SUCCESS: About to switch track. Health:" << m_health << "Can take damage:" << m_canTakeDamage;
-            m_score += scoreGainedThisHit;
-            updateScoreDisplayAndSpeed();
-            switchTrack(); // Switch to the next track
-            qDebug() << "[KeyPress K] SUCCESS: Switched track. Health:" << m_health << "Can take damage:" << m_canTakeDamage;
-
-            // ***** MODIFIED LOGIC: Post-switch invulnerability *****
-            if (m_damageCooldownTimer) { // Ensure timer is valid
-                m_canTakeDamage = false; // Player cannot take damage immediately after switch
-                m_damageCooldownTimer->start(DAMAGE_COOLDOWN_MS); // Use existing cooldown duration
-                qDebug() << "[KeyPress K] SUCCESS: Post-switch invulnerability activated for" << DAMAGE_COOLDOWN_MS << "ms. m_canTakeDamage:" << m_canTakeDamage;
-            }
-            // ***** MODIFIED LOGIC END *****
-        }
-        event->accept();
+        // 判定与切换轨道的规则都在 OrbitSimulation 中。按键按它自己的时间戳排队，
+        // 在下一次 step() 中于该时刻判定，而不是按上一帧的角度判定
+        queueRecordedInput(OrbitInput::SwitchTrack, event);
+        processSimulationEvents(); // Presses older than the last step are judged immediately
+        event->accept(); // Consume the event
         return;
     }
     else if (event->key() == Qt::Key_J && !event->isAutoRepeat()) {
         // Switch orbit (inner/outer)
-        m_orbitOffset = -m_orbitOffset; // Toggle sign
-        qDebug() << "[KeyPress J] Orbit switched. New m_orbitOffset:" << m_orbitOffset;
-        updateBallPosition(); // Update ball position based on new orbit
+        queueRecordedInput(OrbitInput::SwitchOrbit, event);
+        processSimulationEvents();
         event->accept();
         return;
     }
@@ -685,15 +534,176 @@ void GameScene::keyPressEvent(QKeyEvent *event)
     QGraphicsScene::keyPressEvent(event); // Pass to base class if not handled
 }
 
+qreal GameScene::simulationTimeForEvent(const QInputEvent* event)
+{
+    const qint64 nowNsecs = m_frameClock.nsecsElapsed();
+    // Simulation time that corresponds to "now": what was simulated, what is still in the accumulator,
+    // and what has elapsed since the last frame
+    const qreal simTimeNow = m_simulation.state().time + m_stepAccumulator + (nowNsecs - m_lastFrameNsecs) / 1e9;
+
+    if (!event || event->timestamp() == 0) {
+        return simTimeNow; // Platform gives no timestamp, fall back to the delivery time
+    }
+
+    // An event can't be delivered before it was generated, so the largest (timestamp - now)
+    // seen so far is the closest estimate of the offset between the two clocks.
+    const qint64 offsetMsecs = static_cast<qint64>(event->timestamp()) - nowNsecs / 1000000;
+    if (!m_inputClockSynced || offsetMsecs > m_inputClockOffsetMsecs) {
+        m_inputClockOffsetMsecs = offsetMsecs;
+        m_inputClockSynced = true;
+    }
+    qreal eventAgeSeconds = (m_inputClockOffsetMsecs - offsetMsecs) / 1000.0;
+    if (eventAgeSeconds > MAX_FRAME_SECONDS) eventAgeSeconds = MAX_FRAME_SECONDS; // Don't rewind across a stall
+    return simTimeNow - eventAgeSeconds;
+}
+
+void GameScene::queueRecordedInput(OrbitInput input, const QInputEvent* event)
+{
+    // 先取整到微秒再排队，回放时使用的就是完全相同的时间
+    const qreal inputTime = OrbitReplay::quantize(simulationTimeForEvent(event));
+    m_replay.addInput(input, inputTime, m_simulation.state().time);
+    m_simulation.queueInput(input, inputTime);
+}
+
+void GameScene::saveReplay()
+{
+    if (m_replaySaved) return;
+    m_replaySaved = true;
+    if (m_endlessMode) {
+        // 无尽模式的轨道取决于生成时的速度等级，没有可以校验的关卡文件
+        qDebug() << "Endless run (seed" << m_endlessSeed << ") is not saved as a replay.";
+        return;
+    }
+    m_replay.durationMicros = OrbitReplay::toMicros(m_simulation.state().time);
+    m_replay.levelHash = currentLevelHash();
+
+    const QString dirPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/replays";
+    if (!QDir().mkpath(dirPath)) {
+        qWarning() << "Failed to create replay directory:" << dirPath;
+        return;
+    }
+    const QString filePath = dirPath + "/replay-" + QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss") + ".orr";
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to save replay:" << filePath << "Error:" << file.errorString();
+        return;
+    }
+    file.write(m_replay.encode());
+    file.close();
+    qDebug() << "Replay saved to" << filePath << "(" << m_replay.inputs.size() << "inputs, score" << m_simulation.state().score << ")";
+}
+
+void GameScene::showJudgmentText(OrbitJudgment judgment)
+{
+    QString judgmentTextStrKey;
+    QString judgmentTextColorName;
+    if (judgment == OrbitJudgment::Perfect) {
+        judgmentTextStrKey = "PERFECT!";
+        judgmentTextColorName = "yellow"; // Or some QColor
+    } else if (judgment == OrbitJudgment::Good) {
+        judgmentTextStrKey = "GOOD!";
+        judgmentTextColorName = "cyan"; // Or some QColor
+    }
+
+    // Display judgment text
+    if (!judgmentTextStrKey.isEmpty() && m_judgmentText) {
+        QString htmlText = QString("<span style=\"font-family: '%1'; font-size: 50pt; font-weight: bold; color: %2;\">%3</span>")
+        .arg(m_englishFontFamily).arg(judgmentTextColorName).arg(judgmentTextStrKey);
+        m_judgmentText->setHtml(htmlText);
+        m_judgmentText->setVisible(true);
+
+        // Position judgment text (e.g., above target dot or center of view)
+        QPointF textPos;
+        if (m_targetDot && m_targetDot->isVisible()) {
+            QPointF targetDotCenter = m_targetDot->sceneBoundingRect().center();
+            QRectF judgmentRect = m_judgmentText->boundingRect();
+            textPos = targetDotCenter - QPointF(judgmentRect.width() / 2.0, judgmentRect.height() + TARGET_DOT_RADIUS + 15);
+        } else if (!views().isEmpty()) {
+            QRectF viewRect = views().first()->mapToScene(views().first()->viewport()->geometry()).boundingRect();
+            QRectF judgmentRect = m_judgmentText->boundingRect();
+            textPos = viewRect.center() - QPointF(judgmentRect.width() / 2.0, judgmentRect.height() / 2.0 + 60); // Offset from center
+        } else {
+            // Fallback position if no view or target dot
+            textPos = QPointF(-m_judgmentText->boundingRect().width() / 2.0, -60);
+        }
+        m_judgmentText->setPos(textPos);
+        m_judgmentTimer->start(500); // Hide after 0.5 seconds
+    }
+}
+
+void GameScene::processSimulationEvents()
+{
+    const std::vector<OrbitSimEvent> events = m_simulation.takeEvents();
+    for (const OrbitSimEvent& simEvent : events) {
+        switch (simEvent.type) {
+        case OrbitSimEvent::Judgment:
+            if (simEvent.judgment == OrbitJudgment::Miss) {
+                qDebug() << "[KeyPress K] JUDGMENT: MISS! Current health AFTER deduction:" << m_simulation.state().health;
+                updateHealthDisplay();
+                triggerExplosionEffect(); // Show explosion on miss
+            } else {
+                qDebug() << "[KeyPress K] JUDGMENT:" << (simEvent.judgment == OrbitJudgment::Perfect ? "PERFECT!" : "GOOD!")
+                         << "Score:" << m_simulation.state().score;
+                showJudgmentText(simEvent.judgment);
+                updateScoreDisplay();
+            }
+            break;
+        case OrbitSimEvent::CollectibleCollected: {
+            const int index = simEvent.index - m_windowFirstCollectible; // 事件使用整关编号
+            if (index >= 0 && index < m_collectibles.size() && m_collectibles[index]) {
+                m_collectibles[index]->collect(); // Plays sound and emits collectedSignal
+            }
+            break;
+        }
+        case OrbitSimEvent::ObstacleHit: {
+            const int index = simEvent.index - m_windowFirstObstacle;
+            if (index >= 0 && index < m_obstacles.size() && m_obstacles[index]) {
+                m_obstacles[index]->processHit(); // Plays sound and emits hitSignal
+            }
+            break;
+        }
+        case OrbitSimEvent::TrackCollision:
+            qDebug() << "[TrackCollision] Occurred! Current track:" << m_simulation.state().trackIndex
+                     << " Collided with track:" << simEvent.index
+                     << " Health AFTER deduction:" << m_simulation.state().health;
+            updateHealthDisplay();
+            triggerExplosionEffect(); // Show visual feedback
+            updateBallPosition();     // Ball was forced to the inner orbit
+            break;
+        case OrbitSimEvent::TrackSwitched:
+            qDebug() << "[SwitchTrack] Switched to track:" << simEvent.index
+                     << " New RotationDir:" << m_simulation.state().rotationDirection;
+            m_previousSimState = m_simulation.state(); // Don't interpolate across a track switch
+            updateLevelWindow();       // Load the tracks ahead, drop the ones behind
+            updateTargetDotPosition(); // Update target dot for the new track
+            updateBallPosition();      // Update ball position immediately for the new track and angle
+            break;
+        case OrbitSimEvent::OrbitSwitched:
+            qDebug() << "[KeyPress J] Orbit switched. New orbitOffset:" << m_simulation.state().orbitOffset;
+            updateBallPosition(); // Update ball position based on new orbit
+            break;
+        case OrbitSimEvent::SpeedUp:
+            qDebug() << "Speed increased! Level:" << simEvent.index << "Speed:" << m_simulation.state().linearSpeed;
+            break;
+        case OrbitSimEvent::GameOver:
+            endGame();
+            break;
+        case OrbitSimEvent::LevelCompleted:
+            handleLevelCompleted();
+            break;
+        }
+    }
+}
+
 void GameScene::endGame() {
     if(m_gameOver) return; // Already ended
     m_gameOver = true;
-    qDebug() << "Game Over. Final Score:" << m_score << "Reason: Health depleted or level completed without video trigger.";
+    qDebug() << "Game Over. Final Score:" << m_simulation.state().score << "Reason: Health depleted or level completed without video trigger.";
+    saveReplay();
 
     // Stop game timer and other relevant timers/animations
     if (m_timer->isActive()) m_timer->stop();
     if (m_judgmentTimer->isActive()) m_judgmentTimer->stop();
-    if (m_damageCooldownTimer->isActive()) m_damageCooldownTimer->stop();
 
     if (m_explosionMovie && m_explosionMovie->state() == QMovie::Running) m_explosionMovie->stop();
     if (m_explosionItem) m_explosionItem->setVisible(false);
@@ -732,7 +742,7 @@ void GameScene::endGame() {
         } else {
             centerPosOfView = sceneRect().center(); // Fallback if no view
         }
-        m_gameOverDisplay->showScreen(m_score, centerPosOfView);
+        m_gameOverDisplay->showScreen(m_simulation.state().score, centerPosOfView);
     } else {
         qWarning() << "m_gameOverDisplay is null in endGame! Cannot show game over screen.";
     }
@@ -741,11 +751,44 @@ void GameScene::endGame() {
 bool GameScene::loadLevelData(const QString& filename)
 {
     m_levelData.segments.clear(); // Clear previous data
+    m_levelData.scenery.clear();
+    m_levelData.endTrigger = EndTriggerData(); // 无尽模式没有通关点
     qDeleteAll(m_trackItems);     // Delete old QGraphicsPathItem objects
     m_trackItems.clear();         // Clear the list
-
-    // Use TrackData class to load from JSON
-    if (!m_levelData.loadLevelFromFile(filename)) {
+    m_compiledLevel.reset();
+    m_streamingLevel = false;
+    m_windowFirstTrack = 0;
+    m_windowFirstCollectible = 0;
+    m_windowFirstObstacle = 0;
+
+    // 后台预读过这个文件时直接用结果（JSON 已经解析好；.orbl 已经映射并拷出了第一段窗口）
+    PreparedLevel prepared;
+    const bool prefetched = !m_endlessMode && m_levelPrefetcher.take(filename, &prepared);
+
+    if (m_endlessMode) {
+        // 无尽模式：轨道由种子生成，与编译好的关卡一样按窗口加载
+        m_streamingLevel = true;
+        m_trackGenerator.reset(m_endlessSeed);
+        for (int i = 0; i <= LEVEL_STREAM_TRACKS_AHEAD; ++i) {
+            m_levelData.segments.push_back(m_trackGenerator.next(0));
+        }
+        qDebug() << "GameScene: Endless mode with seed" << m_endlessSeed;
+    } else if (filename.endsWith(".orbl")) {
+        // 编译好的关卡：映射后按窗口逐条拷出，不做任何解析；其余轨道留在映射里，走到附近时再加载。
+        // 没有预读（第一关、重开）时在这里同步做同样的准备
+        if (!prefetched) prepared = LevelPrefetcher::prepare(filename, LEVEL_STREAM_TRACKS_AHEAD + 1);
+        if (!prepared.ok) {
+            qCritical() << "GameScene: Failed to open compiled level:" << filename;
+            return false;
+        }
+        m_compiledLevel = std::move(prepared.compiled);
+        m_levelData = std::move(prepared.level);
+        m_streamingLevel = true;
+        if (prefetched) qDebug() << "GameScene: Using the level prepared in the background:" << filename;
+    } else if (prefetched) {
+        m_levelData = std::move(prepared.level);
+        qDebug() << "GameScene: Using the level prepared in the background:" << filename;
+    } else if (!m_levelData.loadLevelFromFile(filename)) { // JSON 关卡反正要整体解析，全部驻留
         qCritical() << "GameScene: Failed to load level data using TrackData class from file:" << filename;
         return false;
     }
@@ -757,29 +800,307 @@ bool GameScene::loadLevelData(const QString& filename)
 
     // Create visual track items and game objects (collectibles, obstacles)
     for (size_t i = 0; i < m_levelData.segments.size(); ++i) {
-        const TrackSegmentData& segmentData = m_levelData.segments[i];
-        addTrackItem(segmentData); // Create the visual track ellipse
-
-        // Create collectibles for this segment
-        for (const CollectibleData& cData : segmentData.collectibles) {
-            CollectibleItem *item = new CollectibleItem(static_cast<int>(i), qDegreesToRadians(cData.angleDegrees));
-            item->setOrbitOffset(cData.radialOffset); // Set its specific offset from the track's radius
-            connect(item, &CollectibleItem::collectedSignal, this, &GameScene::handleCollectibleCollected);
-            m_collectibles.append(item);
-            // addItem(item); // Will be added and positioned in positionAndShowCollectibles
+        addSegmentItems(m_levelData.segments[i], static_cast<int>(i));
+    }
+
+    // 规则层使用同一份驻留数据，收集品/障碍物的编号与 m_collectibles/m_obstacles 的顺序一致
+    m_simulation.loadLevelWindow(m_levelData, 0, 0, 0, levelTrackCount());
+    qDebug() << "GameScene: Successfully processed" << m_levelData.segments.size() << "of" << levelTrackCount()
+             << "segments" << (m_streamingLevel ? "(streaming)." : "from TrackData.");
+    return true;
+}
+
+void GameScene::addSegmentItems(const TrackSegmentData& segmentData, int trackIndex)
+{
+    addTrackItem(segmentData); // Create the visual track ellipse
+
+    // Create collectibles for this segment (reusing evicted ones first)
+    for (const CollectibleData& cData : segmentData.collectibles) {
+        m_collectibles.append(takeCollectibleItem(trackIndex, cData));
+        // addItem(item); // Will be added and positioned in positionAndShowCollectibles
+    }
+
+    // Create obstacles for this segment
+    for (const ObstacleData& oData : segmentData.obstacles) {
+        m_obstacles.append(takeObstacleItem(trackIndex, oData));
+        // addItem(item); // Will be added and positioned in positionAndShowObstacles
+    }
+}
+
+CollectibleItem* GameScene::takeCollectibleItem(int trackIndex, const CollectibleData& data)
+{
+    CollectibleItem *item;
+    if (!m_collectiblePool.isEmpty()) {
+        item = m_collectiblePool.takeLast();
+        item->reuse(trackIndex, qDegreesToRadians(data.angleDegrees));
+    } else {
+        item = new CollectibleItem(trackIndex, qDegreesToRadians(data.angleDegrees));
+        connect(item, &CollectibleItem::collectedSignal, this, &GameScene::handleCollectibleCollected);
+    }
+    item->setOrbitOffset(data.radialOffset); // Set its specific offset from the track's radius
+    return item;
+}
+
+ObstacleItem* GameScene::takeObstacleItem(int trackIndex, const ObstacleData& data)
+{
+    ObstacleItem *item;
+    if (!m_obstaclePool.isEmpty()) {
+        item = m_obstaclePool.takeLast();
+        item->reuse(trackIndex, qDegreesToRadians(data.angleDegrees));
+    } else {
+        item = new ObstacleItem(trackIndex, qDegreesToRadians(data.angleDegrees));
+        connect(item, &ObstacleItem::hitSignal, this, &GameScene::handleObstacleHit);
+    }
+    item->setOrbitOffset(data.radialOffset); // Set its specific offset
+    return item;
+}
+
+void GameScene::updateLevelWindow()
+{
+    if (!m_streamingLevel) return;
+
+    const int trackIndex = m_simulation.state().trackIndex;
+    const int first = qMax(0, trackIndex - LEVEL_STREAM_TRACKS_BEHIND);
+    const int end = qMin(levelTrackCount(), trackIndex + LEVEL_STREAM_TRACKS_AHEAD + 1);
+    bool changed = false;
+
+    // 丢弃身后的轨道（cleanupOldTracks）
+    const int evictCount = qBound(0, first - m_windowFirstTrack, static_cast<int>(m_levelData.segments.size()));
+    if (evictCount > 0) {
+        int collectibleCount = 0;
+        int obstacleCount = 0;
+        for (int i = 0; i < evictCount; ++i) {
+            collectibleCount += static_cast<int>(m_levelData.segments[i].collectibles.size());
+            obstacleCount += static_cast<int>(m_levelData.segments[i].obstacles.size());
+        }
+        // 图元只是隐藏后放回池中，加载前方轨道时复用
+        for (int i = 0; i < evictCount && !m_trackItems.isEmpty(); ++i) {
+            QGraphicsEllipseItem* trackItem = m_trackItems.takeFirst();
+            trackItem->setVisible(false);
+            m_trackItemPool.append(trackItem);
+        }
+        for (int i = 0; i < collectibleCount && !m_collectibles.isEmpty(); ++i) {
+            CollectibleItem* collectible = m_collectibles.takeFirst();
+            collectible->setVisible(false);
+            m_collectiblePool.append(collectible);
+        }
+        for (int i = 0; i < obstacleCount && !m_obstacles.isEmpty(); ++i) {
+            ObstacleItem* obstacle = m_obstacles.takeFirst();
+            obstacle->setVisible(false);
+            m_obstaclePool.append(obstacle);
         }
+        m_levelData.segments.erase(m_levelData.segments.begin(), m_levelData.segments.begin() + evictCount);
+        m_windowFirstTrack += evictCount;
+        m_windowFirstCollectible += collectibleCount;
+        m_windowFirstObstacle += obstacleCount;
+        changed = true;
+    }
 
-        // Create obstacles for this segment
-        for (const ObstacleData& oData : segmentData.obstacles) {
-            ObstacleItem *item = new ObstacleItem(static_cast<int>(i), qDegreesToRadians(oData.angleDegrees));
-            item->setOrbitOffset(oData.radialOffset); // Set its specific offset
-            connect(item, &ObstacleItem::hitSignal, this, &GameScene::handleObstacleHit);
-            m_obstacles.append(item);
-            // addItem(item); // Will be added and positioned in positionAndShowObstacles
+    // 加载前方的轨道（generateNextTrack），场景范围随之扩大，镜头才能跟过去
+    QRectF loadedRect;
+    for (int i = m_windowFirstTrack + static_cast<int>(m_levelData.segments.size()); i < end; ++i) {
+        m_levelData.segments.push_back(streamedSegment(i));
+        const TrackSegmentData& segmentData = m_levelData.segments.back();
+        addSegmentItems(segmentData, i);
+        loadedRect = loadedRect.united(QRectF(segmentData.centerX - segmentData.radius, segmentData.centerY - segmentData.radius,
+                                              2 * segmentData.radius, 2 * segmentData.radius));
+        changed = true;
+    }
+    if (!changed) return;
+
+    if (m_endlessMode) {
+        // 无尽模式没有尽头，场景范围只覆盖驻留的轨道，跟着窗口移动
+        QRectF residentRect;
+        for (const TrackSegmentData& segment : m_levelData.segments) {
+            residentRect = residentRect.united(QRectF(segment.centerX - segment.radius, segment.centerY - segment.radius,
+                                                      2 * segment.radius, 2 * segment.radius));
         }
+        setSceneRect(residentRect.adjusted(-SCENE_RECT_PADDING, -SCENE_RECT_PADDING, SCENE_RECT_PADDING, SCENE_RECT_PADDING));
+    } else if (!loadedRect.isNull()) {
+        setSceneRect(sceneRect().united(loadedRect.adjusted(-SCENE_RECT_PADDING, -SCENE_RECT_PADDING,
+                                                            SCENE_RECT_PADDING, SCENE_RECT_PADDING)));
     }
-    qDebug() << "GameScene: Successfully processed" << m_levelData.segments.size() << "segments from TrackData.";
-    return true;
+    positionAndShowCollectibles();
+    positionAndShowObstacles();
+    m_simulation.setLevelWindow(m_levelData, m_windowFirstTrack, m_windowFirstCollectible, m_windowFirstObstacle,
+                                levelTrackCount());
+    qDebug() << "[LevelStream] Resident tracks" << m_windowFirstTrack << "to"
+             << m_windowFirstTrack + static_cast<int>(m_levelData.segments.size()) - 1 << "of" << levelTrackCount();
+}
+
+int GameScene::levelTrackCount() const
+{
+    if (m_endlessMode) return std::numeric_limits<int>::max(); // 没有最后一条轨道
+    return m_streamingLevel ? m_compiledLevel->segmentCount() : static_cast<int>(m_levelData.segments.size());
+}
+
+TrackSegmentData GameScene::streamedSegment(int trackIndex)
+{
+    if (m_endlessMode) {
+        // 窗口只会向前加载，请求的总是生成器的下一条轨道；难度取当前的速度等级
+        return m_trackGenerator.next(m_simulation.state().speedLevel);
+    }
+    return m_compiledLevel->segmentData(trackIndex);
+}
+
+void GameScene::setCurrentLevel(int index)
+{
+    const int level = qBound(0, index, m_levelPack.levelCount() - 1);
+    if (level != m_currentLevel) m_gamePrepared = false;
+    m_currentLevel = level;
+}
+
+void GameScene::setEndlessMode(bool endless, quint32 seed)
+{
+    if (endless != m_endlessMode || (endless && seed != m_endlessSeed)) m_gamePrepared = false;
+    m_endlessMode = endless;
+    m_endlessSeed = seed;
+}
+
+bool GameScene::isOnLastLevel() const
+{
+    return !m_endlessMode && m_hotReloadPath.isEmpty() && m_currentLevel + 1 >= m_levelPack.levelCount();
+}
+
+void GameScene::refreshSprites()
+{
+    // 只有矢量贴图会随渲染比例变化；位图拿到的还是同一份缓存，重新 setPixmap 也没有代价
+    AssetRegistry* registry = AssetRegistry::instance();
+    if (m_ball) {
+        const QPixmap spaceship = registry->pixmap(":/images/spaceship.png", squareSize(2.0 * BALL_RADIUS));
+        if (!spaceship.isNull()) {
+            m_ball->setPixmap(spaceship);
+            m_ball->setTransformOriginPoint(m_ball->boundingRect().center());
+        }
+    }
+    for (CollectibleItem* collectible : std::as_const(m_collectibles)) collectible->refreshPixmap();
+    for (CollectibleItem* collectible : std::as_const(m_collectiblePool)) collectible->refreshPixmap();
+    for (ObstacleItem* obstacle : std::as_const(m_obstacles)) obstacle->refreshPixmap();
+    for (ObstacleItem* obstacle : std::as_const(m_obstaclePool)) obstacle->refreshPixmap();
+    for (SceneryEntry& entry : m_scenery) {
+        if (!entry.item || !entry.item->isVisible()) continue; // 还没加载或加载失败的占位
+        const SceneryData& scenery = entry.data;
+        const QPixmap scaledPixmap = registry->pixmap(scenery.image, QSize(qRound(scenery.width), qRound(scenery.height)));
+        if (scaledPixmap.isNull()) continue;
+        const QSizeF logicalSize = scaledPixmap.deviceIndependentSize();
+        entry.item->setPixmap(scaledPixmap);
+        entry.item->setPos(scenery.x - logicalSize.width() / 2.0, scenery.y - logicalSize.height() / 2.0);
+    }
+    qDebug() << "GameScene: Sprites refreshed for render scale" << registry->renderScale();
+}
+
+void GameScene::preloadAssets()
+{
+    AssetRegistry* registry = AssetRegistry::instance();
+    // 与 initializeGame / 物品构造函数 / 动画播放时请求的尺寸完全一致，否则缓存对不上
+    registry->preload(":/images/spaceship.png", squareSize(2.0 * BALL_RADIUS));
+    registry->preload(":/images/collectible.png", squareSize(DEFAULT_COLLECTIBLE_TARGET_SIZE));
+    registry->preload(":/images/obstacle.png", squareSize(DEFAULT_OBSTACLE_TARGET_SIZE));
+    registry->preloadFrames(EXPLOSION_ANIMATION_PATH, explosionFrameSize());
+    registry->preloadFrames(COLLECT_EFFECT_ANIMATION_PATH, collectEffectFrameSize());
+
+    // 当前关卡的装饰。编译好的关卡只需映射后读出装饰表；JSON 关卡（热重载）不在这里解析，装饰照常按镜头加载
+    const QString levelPath = m_hotReloadPath.isEmpty() ? m_levelPack.level(m_currentLevel).preferredFile() : m_hotReloadPath;
+    int sceneryCount = 0;
+    if (!m_endlessMode && levelPath.endsWith(".orbl")) {
+        CompiledLevel level;
+        if (level.open(levelPath)) {
+            sceneryCount = level.sceneryCount();
+            for (int i = 0; i < sceneryCount; ++i) {
+                const SceneryData scenery = level.sceneryData(i);
+                registry->preload(scenery.image, QSize(qRound(scenery.width), qRound(scenery.height)));
+            }
+        }
+    }
+    qDebug() << "GameScene: Preloading sprites, animation frames and" << sceneryCount << "scenery images in the background";
+}
+
+const TrackSegmentData* GameScene::residentSegment(int trackIndex) const
+{
+    const int local = trackIndex - m_windowFirstTrack;
+    if (local < 0 || static_cast<size_t>(local) >= m_levelData.segments.size()) return nullptr;
+    return &m_levelData.segments[local];
+}
+
+void GameScene::setupEndTrigger()
+{
+    if (m_endTriggerPoint) {
+        delete m_endTriggerPoint; // Removes it from the scene as well
+        m_endTriggerPoint = nullptr;
+    }
+    const EndTriggerData& endTrigger = m_levelData.endTrigger;
+    if (!m_levelData.segments.empty() && endTrigger.isEnabled()) {
+        // 使用 EndTriggerItem 类创建实例
+        m_endTriggerPoint = new EndTriggerItem(endTrigger.x, endTrigger.y, endTrigger.radius);
+        m_endTriggerPoint->setZValue(0.7); // 确保它在轨道之上，但在飞船之下或同层，以便碰撞
+        addItem(m_endTriggerPoint);
+        m_endTriggerPoint->setVisible(true); // Make sure it's visible
+        m_simulation.setEndTrigger(endTrigger.x, endTrigger.y, endTrigger.radius);
+        qDebug() << "EndTriggerItem created at scene pos (center):" << endTrigger.x << endTrigger.y << "with radius" << endTrigger.radius;
+    } else {
+        m_simulation.setEndTrigger(0, 0, 0);
+        qDebug() << "Skipping end trigger point creation (no level data, or the level has no end trigger).";
+    }
+}
+
+void GameScene::setupScenery()
+{
+    clearScenery();
+    m_scenery.reserve(m_levelData.scenery.size());
+    for (const SceneryData& scenery : m_levelData.scenery) {
+        m_scenery.push_back({scenery, nullptr});
+    }
+    m_pendingSceneryCount = static_cast<int>(m_scenery.size());
+}
+
+void GameScene::clearScenery()
+{
+    for (SceneryEntry& entry : m_scenery) {
+        delete entry.item; // Removes it from the scene as well
+    }
+    m_scenery.clear();
+    m_pendingSceneryCount = 0;
+}
+
+void GameScene::updateScenery(const QRectF& visibleRect)
+{
+    if (m_pendingSceneryCount == 0) return;
+
+    const QRectF loadRect = visibleRect.adjusted(-SCENERY_LOAD_MARGIN, -SCENERY_LOAD_MARGIN,
+                                                 SCENERY_LOAD_MARGIN, SCENERY_LOAD_MARGIN);
+    for (SceneryEntry& entry : m_scenery) {
+        if (entry.item) continue;
+        const SceneryData& scenery = entry.data;
+        const QRectF sceneryRect(scenery.x - scenery.width / 2.0, scenery.y - scenery.height / 2.0, scenery.width, scenery.height);
+        if (!loadRect.intersects(sceneryRect)) continue;
+
+        --m_pendingSceneryCount;
+        const QPixmap scaledPixmap = AssetRegistry::instance()->pixmap(scenery.image, QSize(qRound(scenery.width), qRound(scenery.height)));
+        if (scaledPixmap.isNull()) {
+            qWarning() << "Failed to load scenery image:" << scenery.image;
+            entry.item = new QGraphicsPixmapItem(); // 占位，不再重试
+            entry.item->setVisible(false);
+            addItem(entry.item);
+            continue;
+        }
+        entry.item = new QGraphicsPixmapItem(scaledPixmap);
+        const QSizeF logicalSize = scaledPixmap.deviceIndependentSize();
+        entry.item->setPos(scenery.x - logicalSize.width() / 2.0, scenery.y - logicalSize.height() / 2.0);
+        entry.item->setZValue(scenery.z);
+        addItem(entry.item);
+        qDebug() << "[Scenery] Loaded" << scenery.image << "at" << scenery.x << scenery.y
+                 << "(" << m_pendingSceneryCount << "still pending)";
+    }
+}
+
+quint64 GameScene::currentLevelHash() const
+{
+    if (!m_streamingLevel) {
+        return m_simulation.levelHash(); // 整关都在 m_simulation 里
+    }
+    return OrbitSimulation::levelHash(m_compiledLevel->segmentCount(),
+                                      [this](int index) { return m_compiledLevel->segmentData(index); },
+                                      m_levelData.endTrigger.x, m_levelData.endTrigger.y, m_levelData.endTrigger.radius);
 }
 
 void GameScene::addTrackItem(const TrackSegmentData& segmentData) {
@@ -788,6 +1109,14 @@ void GameScene::addTrackItem(const TrackSegmentData& segmentData) {
                   segmentData.centerY - segmentData.radius,
                   2 * segmentData.radius,
                   2 * segmentData.radius);
+    if (!m_trackItemPool.isEmpty()) {
+        // 复用移出窗口的轨道图元，它仍在场景里
+        QGraphicsEllipseItem* trackItem = m_trackItemPool.takeLast();
+        trackItem->setRect(bounds);
+        trackItem->setVisible(true);
+        m_trackItems.append(trackItem);
+        return;
+    }
     QGraphicsEllipseItem* trackItem = new QGraphicsEllipseItem(bounds);
     trackItem->setPen(m_trackPen);
     trackItem->setBrush(m_trackBrush); // Usually NoBrush for tracks
@@ -806,9 +1135,8 @@ void GameScene::positionAndShowCollectibles()
         }
 
         int trackIdx = collectible->getAssociatedTrackIndex();
-        if (trackIdx >= 0 && static_cast<size_t>(trackIdx) < m_levelData.segments.size()) {
-            const TrackSegmentData& segment = m_levelData.segments[trackIdx];
-            collectible->updateVisualPosition(QPointF(segment.centerX, segment.centerY), segment.radius);
+        if (const TrackSegmentData* segment = residentSegment(trackIdx)) {
+            collectible->updateVisualPosition(QPointF(segment->centerX, segment->centerY), segment->radius);
             collectible->setVisibleState(true); // Make sure it's visible
         } else {
             qWarning() << "Collectible has invalid track index:" << trackIdx << ". Hiding it.";
@@ -827,9 +1155,8 @@ void GameScene::positionAndShowObstacles()
         }
 
         int trackIdx = obstacle->getAssociatedTrackIndex();
-        if (trackIdx >= 0 && static_cast<size_t>(trackIdx) < m_levelData.segments.size()) {
-            const TrackSegmentData& segment = m_levelData.segments[trackIdx];
-            obstacle->updateVisualPosition(QPointF(segment.centerX, segment.centerY), segment.radius);
+        if (const TrackSegmentData* segment = residentSegment(trackIdx)) {
+            obstacle->updateVisualPosition(QPointF(segment->centerX, segment->centerY), segment->radius);
             obstacle->setVisibleState(true); // Make sure it's visible
         } else {
             qWarning() << "Obstacle has invalid track index:" << trackIdx << ". Hiding it.";
@@ -879,43 +1206,6 @@ void GameScene::updateInfiniteBackground() {
 
 void GameScene::updateGame()
 {
-    // ADDED: Debug log at the start of each game update tick
-    qDebug() << "[UpdateGame TICK] Health:" << m_health
-             << "Track:" << m_currentTrackIndex
-             << "Angle:" << qRadiansToDegrees(m_currentAngle) // Log angle in degrees
-             << "CanTakeDamage:" << m_canTakeDamage
-             << "OrbitOffset:" << m_orbitOffset
-             << "TimerActive:" << (m_timer ? m_timer->isActive() : false)
-             << "GameOver:" << m_gameOver;
-
-
-    // 首先检查是否与通关触发点碰撞
-    if (!m_gameOver && m_ball && m_endTriggerPoint && m_endTriggerPoint->isVisible() && m_ball->isVisible() && m_ball->collidesWithItem(m_endTriggerPoint)) {
-        qDebug() << "Spaceship collided with the end trigger point! Emitting endGameVideoRequested.";
-
-        if(m_timer && m_timer->isActive()) { // Stop game logic timer
-            m_timer->stop();
-            qDebug() << "Game timer stopped due to end trigger.";
-        }
-        // Don't stop background music here, let the video player handle it or stop it after video.
-
-        // Hide game elements, but keep score/health potentially for a "Level Cleared" screen before video
-        if(m_ball) m_ball->setVisible(false);
-        if (m_targetDot) m_targetDot->setVisible(false);
-        // if (m_endTriggerPoint) m_endTriggerPoint->setVisible(false); // Optionally hide trigger
-
-        // Hide HUD, or transition to a "Level Cleared" message
-        if (m_healthText) m_healthText->setVisible(false);
-        if (m_scoreText) m_scoreText->setVisible(false);
-        if (m_judgmentText) m_judgmentText->setVisible(false);
-
-        emit endGameVideoRequested(); // Signal to main window to play video
-        // m_gameOver might be set by the main window after video or by another mechanism.
-        // For now, we just stop the timer and emit the signal.
-        return; // Important to return here to prevent further game logic for this tick
-    }
-
-
     if (m_gameOver) {
         // If game is over (e.g., from health depletion or after video), do nothing further in update.
         return;
@@ -931,38 +1221,28 @@ void GameScene::updateGame()
         }
         return;
     }
-    if (m_currentTrackIndex < 0 || static_cast<size_t>(m_currentTrackIndex) >= m_levelData.segments.size()) {
-        qWarning() << "Invalid currentTrackIndex:" << m_currentTrackIndex << ". Ending game.";
-        endGame();
-        return;
-    }
-
-    // Game logic: Move ball, check collisions, update UI
-    const TrackSegmentData& currentSegment = m_levelData.segments[m_currentTrackIndex];
-    qreal effectiveBallRadiusOnTrack = currentSegment.radius + m_orbitOffset;
-    // Ensure effective radius is not too small, especially if ball is on inner orbit very close to center
-    if (effectiveBallRadiusOnTrack < BALL_RADIUS) effectiveBallRadiusOnTrack = BALL_RADIUS;
 
-    qreal currentAngularVelocity = (effectiveBallRadiusOnTrack > 0.01) ? (m_linearSpeed / effectiveBallRadiusOnTrack) : 0; // Avoid division by zero
-    qreal timeDelta = m_timer->interval() / 1000.0; // Time since last update in seconds
-    qreal angleDelta = currentAngularVelocity * timeDelta;
-
-    m_currentAngle += angleDelta * m_rotationDirection;
-
-    // Normalize angle to be within [0, 2*PI)
-    while (m_currentAngle >= 2.0 * M_PI) m_currentAngle -= 2.0 * M_PI;
-    while (m_currentAngle < 0) m_currentAngle += 2.0 * M_PI;
-
-    updateBallPosition(); // Update visual position of the ball
-
-    // Collision checks
-    checkBallCollectibleCollisions();
-    checkBallObstacleCollisions();
-    if (m_canTakeDamage) { // Only check for track collisions if not in cooldown
-        checkTrackCollisions();
+    // Measure the real time since the last frame instead of trusting the timer interval,
+    // so a late or coalesced timeout doesn't slow the ship down.
+    qint64 nowNsecs = m_frameClock.nsecsElapsed();
+    qreal frameSeconds = (nowNsecs - m_lastFrameNsecs) / 1e9;
+    m_lastFrameNsecs = nowNsecs;
+    if (frameSeconds > MAX_FRAME_SECONDS) frameSeconds = MAX_FRAME_SECONDS;
+    m_stepAccumulator += frameSeconds;
+
+    // Game logic: advance OrbitSimulation in fixed steps (moves ball, checks collisions)
+    while (m_stepAccumulator >= SIM_FIXED_STEP_SECONDS) {
+        m_previousSimState = m_simulation.state();
+        m_simulation.step(SIM_FIXED_STEP_SECONDS);
+        m_stepAccumulator -= SIM_FIXED_STEP_SECONDS;
+        processSimulationEvents();
+        // Note: endGame()/handleLevelCompleted() might be called while processing events.
+        // If so, the timer is stopped and the ball is hidden, so stop stepping and skip the camera update.
+        if (m_gameOver || !m_timer->isActive()) return;
     }
-    // Note: endGame() might be called within collision checks if health drops to 0.
-    // If so, m_gameOver will be true, and the next tick will return early.
+
+    // Draw the ship between the last two simulated states
+    updateBallPosition(m_stepAccumulator / SIM_FIXED_STEP_SECONDS);
 
 
     // Update view to follow the ball and position HUD elements
@@ -975,6 +1255,7 @@ void GameScene::updateGame()
 
         // Position HUD elements relative to the view
         QRectF viewRectForHUD = view->mapToScene(view->viewport()->geometry()).boundingRect();
+        updateScenery(viewRectForHUD);
 
         if (m_healthText && m_healthText->isVisible()) { // Check visibility
             m_healthText->setPos(viewRectForHUD.topLeft() + QPointF(20, 20)); // Top-left corner
@@ -986,22 +1267,51 @@ void GameScene::updateGame()
     }
 }
 
+void GameScene::handleLevelCompleted()
+{
+    qDebug() << "Spaceship collided with the end trigger point! Emitting endGameVideoRequested.";
+    saveReplay();
+
+    if(m_timer && m_timer->isActive()) { // Stop game logic timer
+        m_timer->stop();
+        qDebug() << "Game timer stopped due to end trigger.";
+    }
+    // Don't stop background music here, let the video player handle it or stop it after video.
+
+    if (!m_endlessMode && m_hotReloadPath.isEmpty() && m_currentLevel + 1 < m_levelPack.levelCount()) {
+        // 还有下一关：直接换关（下一关已经在后台读好了），通关最后一关才播放结束视频。
+        // 推迟到事件循环里做，不在处理模拟事件的过程中销毁图元
+        ++m_currentLevel;
+        qDebug() << "Level completed. Advancing to level" << m_currentLevel << m_levelPack.level(m_currentLevel).name;
+        QTimer::singleShot(0, this, &GameScene::initializeGame);
+        return;
+    }
 
-void GameScene::updateBallPosition() {
-    if (!m_ball || m_levelData.segments.empty() || m_currentTrackIndex < 0 || static_cast<size_t>(m_currentTrackIndex) >= m_levelData.segments.size()) return;
+    // Hide game elements, but keep score/health potentially for a "Level Cleared" screen before video
+    if(m_ball) m_ball->setVisible(false);
+    if (m_targetDot) m_targetDot->setVisible(false);
+    // if (m_endTriggerPoint) m_endTriggerPoint->setVisible(false); // Optionally hide trigger
+
+    // Hide HUD, or transition to a "Level Cleared" message
+    if (m_healthText) m_healthText->setVisible(false);
+    if (m_scoreText) m_scoreText->setVisible(false);
+    if (m_judgmentText) m_judgmentText->setVisible(false);
 
-    const TrackSegmentData& currentSegmentData = m_levelData.segments[m_currentTrackIndex];
-    qreal effectiveRadius = currentSegmentData.radius + m_orbitOffset;
+    emit endGameVideoRequested(); // Signal to main window to play video
+    // m_gameOver might be set by the main window after video or by another mechanism.
+    // For now, we just stop the timer and emit the signal.
+}
 
-    // Prevent ball from going inside the track center point if on inner orbit
-    if (effectiveRadius < BALL_RADIUS && m_orbitOffset < 0) effectiveRadius = BALL_RADIUS;
-    // This case should ideally not happen if orbitOffset is always +/- (BALL_RADIUS + ORBIT_PADDING)
-    // but as a safeguard:
-    else if (effectiveRadius < 0 && m_orbitOffset > 0) effectiveRadius = BALL_RADIUS;
 
+void GameScene::updateBallPosition(qreal interpolation) {
+    if (!m_ball || m_levelData.segments.empty()) return;
 
-    qreal x_center = currentSegmentData.centerX + effectiveRadius * qCos(m_currentAngle);
-    qreal y_center = currentSegmentData.centerY + effectiveRadius * qSin(m_currentAngle);
+    // interpolation = 1.0 draws the latest simulated state
+    const OrbitSimState simState = (interpolation >= 1.0)
+                                       ? m_simulation.state()
+                                       : OrbitSimulation::interpolate(m_previousSimState, m_simulation.state(), interpolation);
+    qreal x_center, y_center;
+    m_simulation.shipPosition(simState, &x_center, &y_center); // Effective radius is clamped inside OrbitSimulation
 
     // Position the ball pixmap item; its origin is top-left by default
     if (m_ball->pixmap().isNull()) { // Fallback for simple QGraphicsEllipseItem if pixmap failed
@@ -1013,20 +1323,21 @@ void GameScene::updateBallPosition() {
     }
 
     // Rotate the ball to align with its direction of travel (tangent to the circle)
-    // Angle of the tangent line is m_currentAngle + PI/2 (or -PI/2 depending on rotation direction)
-    qreal tangentAngleRadians = m_currentAngle + m_rotationDirection * (M_PI / 2.0);
+    // Angle of the tangent line is angle + PI/2 (or -PI/2 depending on rotation direction)
+    qreal tangentAngleRadians = simState.angle + simState.rotationDirection * (M_PI / 2.0);
     qreal rotationAngleDegrees = qRadiansToDegrees(tangentAngleRadians);
     rotationAngleDegrees += 90.0; // Adjust if spaceship image points "up" by default
     m_ball->setRotation(rotationAngleDegrees);
 }
 
 void GameScene::updateTargetDotPosition() {
-    if (!m_targetDot || m_levelData.segments.empty() || m_currentTrackIndex < 0 || static_cast<size_t>(m_currentTrackIndex) >= m_levelData.segments.size()) {
+    const TrackSegmentData* currentSegment = residentSegment(m_simulation.state().trackIndex);
+    if (!m_targetDot || !currentSegment) {
         if(m_targetDot) m_targetDot->setVisible(false); // Hide if invalid state
         return;
     }
 
-    const TrackSegmentData& currentSegmentData = m_levelData.segments[m_currentTrackIndex];
+    const TrackSegmentData& currentSegmentData = *currentSegment;
     // Position the target dot at the "top" of the current track (where ANGLE_TOP is)
     QPointF judgmentPoint = QPointF(currentSegmentData.centerX, currentSegmentData.centerY) +
                             QPointF(currentSegmentData.radius * qCos(ANGLE_TOP),
@@ -1039,172 +1350,52 @@ void GameScene::hideJudgmentText() {
     if (m_judgmentText) m_judgmentText->setVisible(false);
 }
 
-void GameScene::enableDamageTaking() {
-    m_canTakeDamage = true;
-    qDebug() << "[DamageCooldown] Cooldown finished. m_canTakeDamage set to true.";
-}
-
-void GameScene::checkTrackCollisions() {
-    // Only check if ball is on the outer orbit and can take damage
-    if (m_orbitOffset <= 0 || !m_ball || m_levelData.segments.empty() || !m_canTakeDamage || m_currentTrackIndex < 0) return;
-
-    QPointF ballVisualCenter = m_ball->sceneBoundingRect().center(); // Center of the ball's visual representation
-    bool collisionOccurred = false;
-    size_t collidedTrackIndex = static_cast<size_t>(-1); // Initialize with an invalid index
-
-    // Check collision with ALL OTHER tracks
-    for (size_t i = 0; i < m_levelData.segments.size(); ++i) {
-        if (static_cast<int>(i) == m_currentTrackIndex) continue; // Skip current track
-
-        const TrackSegmentData& otherSegment = m_levelData.segments[i];
-        QPointF otherTrackCenter(otherSegment.centerX, otherSegment.centerY);
-        qreal distanceToOtherTrackCenter = QLineF(ballVisualCenter, otherTrackCenter).length();
-
-        // MODIFIED COLLISION DETECTION:
-        // Original: if (distanceToOtherTrackCenter < otherSegment.radius + BALL_RADIUS)
-        // The factor TRACK_COLLISION_EFFECTIVE_RADIUS_FACTOR (e.g., 0.8) makes the ball effectively "thinner"
-        // for the purpose of this specific collision check, requiring a deeper overlap.
-        if (distanceToOtherTrackCenter < otherSegment.radius + (BALL_RADIUS * TRACK_COLLISION_EFFECTIVE_RADIUS_FACTOR)) {
-            collisionOccurred = true;
-            collidedTrackIndex = i;
-            break;
-        }
-    }
-
-    if (collisionOccurred) {
-        qDebug() << "[TrackCollision] Occurred! Health BEFORE deduction:" << m_health
-                 << " Current track:" << m_currentTrackIndex
-                 << " Collided with track:" << collidedTrackIndex
-                 << " Can take damage:" << m_canTakeDamage
-                 << " OrbitOffset:" << m_orbitOffset
-                 << " EffectiveBallRadiusForCheck:" << (BALL_RADIUS * TRACK_COLLISION_EFFECTIVE_RADIUS_FACTOR);
-
-
-        m_health--;
-        updateHealthDisplay();
-        triggerExplosionEffect(); // Show visual feedback
-
-        // Force ball to inner orbit of current track as a penalty/evasive maneuver
-        m_orbitOffset = -(BALL_RADIUS + ORBIT_PADDING); // Negative for inner orbit
-        updateBallPosition(); // Immediately update position
-
-        m_canTakeDamage = false; // Start cooldown
-        m_damageCooldownTimer->start(DAMAGE_COOLDOWN_MS); // Use the constant (log showed 500ms, ensure this is intended)
-
-        qDebug() << "[TrackCollision] Occurred! Health AFTER deduction:" << m_health
-                 << " New OrbitOffset:" << m_orbitOffset
-                 << " CanTakeDamage set to false. Cooldown started for" << DAMAGE_COOLDOWN_MS << "ms.";
-
-        if (m_health <= 0) {
-            endGame();
-        }
-    }
-}
-
-
-void GameScene::checkBallCollectibleCollisions() {
-    if (!m_ball || !m_ball->isVisible()) return; // No ball or ball is hidden
-
-    // Get all items colliding with the ball
-    QList<QGraphicsItem*> collidingItemsList = m_ball->collidingItems();
-
-    for (QGraphicsItem* item : collidingItemsList) {
-        CollectibleItem* collectible = dynamic_cast<CollectibleItem*>(item);
-        if (collectible && collectible->isVisible() && !collectible->isCollected()) {
-            collectible->collect(); // This will emit collectedSignal
-        }
-    }
-}
-
-void GameScene::checkBallObstacleCollisions() {
-    if (!m_ball || !m_ball->isVisible()) return; // No ball or ball is hidden
-
-    QList<QGraphicsItem*> collidingItemsList = m_ball->collidingItems();
-
-    for (QGraphicsItem* item : collidingItemsList) {
-        ObstacleItem* obstacle = dynamic_cast<ObstacleItem*>(item);
-        // Check if it's an obstacle, it's visible, and hasn't been "hit" yet in a way that makes it non-interactive
-        if (obstacle && obstacle->isVisible() && !obstacle->isHit() && m_canTakeDamage) { // Also check m_canTakeDamage here before processing hit
-            obstacle->processHit(); // This will emit hitSignal
-                // The actual damage is handled in handleObstacleHit slot
-        } else if (obstacle && obstacle->isVisible() && !obstacle->isHit() && !m_canTakeDamage) {
-            qDebug() << "[ObstacleCollisionCheck] Ball collided with obstacle, but m_canTakeDamage is false. No hit processed this tick.";
-        }
-    }
-}
-
 
 void GameScene::handleCollectibleCollected(CollectibleItem* item) {
     if (!item) return;
+    // 分数已由 OrbitSimulation 累加，这里只负责特效和 HUD
     qDebug() << "[CollectibleCollected] Collectible on track" << item->getAssociatedTrackIndex() << "collected. Score +" << item->getScoreValue();
     triggerCollectEffect(); // Show visual effect for collection
-    m_score += item->getScoreValue();
-    updateScoreDisplayAndSpeed(); // Update UI and potentially speed
+    updateScoreDisplay();
     // The item itself will handle its visibility/removal from scene logic after collection
 }
 
 void GameScene::handleObstacleHit(ObstacleItem* item) {
     if (!item) return; // Should not happen if signal is emitted correctly
 
-    if (!m_canTakeDamage) {
-        qDebug() << "[ObstacleHit] Signal received for obstacle on track" << item->getAssociatedTrackIndex()
-        << "but m_canTakeDamage is false. No damage taken. Health:" << m_health;
-        // Obstacle might still play an animation or sound even if player doesn't take damage.
-        // For now, if player is invincible, obstacle hit does nothing to player.
-        return;
-    }
-
-    qDebug() << "[ObstacleHit] Obstacle Hit on track " << item->getAssociatedTrackIndex() << "! Health BEFORE deduction:" << m_health << "Can take damage:" << m_canTakeDamage;
-    m_health--;
+    // 扣血与无敌时间已由 OrbitSimulation 处理，这里只负责特效和 HUD
+    qDebug() << "[ObstacleHit] Obstacle Hit on track " << item->getAssociatedTrackIndex() << "! Health AFTER deduction:" << m_simulation.state().health;
     updateHealthDisplay();
     triggerExplosionEffect(); // Player hit effect
-
-    m_canTakeDamage = false; // Start invincibility cooldown
-    m_damageCooldownTimer->start(DAMAGE_COOLDOWN_MS); // Use the constant
-
-    qDebug() << "[ObstacleHit] Obstacle Hit! Health AFTER deduction:" << m_health << "CanTakeDamage set to false. Cooldown for" << DAMAGE_COOLDOWN_MS << "ms.";
-
-    if (m_health <= 0) {
-        endGame();
-    }
     // The obstacle item itself might change its state (e.g., become inactive or play an animation) via its processHit() method.
 }
 
 
-void GameScene::switchTrack() {
-    qDebug() << "[SwitchTrack] Entering switchTrack. Current track BEFORE switch:" << m_currentTrackIndex
-             << " Health:" << m_health << " Can take damage:" << m_canTakeDamage
-             << " OrbitOffset BEFORE:" << m_orbitOffset << " RotationDir BEFORE:" << m_rotationDirection
-             << " Angle BEFORE:" << qRadiansToDegrees(m_currentAngle);
-
-    if (static_cast<size_t>(m_currentTrackIndex + 1) >= m_levelData.segments.size()) {
-        qDebug() << "[SwitchTrack] Attempted to switch past the last track (" << m_levelData.segments.size() -1 << "). No switch performed.";
-        return;
+QPixmap GameScene::explosionFrame(int frameNumber)
+{
+    if (m_explosionFrames.isEmpty()) {
+        m_explosionFrames = AssetRegistry::instance()->frames(EXPLOSION_ANIMATION_PATH, explosionFrameSize());
     }
-
-    m_currentTrackIndex++;
-    m_rotationDirection = -m_rotationDirection; // Reverse rotation on new track
-    m_currentAngle = ANGLE_BOTTOM; // Reset angle to a consistent starting point
-
-    // ***** 修改核心逻辑：确保飞船在新轨道的内侧 *****
-    // 原来的逻辑是确保在外侧:
-    // m_orbitOffset = qAbs(m_orbitOffset);
-    // if (m_orbitOffset < (BALL_RADIUS + ORBIT_PADDING) || m_orbitOffset == 0) {
-    //      m_orbitOffset = BALL_RADIUS + ORBIT_PADDING;
-    // }
-    // 新逻辑：直接设置为内侧偏移
-    m_orbitOffset = -(BALL_RADIUS + ORBIT_PADDING);
-    // ***** 修改核心逻辑结束 *****
-
-    updateTargetDotPosition(); // Update target dot for the new track
-    updateBallPosition();    // Update ball position immediately for the new track and angle
-
-    qDebug() << "[SwitchTrack] Switched to track:" << m_currentTrackIndex
-             << " Health:" << m_health << " Can take damage:" << m_canTakeDamage
-             << " New OrbitOffset:" << m_orbitOffset << " New RotationDir:" << m_rotationDirection
-             << " New Angle:" << qRadiansToDegrees(m_currentAngle);
+    if (frameNumber >= 0 && frameNumber < m_explosionFrames.size()) {
+        return m_explosionFrames.at(frameNumber);
+    }
+    const QPixmap originalFrame = m_explosionMovie->currentPixmap();
+    return originalFrame.isNull() ? originalFrame
+                                  : originalFrame.scaled(explosionFrameSize(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
 }
 
+QPixmap GameScene::collectEffectFrame(int frameNumber)
+{
+    if (m_collectEffectFrames.isEmpty()) {
+        m_collectEffectFrames = AssetRegistry::instance()->frames(COLLECT_EFFECT_ANIMATION_PATH, collectEffectFrameSize());
+    }
+    if (frameNumber >= 0 && frameNumber < m_collectEffectFrames.size()) {
+        return m_collectEffectFrames.at(frameNumber);
+    }
+    const QPixmap originalFrame = m_collectEffectMovie->currentPixmap();
+    return originalFrame.isNull() ? originalFrame
+                                  : originalFrame.scaled(collectEffectFrameSize(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
+}
 
 void GameScene::triggerExplosionEffect() {
     if (!m_explosionMovie || !m_explosionItem || !m_ball || !m_explosionDurationTimer) {
@@ -1222,17 +1413,13 @@ void GameScene::triggerExplosionEffect() {
     m_explosionMovie->jumpToFrame(0); // Rewind to start
 
     QPointF effectCenter = m_ball->sceneBoundingRect().center(); // Position at ball's center
-    QPixmap originalFrame = m_explosionMovie->currentPixmap();
+    QPixmap scaledFrame = explosionFrame(0);
 
-    if (originalFrame.isNull()) {
+    if (scaledFrame.isNull()) {
         qWarning() << "Explosion GIF current frame is null for triggerExplosionEffect.";
         return;
     }
 
-    qreal effectDisplayDiameter = 5.0 * BALL_RADIUS; // Make explosion larger than ball
-    QSize targetSize(static_cast<int>(effectDisplayDiameter), static_cast<int>(effectDisplayDiameter));
-    QPixmap scaledFrame = originalFrame.scaled(targetSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
     m_explosionItem->setPixmap(scaledFrame);
     m_explosionItem->setPos(effectCenter - QPointF(scaledFrame.width() / 2.0, scaledFrame.height() / 2.0)); // Center the pixmap
     m_explosionItem->setVisible(true);
@@ -1242,16 +1429,11 @@ void GameScene::triggerExplosionEffect() {
 }
 
 void GameScene::updateExplosionFrame(int frameNumber) {
-    Q_UNUSED(frameNumber);
     if (!m_explosionMovie || !m_explosionItem || m_explosionMovie->state() != QMovie::Running) return;
     if (!m_ball) return; // Ball might be null if game ends abruptly
 
-    QPixmap originalFrame = m_explosionMovie->currentPixmap();
-    if (originalFrame.isNull()) return;
-
-    qreal effectDisplayDiameter = 5.0 * BALL_RADIUS;
-    QSize targetSize(static_cast<int>(effectDisplayDiameter), static_cast<int>(effectDisplayDiameter));
-    QPixmap scaledFrame = originalFrame.scaled(targetSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    QPixmap scaledFrame = explosionFrame(frameNumber);
+    if (scaledFrame.isNull()) return;
 
     m_explosionItem->setPixmap(scaledFrame);
     // Update position if ball is still visible and moving (optional, effect could be static)
@@ -1298,16 +1480,12 @@ void GameScene::triggerCollectEffect() {
 
     m_collectEffectMovie->jumpToFrame(0);
     QPointF effectCenter = m_ball->sceneBoundingRect().center();
-    QPixmap originalFrame = m_collectEffectMovie->currentPixmap();
-    if (originalFrame.isNull()) {
+    QPixmap scaledFrame = collectEffectFrame(0);
+    if (scaledFrame.isNull()) {
         qWarning() << "Collect effect GIF current frame is null for triggerCollectEffect.";
         return;
     }
 
-    qreal effectDisplayDiameter = DEFAULT_COLLECTIBLE_TARGET_SIZE * DEFAULT_COLLECTIBLE_EFFECT_SIZE_MULTIPLIER;
-    QSize targetSize(static_cast<int>(effectDisplayDiameter), static_cast<int>(effectDisplayDiameter));
-    QPixmap scaledFrame = originalFrame.scaled(targetSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-
     m_collectEffectItem->setPixmap(scaledFrame);
     m_collectEffectItem->setPos(effectCenter - QPointF(scaledFrame.width() / 2.0, scaledFrame.height() / 2.0));
     m_collectEffectItem->setVisible(true);
@@ -1318,16 +1496,11 @@ void GameScene::triggerCollectEffect() {
 
 
 void GameScene::updateCollectEffectFrame(int frameNumber) {
-    Q_UNUSED(frameNumber);
     if (!m_collectEffectMovie || !m_collectEffectItem || m_collectEffectMovie->state() != QMovie::Running) return;
     if (!m_ball) return;
 
-    QPixmap originalFrame = m_collectEffectMovie->currentPixmap();
-    if (originalFrame.isNull()) return;
-
-    qreal effectDisplayDiameter = DEFAULT_COLLECTIBLE_TARGET_SIZE * DEFAULT_COLLECTIBLE_EFFECT_SIZE_MULTIPLIER;
-    QSize targetSize(static_cast<int>(effectDisplayDiameter), static_cast<int>(effectDisplayDiameter));
-    QPixmap scaledFrame = originalFrame.scaled(targetSize, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    QPixmap scaledFrame = collectEffectFrame(frameNumber);
+    if (scaledFrame.isNull()) return;
 
     m_collectEffectItem->setPixmap(scaledFrame);
     if (m_ball->isVisible()) { // Update position to follow ball
@@ -1369,3 +1542,193 @@ void GameScene::handleGameOverReturnToMain()
     emit returnToStartScreenRequested(); // Signal to the main application window
 }
 
+// ==========================================================================
+// 关卡热重载
+// ==========================================================================
+
+namespace {
+
+bool sameTrackGeometry(const TrackSegmentData& a, const TrackSegmentData& b)
+{
+    return a.centerX == b.centerX && a.centerY == b.centerY && a.radius == b.radius
+           && a.tangentAngleDegrees == b.tangentAngleDegrees;
+}
+
+bool sameScenery(const std::vector<SceneryData>& a, const std::vector<SceneryData>& b)
+{
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].image != b[i].image || a[i].x != b[i].x || a[i].y != b[i].y || a[i].width != b[i].width
+            || a[i].height != b[i].height || a[i].z != b[i].z) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 把一条轨道上的旧物品与新数据配对 (matchSegmentItems)。配上的图元原样保留（连同已收集/已撞过的状态），
+// origin 记下它在旧关卡中的编号；没配上的旧图元隐藏后放进 pool，新增的物品由 take 从池中取或新建。
+// 返回增删的物品数
+template <typename Item, typename Data, typename Take>
+int patchSegmentItems(const QList<Item*>& oldItems, int oldFirst, const std::vector<Data>& oldData,
+                      const std::vector<Data>& newData, QList<Item*>* items, std::vector<int>* origin,
+                      QList<Item*>* pool, Take take)
+{
+    const std::vector<int> newOrigin = matchSegmentItems(oldData, newData, oldFirst);
+    std::vector<bool> matched(oldData.size(), false);
+    for (int old : newOrigin) {
+        if (old >= 0) matched[old - oldFirst] = true;
+    }
+
+    int changed = 0;
+    for (size_t j = 0; j < oldData.size(); ++j) {
+        if (matched[j]) continue;
+        Item* item = oldItems[oldFirst + static_cast<int>(j)];
+        item->setVisible(false);
+        pool->append(item);
+        ++changed;
+    }
+    for (size_t k = 0; k < newData.size(); ++k) {
+        if (newOrigin[k] >= 0) {
+            items->append(oldItems[newOrigin[k]]);
+        } else {
+            items->append(take(newData[k]));
+            ++changed;
+        }
+        origin->push_back(newOrigin[k]);
+    }
+    return changed;
+}
+
+} // namespace
+
+void GameScene::setHotReloadLevel(const QString& path)
+{
+    if (m_levelWatcher) {
+        delete m_levelWatcher;
+        m_levelWatcher = nullptr;
+    }
+    m_hotReloadPath = path;
+    m_gamePrepared = false;
+    if (path.isEmpty()) return;
+
+    m_levelWatcher = new QFileSystemWatcher(this);
+    if (!m_levelWatcher->addPath(path)) {
+        qWarning() << "[HotReload] Cannot watch" << path << ". The level is still loaded from it, but will not reload.";
+    }
+    connect(m_levelWatcher, &QFileSystemWatcher::fileChanged, this, &GameScene::handleLevelFileChanged);
+    qDebug() << "[HotReload] Watching level file" << path;
+}
+
+void GameScene::handleLevelFileChanged(const QString& path)
+{
+    qDebug() << "[HotReload] Level file changed:" << path;
+    m_levelReloadTimer->start(); // 重新计时，同一次保存的多个通知只重载一次
+}
+
+void GameScene::reloadWatchedLevel()
+{
+    if (m_hotReloadPath.isEmpty() || !m_levelWatcher) return;
+    // 很多编辑器保存时先写临时文件再改名，原来的文件被替换后监视就失效了，这里重新加上
+    if (!m_levelWatcher->files().contains(m_hotReloadPath) && QFile::exists(m_hotReloadPath)) {
+        m_levelWatcher->addPath(m_hotReloadPath);
+    }
+    if (m_endlessMode || m_streamingLevel || m_trackItems.isEmpty()) {
+        qDebug() << "[HotReload] No level from" << m_hotReloadPath << "is running; it will be loaded by the next game.";
+        return;
+    }
+
+    QElapsedTimer reloadClock;
+    reloadClock.start();
+    TrackData edited;
+    if (!edited.loadLevelFromFile(m_hotReloadPath)) {
+        qWarning() << "[HotReload] Keeping the current level until" << m_hotReloadPath << "loads again.";
+        return;
+    }
+
+    const int oldCount = static_cast<int>(m_levelData.segments.size());
+    const int newCount = static_cast<int>(edited.segments.size());
+    if (m_simulation.state().trackIndex >= newCount) {
+        qWarning() << "[HotReload] The ship's track was removed from the level. Restarting the level.";
+        initializeGame();
+        return;
+    }
+
+    // 按轨道编号对比新旧关卡，只修补有变化的轨道和物品
+    QList<CollectibleItem*> collectibles;
+    QList<ObstacleItem*> obstacles;
+    std::vector<int> collectibleOrigin;
+    std::vector<int> obstacleOrigin;
+    int oldFirstCollectible = 0;
+    int oldFirstObstacle = 0;
+    int changedTracks = 0;
+    int changedItems = 0;
+    static const TrackSegmentData noSegment = {0, 0, 0, 0, {}, {}};
+    for (int i = 0; i < qMax(oldCount, newCount); ++i) {
+        const TrackSegmentData& before = (i < oldCount) ? m_levelData.segments[i] : noSegment;
+        const TrackSegmentData& after = (i < newCount) ? edited.segments[i] : noSegment;
+
+        if (i >= newCount) {
+            QGraphicsEllipseItem* trackItem = m_trackItems.takeLast(); // 删掉的总是末尾的轨道
+            trackItem->setVisible(false);
+            m_trackItemPool.append(trackItem);
+            ++changedTracks;
+        } else if (i >= oldCount) {
+            addTrackItem(after);
+            ++changedTracks;
+        } else if (!sameTrackGeometry(before, after)) {
+            m_trackItems[i]->setRect(after.centerX - after.radius, after.centerY - after.radius,
+                                     2 * after.radius, 2 * after.radius);
+            ++changedTracks;
+        }
+
+        changedItems += patchSegmentItems(m_collectibles, oldFirstCollectible, before.collectibles, after.collectibles,
+                                          &collectibles, &collectibleOrigin, &m_collectiblePool,
+                                          [this, i](const CollectibleData& data) { return takeCollectibleItem(i, data); });
+        changedItems += patchSegmentItems(m_obstacles, oldFirstObstacle, before.obstacles, after.obstacles,
+                                          &obstacles, &obstacleOrigin, &m_obstaclePool,
+                                          [this, i](const ObstacleData& data) { return takeObstacleItem(i, data); });
+        oldFirstCollectible += static_cast<int>(before.collectibles.size());
+        oldFirstObstacle += static_cast<int>(before.obstacles.size());
+    }
+
+    if (!m_simulation.replaceLevel(edited, collectibleOrigin, obstacleOrigin)) {
+        initializeGame();
+        return;
+    }
+    const bool sceneryChanged = !sameScenery(m_levelData.scenery, edited.scenery);
+    const bool endTriggerChanged = m_levelData.endTrigger.x != edited.endTrigger.x || m_levelData.endTrigger.y != edited.endTrigger.y
+                                   || m_levelData.endTrigger.radius != edited.endTrigger.radius;
+    m_levelData = std::move(edited);
+    m_collectibles = collectibles;
+    m_obstacles = obstacles;
+    if (endTriggerChanged) setupEndTrigger();
+    if (sceneryChanged) setupScenery(); // 重新按需加载，下一帧就会加载视野附近的装饰
+
+    // 场景范围只扩大不缩小，镜头才能跟到新加的轨道和装饰
+    QRectF tracksRect = sceneRect();
+    for (const TrackSegmentData& segment : m_levelData.segments) {
+        tracksRect = tracksRect.united(QRectF(segment.centerX - segment.radius - SCENE_RECT_PADDING,
+                                              segment.centerY - segment.radius - SCENE_RECT_PADDING,
+                                              2 * (segment.radius + SCENE_RECT_PADDING),
+                                              2 * (segment.radius + SCENE_RECT_PADDING)));
+    }
+    for (const SceneryData& scenery : m_levelData.scenery) {
+        tracksRect = tracksRect.united(QRectF(scenery.x - scenery.width / 2.0 - SCENE_RECT_PADDING,
+                                              scenery.y - scenery.height / 2.0 - SCENE_RECT_PADDING,
+                                              scenery.width + 2 * SCENE_RECT_PADDING, scenery.height + 2 * SCENE_RECT_PADDING));
+    }
+    setSceneRect(tracksRect);
+
+    positionAndShowCollectibles();
+    positionAndShowObstacles();
+    m_previousSimState = m_simulation.state(); // 当前轨道可能变了形，不要从旧位置插值过去
+    if (m_ball) updateBallPosition();
+    if (m_targetDot) updateTargetDotPosition();
+
+    // 这一局已经跑在好几个版本的关卡上，录像无法用任何一个关卡文件校验
+    m_replaySaved = true;
+    qDebug() << "[HotReload] Patched" << changedTracks << "tracks and" << changedItems << "items"
+             << (sceneryChanged ? "(scenery reloaded)" : "") << (endTriggerChanged ? "(end trigger moved)" : "") << "of"
+             << m_hotReloadPath << "in" << reloadClock.nsecsElapsed() / 1000 << "us. Replay of this run will not be saved.";
+}
@@ -5,6 +5,7 @@
 #include <QGraphicsEllipseItem> // 需要包含它，因为 m_endTriggerPoint 是这个类型
 #include <QGraphicsPixmapItem>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QKeyEvent>
 #include <QRandomGenerator>
 #include <QPen>
@@ -24,29 +25,39 @@
 #include <QAudioOutput>
 #include <QUrl>
 #include <QMovie>
+#include <QFileSystemWatcher>
 
 #include "trackdata.h"
+#include "compiledlevel.h"
+#include "trackgenerator.h"
+#include "levelpack.h"
+#include "orbitsimulation.h"
+#include "orbitreplay.h"
 #include "collectibleitem.h"
 #include "obstacleitem.h"
 #include "gameoverdisplay.h"
 #include "endtriggeritem.h" // <--- 包含新创建的 EndTriggerItem 头文件
 
-// --- 游戏常量 ---
-const qreal BASE_LINEAR_SPEED = 150.0;
-const int SCORE_PERFECT = 2;
-const int SCORE_GOOD = 1;
-const int SCORE_THRESHOLD_FOR_SPEEDUP = 50;
-const qreal SPEEDUP_FACTOR = 1.1;
-const qreal BALL_RADIUS = 10.0;
+// --- 渲染常量 (游戏规则常量见 orbitsimulation.h) ---
 const qreal TARGET_DOT_RADIUS = 5.0;
-const qreal ORBIT_PADDING = 3.0;
-const qreal PERFECT_MS = 80.0;
-const qreal GOOD_MS = 160.0;
-const int DAMAGE_COOLDOWN_MS = 500;
 const int BG_GRID_SIZE = 3;
+const int FRAME_INTERVAL_MS = 16;       // 渲染帧间隔，只影响画面刷新，不影响游戏速度
+const qreal MAX_FRAME_SECONDS = 0.25;   // 单帧最多补算的时间，避免卡顿后一次性追赶太多步
 const qreal DEFAULT_COLLECTIBLE_EFFECT_SIZE_MULTIPLIER = 4.0;
-extern const qreal DEFAULT_COLLECTIBLE_TARGET_SIZE; // 假设在 collectibleitem.h 中定义并初始化
-// const qreal END_POINT_RADIUS = 15.0; // 已在 endtriggeritem.h 中定义为 DEFAULT_END_POINT_RADIUS，或者您可以在此统一定义
+const qreal EXPLOSION_EFFECT_SIZE_MULTIPLIER = 5.0;     // 爆炸动画的直径 = BALL_RADIUS 的倍数，比飞船大
+const qreal SCENE_RECT_PADDING = 200.0; // 场景范围在轨道/行星外留出的边距
+
+// --- 流式关卡 ---
+// 编译好的关卡 (.orbl) 只让当前轨道附近的一段驻留，边走边加载前方、丢弃身后（同 OrbitGame1.0 的
+// generateNextTrack / cleanupOldTracks），内存与关卡长度无关
+const int LEVEL_STREAM_TRACKS_BEHIND = 2; // 身后保留的轨道数，与 cleanupOldTracks 的 lookBehindMargin 相同；外侧飞行仍可能撞到它们
+const int LEVEL_STREAM_TRACKS_AHEAD = 8;  // 前方预先加载的轨道数，要覆盖视野里能看到的轨道
+
+// --- 关卡热重载 ---
+const int LEVEL_HOT_RELOAD_DELAY_MS = 5; // 等编辑器写完再读，远小于一帧
+
+// --- 装饰 ---
+const qreal SCENERY_LOAD_MARGIN = 600.0; // 装饰进入视野外这个距离以内就加载，飞船看到它之前已经准备好
 
 
 class GameScene : public QGraphicsScene
@@ -57,11 +68,29 @@ public:
     explicit GameScene(QObject *parent = nullptr);
     ~GameScene();
 
+    // 开始新的一局 = prepareGame() + startGame()
     void initializeGame();
+    // 加载关卡、创建所有图元和 HUD，但不启动计时器和音乐。可以在场景还没显示时（开场视频播放期间）提前调用
+    void prepareGame();
+    // 启动准备好的一局（没有准备过时先 prepareGame）。应在场景已经放进视图之后调用
+    void startGame();
+    // 当前关是关卡包的最后一关（通关后会播放结束视频）
+    bool isOnLastLevel() const;
+    // 选择之后 initializeGame 开始的模式：关卡，或由 seed 生成轨道的无尽模式
+    void setEndlessMode(bool endless, quint32 seed = 0);
+    // 选择 initializeGame 加载关卡包里的第几关（从开始界面进入时为 0）
+    void setCurrentLevel(int index);
+    // 关卡编辑用: initializeGame 改为加载磁盘上的关卡 JSON，文件保存后只修补改动的轨道和物品，
+    // 飞船状态不变（不用重新编译资源，也不用重开一局）。空字符串关闭
+    void setHotReloadLevel(const QString& path);
+    // 在线程池里提前解码、缩放下一局要用的图片（飞船、物品、动画帧、当前关卡的装饰），
+    // 开场视频播放期间调用，视频结束时 initializeGame 不再需要同步加载图片
+    void preloadAssets();
 
 signals:
     void returnToStartScreenRequested(); // 用于生命耗尽后，从 GameOverDisplay 返回主菜单
     void endGameVideoRequested();        // <--- 新增信号：当碰到通关点时发出
+    void lastLevelStarted();             // 关卡包的最后一关开始了，接下来可能播放结束视频
 
 protected:
     void keyPressEvent(QKeyEvent *event) override;
@@ -69,7 +98,6 @@ protected:
 private slots:
     void updateGame();
     void hideJudgmentText();
-    void enableDamageTaking();
     void handleCollectibleCollected(CollectibleItem* item);
     void handleObstacleHit(ObstacleItem* item);
 
@@ -86,42 +114,48 @@ private slots:
     void handleGameOverRestart();    // 处理来自 GameOverDisplay 的重新开始请求
     void handleGameOverReturnToMain(); // 处理来自 GameOverDisplay 的返回主菜单请求
 
+    void handleLevelFileChanged(const QString& path);
+    void reloadWatchedLevel();
+    // 渲染比例（DPR × 视图缩放）变化后换上重新光栅化的矢量贴图
+    void refreshSprites();
+
 private:
     // --- Game State Members ---
     bool m_gameOver; // 主要用于标记生命耗尽的游戏结束状态
-    int m_currentTrackIndex;
-    qreal m_currentAngle;
-    qreal m_orbitOffset;
-    bool m_canTakeDamage;
+    bool m_gamePrepared; // prepareGame 已经完成、还没有 startGame
+    OrbitSimulation m_simulation; // 轨道/角度/速度/生命/物品状态与判定规则都在这里
+    OrbitSimState m_previousSimState; // 上一个固定步长结束时的状态，用于插值绘制
 
-    // --- Movement and Speed ---
-    qreal m_linearSpeed;
-    int m_rotationDirection;
+    // --- Fixed Timestep ---
+    QElapsedTimer m_frameClock;  // 单调时钟，测量两帧之间真实流逝的时间
+    qint64 m_lastFrameNsecs;
+    qreal m_stepAccumulator;     // 尚未模拟的剩余时间（秒）
 
-    // --- Score and Difficulty ---
-    int m_score;
-    int m_speedLevel;
+    // --- Replay ---
+    OrbitReplay m_replay;  // 本局的 K/J 输入记录，结束时写入 replays 目录，可以用 orbitreplaytool 校验
+    bool m_replaySaved;
 
-    // --- Health System ---
-    const int m_maxHealth = 10;
-    int m_health;
+    // --- Input Timestamps ---
+    // QKeyEvent::timestamp() 与 m_frameClock 的时钟原点不同，这里记录两者的差（毫秒）
+    qint64 m_inputClockOffsetMsecs;
+    bool m_inputClockSynced;
 
     // --- Core Graphics Items ---
     QGraphicsPixmapItem *m_ball;
     QGraphicsEllipseItem *m_targetDot;
     QList<QGraphicsEllipseItem*> m_trackItems;
-    QGraphicsPixmapItem *m_sunItem;
-    QGraphicsPixmapItem *m_mercuryItem;
-    QGraphicsPixmapItem *m_venusItem;
-    QGraphicsPixmapItem *m_earthItem;
-    QGraphicsPixmapItem *m_marsItem;
-    QGraphicsPixmapItem *m_jupiterItem;
-    QGraphicsPixmapItem *m_saturnItem;
-    QGraphicsPixmapItem *m_uranusItem;
-    QGraphicsPixmapItem *m_neptuneItem;
     EndTriggerItem *m_endTriggerPoint; // <--- 通关触发点 (使用新类)
 
 
+    // --- Scenery ---
+    // 关卡里的装饰（太阳、行星等）。先只记下位置，镜头接近时才解码、缩放图片并加入场景
+    struct SceneryEntry {
+        SceneryData data;
+        QGraphicsPixmapItem* item; // 还没加载时为 nullptr
+    };
+    std::vector<SceneryEntry> m_scenery;
+    int m_pendingSceneryCount; // 还没加载的装饰数，为 0 时不必再检查
+
     // --- Background Elements ---
     QList<QGraphicsPixmapItem*> m_backgroundTiles;
     QPixmap m_backgroundTilePixmap;
@@ -142,14 +176,33 @@ private:
     // --- Timers ---
     QTimer *m_timer;
     QTimer *m_judgmentTimer;
-    QTimer *m_damageCooldownTimer;
 
     // --- Level Data ---
-    TrackData m_levelData;
+    TrackData m_levelData;         // 驻留的轨道；流式加载时只是整关中的一段
+    std::shared_ptr<CompiledLevel> m_compiledLevel; // 从 .orbl 加载时保持映射（可能是 LevelPrefetcher 提前打开的）
+    bool m_streamingLevel;         // 从 m_compiledLevel 按窗口加载
+    int m_windowFirstTrack;        // m_levelData.segments[0] 在整关中的编号
+    int m_windowFirstCollectible;  // m_collectibles[0] 在整关中的编号
+    int m_windowFirstObstacle;     // m_obstacles[0] 在整关中的编号
+    bool m_endlessMode;            // 轨道由 m_trackGenerator 边走边生成，没有终点
+    quint32 m_endlessSeed;
+    TrackGenerator m_trackGenerator;
+    LevelPack m_levelPack;               // 关卡的顺序与文件，来自 levels.json
+    int m_currentLevel;                  // 正在玩 m_levelPack 中的第几关
+    LevelPrefetcher m_levelPrefetcher;   // 玩当前关时在后台读好下一关
+    QString m_hotReloadPath;             // 热重载的关卡 JSON，空表示使用资源里的关卡
+    QFileSystemWatcher *m_levelWatcher;
+    QTimer *m_levelReloadTimer;          // 编辑器一次保存可能触发好几次通知，合并成一次重载
 
     // --- Game Object Lists ---
+    // 只包含驻留轨道上的物品，顺序与 m_levelData 一致
     QList<CollectibleItem*> m_collectibles;
     QList<ObstacleItem*> m_obstacles;
+    // 移出窗口的图元放回池中（隐藏，仍在场景里），加载新轨道时优先复用，
+    // 避免每条轨道都重新加载贴图和音效；池的大小不超过一个窗口
+    QList<QGraphicsEllipseItem*> m_trackItemPool;
+    QList<CollectibleItem*> m_collectiblePool;
+    QList<ObstacleItem*> m_obstaclePool;
 
     // --- Audio ---
     QMediaPlayer *m_backgroundMusicPlayer;
@@ -164,6 +217,9 @@ private:
     QMovie *m_collectEffectMovie;
     QGraphicsPixmapItem *m_collectEffectItem;
     QTimer *m_collectEffectDurationTimer;
+    // 两个动画按显示尺寸缩放好的每一帧（来自 AssetRegistry），第一次播放时取用，之后每帧不再缩放
+    QVector<QPixmap> m_explosionFrames;
+    QVector<QPixmap> m_collectEffectFrames;
 
     // --- Font Family Names ---
     QString m_englishFontFamily;
@@ -172,19 +228,39 @@ private:
 
     // --- Private Helper Functions ---
     bool loadLevelData(const QString& filename);
+    // 动画第 frameNumber 帧的显示图片；缓存里没有这一帧时退回缩放 QMovie 的当前帧
+    QPixmap explosionFrame(int frameNumber);
+    QPixmap collectEffectFrame(int frameNumber);
     void addTrackItem(const TrackSegmentData& segmentData);
-
-    void updateBallPosition();
+    // 为整关第 trackIndex 条轨道创建轨道图元和物品（追加到驻留列表末尾）
+    void addSegmentItems(const TrackSegmentData& segmentData, int trackIndex);
+    // 优先从池中取图元，没有时新建（未加入驻留列表，也未定位）
+    CollectibleItem* takeCollectibleItem(int trackIndex, const CollectibleData& data);
+    ObstacleItem* takeObstacleItem(int trackIndex, const ObstacleData& data);
+    // 按当前轨道移动驻留窗口：丢弃身后的轨道，加载前方的轨道，并同步给 m_simulation
+    void updateLevelWindow();
+    int levelTrackCount() const; // 整关的轨道数
+    TrackSegmentData streamedSegment(int trackIndex); // 流式加载时第 trackIndex 条轨道的数据
+    const TrackSegmentData* residentSegment(int trackIndex) const; // 不在窗口内时返回 nullptr
+    void setupEndTrigger();   // 按 m_levelData.endTrigger 创建通关点并交给 m_simulation
+    void setupScenery();      // 按 m_levelData.scenery 登记装饰（不加载图片）
+    void clearScenery();
+    void updateScenery(const QRectF& visibleRect); // 加载接近视野的装饰
+    quint64 currentLevelHash() const;
+
+    void updateBallPosition(qreal interpolation = 1.0);
     void updateTargetDotPosition();
-    void switchTrack();
     void endGame(); // 这是生命耗尽时的游戏结束处理
+    void handleLevelCompleted(); // 飞船碰到通关点
 
     void updateHealthDisplay();
-    void updateScoreDisplayAndSpeed();
+    void updateScoreDisplay();
+    void showJudgmentText(OrbitJudgment judgment);
 
-    void checkTrackCollisions();
-    void checkBallCollectibleCollisions();
-    void checkBallObstacleCollisions();
+    void processSimulationEvents(); // 把 m_simulation 产生的事件转成特效/音效/HUD 更新
+    qreal simulationTimeForEvent(const QInputEvent* event); // 把输入事件的时间戳换算成模拟时间
+    void queueRecordedInput(OrbitInput input, const QInputEvent* event); // 记录到 m_replay 并交给 m_simulation
+    void saveReplay();
 
     void clearAllGameItems();
     void clearAllCollectibles();
@@ -0,0 +1,164 @@
+// 文件: levelpack.cpp
+#include "levelpack.h"
+#include "compiledlevel.h"
+#include "threadpooltask.h"
+#include <memory>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDebug>
+
+QString LevelPackEntry::preferredFile() const
+{
+    return (!compiledFile.isEmpty() && QFile::exists(compiledFile)) ? compiledFile : file;
+}
+
+bool LevelPack::loadManifest(const QString& path, QString* errorString)
+{
+    auto fail = [&](const QString& message) {
+        qWarning() << "LevelPack:" << message;
+        if (errorString) *errorString = message;
+        return false;
+    };
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return fail(QString("cannot open %1: %2").arg(path, file.errorString()));
+    }
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (!document.isObject()) {
+        return fail(QString("%1 is not a level pack: %2").arg(path, parseError.errorString()));
+    }
+
+    const QDir baseDir = QFileInfo(path).dir();
+    std::vector<LevelPackEntry> levels;
+    const QJsonArray levelArray = document.object().value("levels").toArray();
+    for (const QJsonValue& value : levelArray) {
+        const QJsonObject object = value.toObject();
+        LevelPackEntry entry;
+        entry.id = object.value("id").toString();
+        entry.name = object.value("name").toString(entry.id);
+        const QString file = object.value("file").toString();
+        const QString compiled = object.value("compiled").toString();
+        if (entry.id.isEmpty() || file.isEmpty()) {
+            qWarning() << "LevelPack: skipping a level without an id or file in" << path;
+            continue;
+        }
+        entry.file = baseDir.filePath(file);
+        entry.compiledFile = compiled.isEmpty() ? QString() : baseDir.filePath(compiled);
+        levels.push_back(entry);
+    }
+    if (levels.empty()) {
+        return fail(QString("%1 does not list any levels").arg(path));
+    }
+
+    m_levels = std::move(levels);
+    qDebug() << "LevelPack: loaded" << m_levels.size() << "levels from" << path;
+    return true;
+}
+
+void LevelPack::setBuiltInLevels()
+{
+    LevelPackEntry entry;
+    entry.id = "level1";
+    entry.name = "level1";
+    entry.file = ":/levels/level1.json";
+    entry.compiledFile = ":/levels/level1.orbl";
+    m_levels.assign(1, entry);
+}
+
+int LevelPack::indexOf(const QString& id) const
+{
+    for (size_t i = 0; i < m_levels.size(); ++i) {
+        if (m_levels[i].id == id) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+LevelPrefetcher::~LevelPrefetcher()
+{
+    // 等还在预读的后台任务结束（见 threadpooltask.h）
+    m_future.waitForFinished();
+}
+
+void LevelPrefetcher::prefetch(const QString& path, int windowTracks)
+{
+    if (path == m_path && m_future.isValid()) return;
+
+    cancel();
+    m_path = path;
+    // CompiledLevel 持有的 QFile 是 QObject，要在使用并销毁它的主线程里创建，所以 .orbl 在这里打开；
+    // 后台任务只从映射里拷出第一段窗口（或者解析 JSON）
+    m_compiled = openCompiled(path);
+    const CompiledLevel* compiled = m_compiled.get();
+    m_future = runInThreadPool<PreparedLevel>([path, windowTracks, compiled]() {
+        return read(path, windowTracks, compiled);
+    });
+    qDebug() << "LevelPrefetcher: preparing" << path << "in the background";
+}
+
+bool LevelPrefetcher::take(const QString& path, PreparedLevel* prepared)
+{
+    if (path != m_path || !m_future.isValid()) return false;
+
+    m_future.waitForFinished(); // 玩家比后台还快时等它读完，仍然比从头开始读要快
+    // 结果只取一次，整关的 TrackData 移动出来，不拷贝
+    PreparedLevel result = m_future.resultCount() > 0 ? m_future.takeResult() : PreparedLevel();
+    std::shared_ptr<CompiledLevel> compiled = std::move(m_compiled);
+    cancel();
+    if (!result.ok) return false;
+    result.compiled = std::move(compiled);
+    *prepared = std::move(result);
+    return true;
+}
+
+void LevelPrefetcher::cancel()
+{
+    // 后台任务可能还在读 m_compiled 的映射，等它拷完再释放（只是第一段窗口，很快）；解析 JSON 的任务不用等
+    if (m_compiled) m_future.waitForFinished();
+    m_compiled.reset();
+    m_path.clear();
+    m_future = QFuture<PreparedLevel>();
+}
+
+PreparedLevel LevelPrefetcher::prepare(const QString& path, int windowTracks)
+{
+    std::shared_ptr<CompiledLevel> compiled = openCompiled(path);
+    PreparedLevel prepared = read(path, windowTracks, compiled.get());
+    if (prepared.ok) prepared.compiled = std::move(compiled);
+    return prepared;
+}
+
+std::shared_ptr<CompiledLevel> LevelPrefetcher::openCompiled(const QString& path)
+{
+    if (!path.endsWith(".orbl")) return nullptr;
+    auto compiled = std::make_shared<CompiledLevel>();
+    compiled->open(path); // 失败时已经给出警告，read() 按 isOpen() 报告失败
+    return compiled;
+}
+
+PreparedLevel LevelPrefetcher::read(const QString& path, int windowTracks, const CompiledLevel* compiled)
+{
+    PreparedLevel prepared;
+    prepared.path = path;
+    if (compiled) {
+        // 编译好的关卡：拷出第一段窗口、装饰和通关点，其余轨道留在映射里按窗口加载
+        prepared.ok = compiled->isOpen();
+        if (prepared.ok) {
+            compiled->appendSegments(0, qMin(compiled->segmentCount(), windowTracks), &prepared.level);
+            // 装饰只是位置和路径，很小，全部读出来；图片仍然等镜头接近时再加载
+            for (int i = 0; i < compiled->sceneryCount(); ++i) {
+                prepared.level.scenery.push_back(compiled->sceneryData(i));
+            }
+            prepared.level.endTrigger = compiled->endTrigger();
+        }
+    } else {
+        prepared.ok = prepared.level.loadLevelFromFile(path);
+    }
+    if (!prepared.ok) qWarning() << "LevelPrefetcher: failed to prepare" << path;
+    return prepared;
+}
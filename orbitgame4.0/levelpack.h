@@ -0,0 +1,97 @@
+#ifndef LEVELPACK_H
+#define LEVELPACK_H
+
+#include <memory>
+#include <vector>
+#include <QString>
+#include <QFuture>
+
+#include "trackdata.h"
+
+class CompiledLevel;
+
+// ==========================================================================
+// LevelPack: 关卡包清单（levels.json），按顺序列出所有关卡及其元数据:
+// {
+//     "levels": [
+//         { "id": "level1", "name": "太阳系", "file": "level1.json", "compiled": "level1.orbl" }
+//     ]
+// }
+// file 是关卡 JSON，compiled 是 orbitlevelcompiler 编译好的版本（可选，存在时优先使用）。
+// 游戏构建时会编译 compiled 里写的所有关卡并编进资源（见 orbitgame2.pro），仓库里只有 JSON。
+// 相对路径相对于清单所在的目录，所以清单放在资源里时写文件名即可。
+//
+// LevelPrefetcher: 玩当前关卡时在线程池里提前准备好下一关（解析 JSON，或者映射 .orbl 并拷出第一段窗口），
+// 换关时直接拿结果，主线程只剩创建场景物品。
+// ==========================================================================
+
+const char* const DEFAULT_LEVEL_PACK_PATH = ":/levels/levels.json";
+
+struct LevelPackEntry {
+    QString id;
+    QString name;
+    QString file;         // 关卡 JSON 的完整路径
+    QString compiledFile; // 编译好的 .orbl 的完整路径，没有时为空
+
+    // 游戏实际加载的文件: 有编译好的版本就用它（直接映射，不需要解析）
+    QString preferredFile() const;
+};
+
+class LevelPack
+{
+public:
+    // 读取清单。失败时保留原来的内容，返回 false 并写入 errorString
+    bool loadManifest(const QString& path, QString* errorString = nullptr);
+    // 没有清单时退回只有内置第一关的关卡包
+    void setBuiltInLevels();
+
+    int levelCount() const { return static_cast<int>(m_levels.size()); }
+    const LevelPackEntry& level(int index) const { return m_levels[index]; }
+    int indexOf(const QString& id) const; // 找不到时返回 -1
+
+private:
+    std::vector<LevelPackEntry> m_levels;
+};
+
+// 后台准备好的关卡
+struct PreparedLevel {
+    QString path;
+    bool ok = false;
+    // JSON 关卡: 解析好的整关。
+    // .orbl 关卡: 前 windowTracks 条轨道（流式加载的第一段窗口）、全部装饰和通关点
+    TrackData level;
+    // .orbl 关卡已经映射并检查过的文件，其余轨道按窗口从这里读；JSON 关卡为空。
+    // 它持有的 QFile 是 QObject，总是在主线程打开和释放
+    std::shared_ptr<CompiledLevel> compiled;
+};
+
+class LevelPrefetcher
+{
+public:
+    ~LevelPrefetcher();
+
+    // 在线程池中开始准备 path（.orbl 关卡准备前 windowTracks 条轨道）。
+    // 已经在准备同一个文件时什么也不做；准备别的文件时丢弃旧结果
+    void prefetch(const QString& path, int windowTracks);
+    // 取走 path 的准备结果（还没准备完时等待它完成）。没有为 path 预读过，或者预读失败时返回 false，
+    // 调用方照常同步加载
+    bool take(const QString& path, PreparedLevel* prepared);
+    // 丢弃还没取走的结果（正在运行的任务会跑完，但结果不再使用）
+    void cancel();
+
+    // 在当前线程里准备一个关卡文件（没有预读时 GameScene 直接调用）
+    static PreparedLevel prepare(const QString& path, int windowTracks);
+
+private:
+    // .orbl 关卡: 打开并检查文件头（只做映射，耗时与关卡大小无关）；失败时 isOpen() 为 false。
+    // 不是 .orbl 时返回空指针
+    static std::shared_ptr<CompiledLevel> openCompiled(const QString& path);
+    // 读出关卡数据（不设置 compiled）。compiled 为 openCompiled 的结果，只读它的映射，可以在任意线程调用
+    static PreparedLevel read(const QString& path, int windowTracks, const CompiledLevel* compiled);
+
+    QString m_path;
+    std::shared_ptr<CompiledLevel> m_compiled; // 在主线程打开，后台任务只读它的映射
+    QFuture<PreparedLevel> m_future;
+};
+
+#endif // LEVELPACK_H
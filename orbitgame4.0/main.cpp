@@ -1,12 +1,38 @@
 #include "mainwindow.h"
+#include "assetregistry.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFileInfo>
 
 int main(int argc, char *argv[])
 {
+    QElapsedTimer launchClock; // 从启动到开始界面第一帧的时间，见 MainWindow::eventFilter
+    launchClock.start();
     QApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption levelOption("level",
+                                   "Load the level from this JSON file instead of the built-in one, "
+                                   "and reload it in place whenever it is saved (for level editing).", "level.json");
+    parser.addOption(levelOption);
+    parser.process(a);
+
+    // 单独构建 orbitgame2.pro 时原图和媒体直接编进了程序 (ORBIT_EMBEDDED_ASSETS)，不需要外部资源包
+#ifndef ORBIT_EMBEDDED_ASSETS
+    // 视频和背景音乐在程序旁边的 media.rcc 里，要在创建播放器之前注册
+    AssetRegistry::registerMediaBundle();
+    // 没烘焙过的尺寸要从 sprites.rcc 里的原图缩放
+    AssetRegistry::registerSpriteBundle();
+#endif
+
     MainWindow w;
+    w.setLaunchClock(launchClock);
+    if (parser.isSet(levelOption)) {
+        w.setHotReloadLevel(QFileInfo(parser.value(levelOption)).absoluteFilePath());
+    }
     w.show();
     return a.exec();
 }
-
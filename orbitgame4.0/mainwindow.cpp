@@ -1,13 +1,18 @@
 #include "mainwindow.h"
 #include "gamescene.h" // 确保 GameScene 的定义可见
 #include "startscene.h"
+#include "assetregistry.h"
 #include <QGraphicsView>
 #include <QMediaPlayer>
 #include <QVideoWidget>
+#include <QVideoSink>
+#include <QVideoFrame>
 #include <QStackedWidget>
 #include <QUrl>
 #include <QDebug>
 #include <QResizeEvent>
+#include <QRandomGenerator>
+#include <QTimer>
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -18,9 +23,14 @@ MainWindow::MainWindow(QWidget *parent)
     , m_mediaPlayer(nullptr)
     , m_videoWidget(nullptr)
     , m_mainStackedWidget(nullptr)
+    , m_resizeSettleTimer(nullptr)
     , m_currentGameState(GameState::ShowingStartScreen)
+    , m_firstFrameShown(false)
+    , m_videoFrameReady(false)
+    , m_waitingForVideoFrame(false)
 {
     setupCustomUiElements();
+    updateRenderScale();
     showStartScreen();
 }
 
@@ -29,6 +39,61 @@ MainWindow::~MainWindow()
     cleanupMediaPlayer();
 }
 
+void MainWindow::setHotReloadLevel(const QString& path)
+{
+    m_hotReloadLevelPath = path; // GameScene 可能还没创建，创建时再交给它
+    if (m_gameScene) m_gameScene->setHotReloadLevel(path);
+}
+
+void MainWindow::setLaunchClock(const QElapsedTimer& clock)
+{
+    m_launchClock = clock;
+}
+
+GameScene* MainWindow::ensureGameScene()
+{
+    if (m_gameScene) return m_gameScene;
+
+    QElapsedTimer constructionClock;
+    constructionClock.start();
+    m_gameScene = new GameScene(this); // 构造只准备计时器、动画和播放器，关卡在 initializeGame 时才加载
+    if (!m_hotReloadLevelPath.isEmpty()) {
+        m_gameScene->setHotReloadLevel(m_hotReloadLevelPath);
+    }
+
+    bool connReturn = connect(m_gameScene, &GameScene::returnToStartScreenRequested,
+                              this, &MainWindow::handleReturnToStartScreen);
+    qDebug() << "Connection [GameScene::returnToStartScreenRequested -> MainWindow::handleReturnToStartScreen] successful:" << connReturn;
+
+    bool connEndVideo = connect(m_gameScene, &GameScene::endGameVideoRequested,
+                                this, &MainWindow::handleEndGameVideoRequestedProcessing);
+    qDebug() << "Connection [GameScene::endGameVideoRequested -> MainWindow::handleEndGameVideoRequestedProcessing] successful:" << connEndVideo;
+
+    // 最后一关开始时就把结束视频打开并解码出第一帧，通关时可以直接切过去
+    connect(m_gameScene, &GameScene::lastLevelStarted, this, [this]() {
+        prerollVideo(END_VIDEO_PATH);
+    });
+
+    qDebug() << "MainWindow: GameScene created in" << constructionClock.elapsed() << "ms";
+    return m_gameScene;
+}
+
+bool MainWindow::eventFilter(QObject *watched, QEvent *event)
+{
+    if (!m_firstFrameShown && m_graphicsView && watched == m_graphicsView->viewport() && event->type() == QEvent::Paint) {
+        m_firstFrameShown = true;
+        if (m_launchClock.isValid()) {
+            qInfo() << "MainWindow: first StartScene frame" << m_launchClock.elapsed() << "ms after launch";
+        }
+        // 开始界面已经出现，趁玩家看菜单的时候创建 GameScene，并让线程池开始解码第一关的图片
+        QTimer::singleShot(0, this, [this]() {
+            ensureGameScene()->preloadAssets();
+            if (m_currentGameState == GameState::ShowingStartScreen) prerollVideo(INTRO_VIDEO_PATH);
+        });
+    }
+    return QMainWindow::eventFilter(watched, event);
+}
+
 void MainWindow::setupCustomUiElements()
 {
     m_mainStackedWidget = new QStackedWidget(this);
@@ -44,11 +109,28 @@ void MainWindow::setupCustomUiElements()
     m_mainStackedWidget->addWidget(m_videoWidget);
 
     m_startScene = new StartScene(this);
-    m_gameScene = new GameScene(this); // GameScene 实例在这里创建
+    m_resizeSettleTimer = new QTimer(this);
+    m_resizeSettleTimer->setSingleShot(true);
+    m_resizeSettleTimer->setInterval(RESIZE_SETTLE_MS);
+    connect(m_resizeSettleTimer, &QTimer::timeout, this, [this]() {
+        // 窗口停下来了：按最终尺寸缩放背景（结果按尺寸缓存，来回切换同样的尺寸不会再缩放）
+        if (m_startScene && m_graphicsView && m_currentGameState == GameState::ShowingStartScreen) {
+            m_startScene->setupUi(m_graphicsView->size());
+        }
+    });
+    // GameScene 不在这里创建: 开始界面第一帧画出来之后再在空闲时创建（见 ensureGameScene / eventFilter），
+    // 启动时只需要准备开始界面
+    m_graphicsView->viewport()->installEventFilter(this);
 
     // 初始化 QMediaPlayer
     m_mediaPlayer = new QMediaPlayer(this);
     m_mediaPlayer->setVideoOutput(m_videoWidget); // 只需要设置一次 Video Output
+    // 视频的第一帧解码出来之后才切到 m_videoWidget，之前一直显示原来的画面（见 showVideoWhenFrameReady）
+    connect(m_videoWidget->videoSink(), &QVideoSink::videoFrameChanged, this, [this](const QVideoFrame& frame) {
+        if (m_videoFrameReady || !frame.isValid()) return;
+        m_videoFrameReady = true;
+        if (m_waitingForVideoFrame) showVideoWhenFrameReady();
+    });
     connect(m_mediaPlayer, QOverload<QMediaPlayer::Error, const QString &>::of(&QMediaPlayer::errorOccurred),
             this, [this](QMediaPlayer::Error error, const QString &errorString){
                 qWarning() << "Video Player Error (Current State: " << static_cast<int>(m_currentGameState) << "):" << error << errorString;
@@ -59,26 +141,15 @@ void MainWindow::setupCustomUiElements()
                 } else if (m_currentGameState == GameState::PlayingEndVideo) {
                     showStartScreen();
                 } else {
-                    showStartScreen(); // 默认返回开始界面
+                    // 预载失败（开始界面或游戏中）：不打断当前画面，真正播放时 playIntroVideo/playEndVideo 会跳过这个视频
+                    qWarning() << "Video preroll failed, the video will be skipped.";
                 }
             });
 
 
     connect(m_startScene, &StartScene::startGameClicked, this, &MainWindow::handleStartGameClicked);
     connect(m_startScene, &StartScene::tutorialClicked, this, &MainWindow::handleTutorialClicked);
-
-    qDebug() << "MainWindow::setupCustomUiElements - m_gameScene pointer:" << m_gameScene;
-    if (m_gameScene) {
-        bool connReturn = connect(m_gameScene, &GameScene::returnToStartScreenRequested,
-                                  this, &MainWindow::handleReturnToStartScreen);
-        qDebug() << "Connection [GameScene::returnToStartScreenRequested -> MainWindow::handleReturnToStartScreen] successful:" << connReturn;
-
-        bool connEndVideo = connect(m_gameScene, &GameScene::endGameVideoRequested,
-                                    this, &MainWindow::handleEndGameVideoRequestedProcessing);
-        qDebug() << "Connection [GameScene::endGameVideoRequested -> MainWindow::handleEndGameVideoRequestedProcessing] successful:" << connEndVideo;
-    } else {
-        qWarning() << "MainWindow::setupCustomUiElements - m_gameScene is null, cannot connect signals!";
-    }
+    connect(m_startScene, &StartScene::endlessGameClicked, this, &MainWindow::handleEndlessGameClicked);
 
     resize(800,600);
 }
@@ -88,6 +159,7 @@ void MainWindow::showStartScreen()
 {
     qDebug() << "MainWindow::showStartScreen() CALLED.";
     setCurrentGameState(GameState::ShowingStartScreen);
+    m_waitingForVideoFrame = false;
 
     if (m_mediaPlayer && m_mediaPlayer->playbackState() != QMediaPlayer::StoppedState) {
         qDebug() << "MainWindow::showStartScreen - Stopping media player.";
@@ -110,14 +182,60 @@ void MainWindow::showStartScreen()
     } else {
         qWarning() << "MainWindow::showStartScreen() - One or more UI elements are null!";
     }
+
+    // 玩家看菜单的时候预载开场视频。启动时第一帧还没画出来，交给 eventFilter 在第一帧之后再做
+    if (m_firstFrameShown) prerollVideo(INTRO_VIDEO_PATH);
+}
+
+void MainWindow::prerollVideo(const QString& resourcePath)
+{
+    const QUrl url = AssetRegistry::mediaUrl(resourcePath);
+    if (!m_mediaPlayer || url.isEmpty() || !url.isValid()) return;
+    if (m_mediaPlayer->source() == url && m_mediaPlayer->playbackState() == QMediaPlayer::PausedState) return; // 已经预载好了
+
+    m_videoFrameReady = false;
+    if (m_mediaPlayer->source() == url) {
+        m_mediaPlayer->setPosition(0); // 同一个视频 setSource 不会重新打开，回到开头即可
+    } else {
+        m_mediaPlayer->setSource(url);
+    }
+    // 暂停状态下后端会打开文件并解码出第一帧（m_videoWidget 不在前台，看不到），之后 play() 立即就有画面
+    m_mediaPlayer->pause();
+    qDebug() << "MainWindow::prerollVideo -" << url.toString();
+}
+
+void MainWindow::showVideoWhenFrameReady()
+{
+    if (!m_mainStackedWidget || !m_videoWidget) return;
+    if (m_currentGameState != GameState::PlayingIntroVideo && m_currentGameState != GameState::PlayingEndVideo) {
+        m_waitingForVideoFrame = false;
+        return;
+    }
+    if (!m_videoFrameReady) {
+        m_waitingForVideoFrame = true; // 第一帧还没解码出来，先保留当前画面，避免切过去看到黑屏
+        return;
+    }
+    m_waitingForVideoFrame = false;
+    m_mainStackedWidget->setCurrentWidget(m_videoWidget);
+    qDebug() << "MainWindow: first video frame ready, switched to m_videoWidget.";
 }
 
 void MainWindow::handleStartGameClicked()
 {
     qDebug() << "MainWindow::handleStartGameClicked() CALLED.";
+    ensureGameScene()->setEndlessMode(false);
+    m_gameScene->setCurrentLevel(0);
     playIntroVideo();
 }
 
+void MainWindow::handleEndlessGameClicked()
+{
+    qDebug() << "MainWindow::handleEndlessGameClicked() CALLED.";
+    if (m_currentGameState != GameState::ShowingStartScreen) return;
+    ensureGameScene()->setEndlessMode(true, QRandomGenerator::global()->generate());
+    startGameplay(); // 无尽模式没有开场视频
+}
+
 void MainWindow::handleTutorialClicked()
 {
     qDebug() << "MainWindow::handleTutorialClicked()";
@@ -129,21 +247,29 @@ void MainWindow::playIntroVideo()
     qDebug() << "MainWindow::playIntroVideo() CALLED.";
     setCurrentGameState(GameState::PlayingIntroVideo);
 
+    // 通常在开始界面时已经预载好，这里什么也不做。要在连接状态槽之前调用，换 source 时的 StoppedState 不能当成播放结束
+    prerollVideo(INTRO_VIDEO_PATH);
+
     // 断开可能存在的旧连接，连接到开场视频的状态处理槽
     disconnect(m_mediaPlayer, &QMediaPlayer::playbackStateChanged, nullptr, nullptr);
     connect(m_mediaPlayer, &QMediaPlayer::playbackStateChanged, this, &MainWindow::onIntroVideoStateChanged);
 
-    m_mediaPlayer->setSource(QUrl("qrc:/videos/intro_video.mp4"));
-
-    if (m_mediaPlayer->source().isEmpty() || !m_mediaPlayer->source().isValid()) {
-        qWarning() << "Intro video source is invalid or empty:" << m_mediaPlayer->source().toString();
+    if (m_mediaPlayer->source().isEmpty() || !m_mediaPlayer->source().isValid()
+        || m_mediaPlayer->error() != QMediaPlayer::NoError) {
+        qWarning() << "Intro video source is invalid or failed to load:" << m_mediaPlayer->source().toString();
         startGameplay(); // 直接开始游戏
         return;
     }
     if (m_mainStackedWidget && m_videoWidget) {
-        m_mainStackedWidget->setCurrentWidget(m_videoWidget);
         m_mediaPlayer->play();
+        showVideoWhenFrameReady();
         qDebug() << "Attempting to play intro video.";
+        // 视频播放期间主线程是空闲的，让线程池把游戏要用的图片解码好，
+        // 并在视频结束之前把整局（关卡、图元、HUD）准备好，视频结束后只需要开始计时
+        ensureGameScene()->preloadAssets();
+        QTimer::singleShot(0, this, [this]() {
+            if (m_currentGameState == GameState::PlayingIntroVideo && m_gameScene) m_gameScene->prepareGame();
+        });
     } else {
         qWarning() << "MainWindow::playIntroVideo - m_mainStackedWidget or m_videoWidget is null!";
         startGameplay(); // 无法播放，直接开始游戏
@@ -167,10 +293,12 @@ void MainWindow::startGameplay()
 {
     qDebug() << "MainWindow::startGameplay() CALLED.";
     setCurrentGameState(GameState::PlayingGame);
+    m_waitingForVideoFrame = false;
 
-    if (m_gameScene && m_graphicsView) {
-        m_gameScene->initializeGame();
+    if (ensureGameScene() && m_graphicsView) {
+        // 开场视频期间已经 prepareGame 过，这里只是把场景放进视图并开始计时；无尽模式没有视频，在这里准备
         m_graphicsView->setScene(m_gameScene);
+        m_gameScene->startGame();
     } else {
         qWarning() << "MainWindow::startGameplay() - m_gameScene or m_graphicsView is null!";
     }
@@ -196,21 +324,23 @@ void MainWindow::playEndVideo()
     qDebug() << "MainWindow::playEndVideo() CALLED.";
     setCurrentGameState(GameState::PlayingEndVideo);
 
+    // 最后一关开始时已经预载好（见 GameScene::lastLevelStarted）。同样要在连接状态槽之前调用
+    prerollVideo(END_VIDEO_PATH);
+
     // 断开可能存在的旧连接，连接到结束视频的状态处理槽
     disconnect(m_mediaPlayer, &QMediaPlayer::playbackStateChanged, nullptr, nullptr);
     connect(m_mediaPlayer, &QMediaPlayer::playbackStateChanged, this, &MainWindow::onEndVideoStateChanged);
 
-    m_mediaPlayer->setSource(QUrl("qrc:/videos/end_video.mp4")); // 结束视频的路径
-
-    if (m_mediaPlayer->source().isEmpty() || !m_mediaPlayer->source().isValid()) {
-        qWarning() << "End video source is invalid or empty:" << m_mediaPlayer->source().toString();
+    if (m_mediaPlayer->source().isEmpty() || !m_mediaPlayer->source().isValid()
+        || m_mediaPlayer->error() != QMediaPlayer::NoError) {
+        qWarning() << "End video source is invalid or failed to load:" << m_mediaPlayer->source().toString();
         showStartScreen(); // 视频源有问题，直接返回主菜单
         return;
     }
 
     if (m_mainStackedWidget && m_videoWidget) {
-        m_mainStackedWidget->setCurrentWidget(m_videoWidget);
         m_mediaPlayer->play();
+        showVideoWhenFrameReady(); // 第一帧出来之前游戏画面停在通关的那一刻
         qDebug() << "Attempting to play end video...";
     } else {
         qWarning() << "MainWindow::playEndVideo - m_mainStackedWidget or m_videoWidget is null!";
@@ -264,14 +394,34 @@ void MainWindow::setCurrentGameState(GameState newState)
 void MainWindow::resizeEvent(QResizeEvent *event)
 {
     QMainWindow::resizeEvent(event);
+    updateRenderScale(); // 旧版本 Qt 没有 DevicePixelRatioChange，换屏幕时至少会触发一次 resize
     if (m_graphicsView && m_graphicsView->scene()) {
         m_graphicsView->scene()->setSceneRect(0, 0, m_graphicsView->width(), m_graphicsView->height());
         if (m_startScene && m_currentGameState == GameState::ShowingStartScreen) {
-            m_startScene->setupUi(m_graphicsView->size());
+            // 拖动中每个事件只重新摆放图元（图片都是缓存好的），背景的平滑缩放等窗口停下来再做
+            m_startScene->setupUi(m_graphicsView->size(), true);
+            m_resizeSettleTimer->start();
         }
     }
 }
 
+void MainWindow::changeEvent(QEvent *event)
+{
+    QMainWindow::changeEvent(event);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 6, 0)
+    if (event->type() == QEvent::DevicePixelRatioChange) {
+        updateRenderScale();
+    }
+#endif
+}
+
+void MainWindow::updateRenderScale()
+{
+    // 视图目前不缩放（transform 为单位矩阵），以后加镜头缩放时矢量贴图也会跟着重新光栅化
+    const qreal zoom = m_graphicsView ? m_graphicsView->transform().m11() : 1.0;
+    AssetRegistry::instance()->setRenderScale(devicePixelRatioF() * zoom);
+}
+
 void MainWindow::handleReturnToStartScreen()
 {
     qDebug() << "MainWindow::handleReturnToStartScreen() CALLED. Calling showStartScreen().";
@@ -3,12 +3,18 @@
 
 #include <QMainWindow>
 #include <QMediaPlayer>
+#include <QElapsedTimer>
 
 class QGraphicsView;
 class GameScene;
 class StartScene;
 class QVideoWidget;
 class QStackedWidget;
+class QTimer;
+
+const char* const INTRO_VIDEO_PATH = ":/videos/intro_video.mp4";
+const char* const END_VIDEO_PATH = ":/videos/end_video.mp4";
+const int RESIZE_SETTLE_MS = 150; // 窗口大小这么久不变才按新尺寸重新缩放开始界面的图片
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -22,11 +28,19 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    // 关卡编辑模式（命令行 --level）：游戏从这个 JSON 文件加载关卡，保存后立即热重载
+    void setHotReloadLevel(const QString& path);
+    // 程序启动时开始计时的时钟，用来记录从启动到开始界面第一帧的时间
+    void setLaunchClock(const QElapsedTimer& clock);
+
 protected:
     void resizeEvent(QResizeEvent *event) override;
+    void changeEvent(QEvent *event) override;
+    bool eventFilter(QObject *watched, QEvent *event) override; // 监视开始界面的第一帧
 
 private slots:
     void handleStartGameClicked();
+    void handleEndlessGameClicked();
     void handleTutorialClicked();
     void onIntroVideoStateChanged(QMediaPlayer::PlaybackState state); // <--- 改名以区分
     void onEndVideoStateChanged(QMediaPlayer::PlaybackState state);   // <--- 改名以区分
@@ -50,6 +64,14 @@ private:
     void startGameplay();
     void cleanupMediaPlayer(); // <--- 改名，更通用
     void showTutorialScreen();
+    // 把当前的 设备像素比 × 视图缩放 告诉 AssetRegistry，矢量贴图按它光栅化
+    void updateRenderScale();
+    // 第一次需要时才创建 GameScene（启动时不创建，开始界面显示之后在空闲时创建）
+    GameScene* ensureGameScene();
+    // 预载视频：打开文件并解码出第一帧后暂停，下一次 play() 没有黑屏和停顿。已经预载好同一个视频时什么也不做
+    void prerollVideo(const QString& resourcePath);
+    // 视频第一帧已经解码时切到 m_videoWidget，否则等 videoFrameChanged 到来再切
+    void showVideoWhenFrameReady();
     Ui::MainWindow *ui;
     QGraphicsView *m_graphicsView;
     GameScene *m_gameScene;
@@ -57,6 +79,12 @@ private:
     QMediaPlayer *m_mediaPlayer;
     QVideoWidget *m_videoWidget;
     QStackedWidget *m_mainStackedWidget;
+    QTimer *m_resizeSettleTimer;   // 拖动窗口边缘时推迟开始界面的完整布局
     GameState m_currentGameState;
+    QString m_hotReloadLevelPath;  // 命令行 --level，GameScene 创建时交给它
+    QElapsedTimer m_launchClock;
+    bool m_firstFrameShown;
+    bool m_videoFrameReady;       // 当前 source 已经有解码好的帧
+    bool m_waitingForVideoFrame;  // 已经 play()，等第一帧到来再切到 m_videoWidget
 };
 #endif // MAINWINDOW_H
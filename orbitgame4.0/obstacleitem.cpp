@@ -1,8 +1,9 @@
 // 文件: obstacleitem.cpp
 #include "obstacleitem.h"
+#include "assetregistry.h"
 #include <QDebug>
 #include <QPixmap>
-#include <QUrl> // <--- 添加 QUrl 头文件
+#include <QSoundEffect>
 
 ObstacleItem::ObstacleItem(int associatedTrackIndex, qreal angleOnTrackRadians,
                            QGraphicsItem *parent)
@@ -17,32 +18,14 @@ ObstacleItem::ObstacleItem(int associatedTrackIndex, qreal angleOnTrackRadians,
     << "associatedTrackIndex received:" << associatedTrackIndex
     << "angle (rad):" << angleOnTrackRadians;
 
-    QPixmap originalPixmap(":/images/obstacle.png");
-
-    if (originalPixmap.isNull()) {
-        qWarning() << "Failed to load obstacle image ':/images/obstacle.png'. Using fallback blue square.";
-        QPixmap fallbackPixmap(static_cast<int>(DEFAULT_OBSTACLE_TARGET_SIZE), static_cast<int>(DEFAULT_OBSTACLE_TARGET_SIZE));
-        fallbackPixmap.fill(Qt::blue);
-        setPixmap(fallbackPixmap);
-    } else {
-        QPixmap scaledPixmap = originalPixmap.scaled(static_cast<int>(DEFAULT_OBSTACLE_TARGET_SIZE),
-                                                     static_cast<int>(DEFAULT_OBSTACLE_TARGET_SIZE),
-                                                     Qt::KeepAspectRatio,
-                                                     Qt::SmoothTransformation);
-        setPixmap(scaledPixmap);
-    }
-
-    if (!pixmap().isNull()) {
-        setTransformOriginPoint(pixmap().width() / 2.0, pixmap().height() / 2.0);
-    }
+    refreshPixmap();
+    setShapeMode(QGraphicsPixmapItem::BoundingRectShape); // 命中判定在 OrbitSimulation 中按半径计算
 
     setZValue(0.6);
     setVisible(false);
 
-    // 初始化受击音效
-    m_hitSoundEffect.setSource(QUrl("qrc:/sounds/hit.wav")); // <--- 设置音效文件路径 (对应 .qrc 中的 alias)
-    m_hitSoundEffect.setVolume(0.8); // 可选: 设置音量
-    // m_hitSoundEffect.setLoopCount(1);
+    // 受击音效: 同类物品共用 AssetRegistry 里的几个 QSoundEffect，不必每个物品各加载一遍
+    AssetRegistry::instance()->preloadSound("qrc:/sounds/hit.wav", 0.8);
 }
 
 ObstacleItem::~ObstacleItem()
@@ -56,17 +39,49 @@ void ObstacleItem::processHit()
         m_isHit = true;
         setVisible(false);
 
-        // 播放受击音效
-        if (m_hitSoundEffect.isLoaded()) { // 检查音效是否已成功加载
-            m_hitSoundEffect.play();
+        // 播放受击音效（每次取一个实例，连续受击时不会打断上一次）
+        QSoundEffect* hitSound = AssetRegistry::instance()->sound("qrc:/sounds/hit.wav", 0.8);
+        if (hitSound->isLoaded()) { // 检查音效是否已成功加载
+            hitSound->play();
         } else {
-            qWarning() << "Hit sound (qrc:/sounds/hit.wav) not loaded or error: " << m_hitSoundEffect.status();
+            qWarning() << "Hit sound (qrc:/sounds/hit.wav) not loaded or error: " << hitSound->status();
         }
 
         emit hitSignal(this);
     }
 }
 
+void ObstacleItem::reuse(int associatedTrackIndex, qreal angleOnTrackRadians)
+{
+    m_associatedTrackIndex = associatedTrackIndex;
+    m_angleOnTrack = angleOnTrackRadians;
+    m_isHit = false;
+    m_orbitOffset = 0;
+    setVisible(false); // 与构造后一样，定位之后再显示
+}
+
+void ObstacleItem::refreshPixmap()
+{
+    // 贴图由 AssetRegistry 共享: 每关几百个物品只解码、缩放一次
+    QPixmap scaledPixmap = AssetRegistry::instance()->pixmap(":/images/obstacle.png",
+                                                            QSize(static_cast<int>(DEFAULT_OBSTACLE_TARGET_SIZE),
+                                                                  static_cast<int>(DEFAULT_OBSTACLE_TARGET_SIZE)));
+
+    if (scaledPixmap.isNull()) {
+        qWarning() << "Failed to load obstacle image ':/images/obstacle.png'. Using fallback blue square.";
+        QPixmap fallbackPixmap(static_cast<int>(DEFAULT_OBSTACLE_TARGET_SIZE), static_cast<int>(DEFAULT_OBSTACLE_TARGET_SIZE));
+        fallbackPixmap.fill(Qt::blue);
+        setPixmap(fallbackPixmap);
+    } else {
+        setPixmap(scaledPixmap);
+    }
+
+    if (!pixmap().isNull()) {
+        const QSizeF logicalSize = pixmap().deviceIndependentSize(); // 矢量贴图的像素数是逻辑尺寸的 DPR 倍
+        setTransformOriginPoint(logicalSize.width() / 2.0, logicalSize.height() / 2.0);
+    }
+}
+
 // ... (其他 ObstacleItem 的方法保持不变) ...
 
 bool ObstacleItem::isHit() const
@@ -102,8 +117,9 @@ void ObstacleItem::updateVisualPosition(const QPointF& trackCenter, qreal trackR
     qreal y_center = trackCenter.y() + effectiveOrbitRadius * qSin(m_angleOnTrack);
 
     if (!pixmap().isNull()) {
-        setPos(x_center - pixmap().width() / 2.0,
-               y_center - pixmap().height() / 2.0);
+        const QSizeF logicalSize = pixmap().deviceIndependentSize();
+        setPos(x_center - logicalSize.width() / 2.0,
+               y_center - logicalSize.height() / 2.0);
     } else {
         setPos(x_center, y_center);
     }
@@ -7,10 +7,10 @@
 #include <QtMath>
 #include <QRandomGenerator>
 #include <QPixmap>
-#include <QSoundEffect> // <--- 添加 QSoundEffect 头文件
+
+#include "orbitsimulation.h" // DEFAULT_OBSTACLE_TARGET_SIZE
 
 // 障碍物常量
-const qreal DEFAULT_OBSTACLE_TARGET_SIZE = 25.0;
 const qreal OBSTACLE_ORBIT_PADDING = 0.0;
 
 class ObstacleItem : public QObject, public QGraphicsPixmapItem
@@ -24,6 +24,10 @@ public:
 
     void processHit();
     bool isHit() const;
+    // 流式关卡回收图元：换到另一条轨道上的新位置，恢复成未撞过（不必重新加载贴图和音效）
+    void reuse(int associatedTrackIndex, qreal angleOnTrackRadians);
+    // 重新向 AssetRegistry 取贴图（渲染比例变化后矢量贴图会重新光栅化）
+    void refreshPixmap();
 
     int getAssociatedTrackIndex() const;
     qreal getAngleOnTrack() const;
@@ -42,7 +46,6 @@ private:
     qreal m_angleOnTrack;
     bool m_isHit;
     qreal m_orbitOffset;
-    QSoundEffect m_hitSoundEffect; // <--- 添加 QSoundEffect 成员变量
 };
 
 #endif // OBSTACLEITEM_H
@@ -0,0 +1,165 @@
+// 文件: main.cpp (orbitassetcooker)
+// 把游戏里按固定尺寸显示的贴图（飞船、物品、关卡包里所有关卡的装饰）缩放成显示尺寸，
+// 写到输出目录并生成 cooked.qrc。缩放方式与运行时完全相同 (KeepAspectRatio + SmoothTransformation)，
+// 所以游戏用烘焙好的小图和自己缩放原图得到的画面一样，只是省掉了解码大图和重采样。
+// 每个尺寸还会输出一份 2 倍像素的 @2x 版本供高 DPI 屏使用。
+#include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QImage>
+#include <QLoggingCategory>
+#include <QSaveFile>
+#include <QSet>
+#include <QTextStream>
+#include <QXmlStreamReader>
+
+#include "cookedassets.h"
+#include "levelpack.h"
+
+namespace {
+
+// 读取 .qrc，得到资源路径 (":/images/sun.png") -> 磁盘文件的对应关系
+bool readResourceFile(const QString& qrcPath, QHash<QString, QString>* files, QString* errorString)
+{
+    QFile file(qrcPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        *errorString = QString("cannot open %1: %2").arg(qrcPath, file.errorString());
+        return false;
+    }
+    const QDir baseDir = QFileInfo(qrcPath).dir();
+    QXmlStreamReader xml(&file);
+    QString prefix;
+    while (!xml.atEnd()) {
+        xml.readNext();
+        if (!xml.isStartElement()) continue;
+        if (xml.name() == QLatin1String("qresource")) {
+            prefix = xml.attributes().value("prefix").toString();
+            if (!prefix.endsWith('/')) prefix += '/';
+        } else if (xml.name() == QLatin1String("file")) {
+            const QString alias = xml.attributes().value("alias").toString();
+            const QString relativePath = xml.readElementText();
+            const QString resourcePath = ":" + prefix + (alias.isEmpty() ? relativePath : alias);
+            files->insert(QDir::cleanPath(resourcePath), baseDir.filePath(relativePath));
+        }
+    }
+    if (xml.hasError()) {
+        *errorString = QString("%1: %2").arg(qrcPath, xml.errorString());
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    // QImage 的缩放/编码不需要窗口系统
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication app(argc, argv);
+    QCoreApplication::setApplicationName("orbitassetcooker");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Pre-scales OrbitGame sprites and scenery to their display sizes and writes a cooked resource bundle.");
+    parser.addHelpOption();
+    QCommandLineOption qrcOption("qrc", "Resource file listing the source images.", "file");
+    QCommandLineOption outputOption(QStringList() << "o" << "output", "Output directory for the cooked images and cooked.qrc.", "dir");
+    QCommandLineOption verboseOption("verbose", "Keep the core's debug output.");
+    parser.addOption(qrcOption);
+    parser.addOption(outputOption);
+    parser.addOption(verboseOption);
+    parser.addPositionalArgument("packs", "Level pack manifests whose scenery is cooked.", "<levels.json>...");
+    parser.process(app);
+
+    const QStringList packPaths = parser.positionalArguments();
+    if (!parser.isSet(qrcOption) || !parser.isSet(outputOption)) {
+        parser.showHelp(2);
+    }
+    if (!parser.isSet(verboseOption)) {
+        QLoggingCategory::setFilterRules("*.debug=false");
+    }
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    QString errorString;
+    QHash<QString, QString> sourceFiles;
+    if (!readResourceFile(parser.value(qrcOption), &sourceFiles, &errorString)) {
+        err << "error: " << errorString << "\n";
+        return 1;
+    }
+
+    std::vector<CookedAsset> assets = fixedSizeSprites();
+    for (const QString& packPath : packPaths) {
+        LevelPack pack;
+        if (!pack.loadManifest(packPath, &errorString) || !appendLevelPackScenery(pack, &assets, &errorString)) {
+            err << "error: " << errorString << "\n";
+            return 1;
+        }
+    }
+
+    const QDir outputDir(parser.value(outputOption));
+    if (!outputDir.mkpath(".")) {
+        err << "error: cannot create " << outputDir.path() << "\n";
+        return 1;
+    }
+
+    QSet<QString> written;
+    QString qrc = "<RCC>\n    <!-- orbitassetcooker 生成，不要手动修改 -->\n    <qresource prefix=\"/cooked\">\n";
+    qint64 sourceBytes = 0;
+    qint64 cookedBytes = 0;
+    int failures = 0;
+    for (const CookedAsset& asset : assets) {
+        const QString sourceFile = sourceFiles.value(QDir::cleanPath(asset.source));
+        QImage source;
+        for (int scale = 1; scale <= COOKED_HIDPI_SCALE; scale *= COOKED_HIDPI_SCALE) {
+            const QString cookedPath = cookedAssetPath(asset.source, asset.size, scale);
+            if (cookedPath.isEmpty()) {
+                err << "skip: " << asset.source << " is not a resource path\n";
+                break;
+            }
+            if (written.contains(cookedPath)) continue;
+
+            if (source.isNull() && !sourceFile.isEmpty()) source.load(sourceFile);
+            if (sourceFile.isEmpty() || source.isNull()) {
+                err << "error: cannot load " << asset.source << (sourceFile.isEmpty() ? QString(" (not listed in the qrc)") : " from " + sourceFile) << "\n";
+                ++failures;
+                break;
+            }
+
+            // cookedPath 去掉 ":/cooked/" 就是 cooked.qrc 里的相对路径
+            const QString relativePath = cookedPath.mid(QString(COOKED_ASSET_PREFIX).size());
+            const QString outputPath = outputDir.filePath(relativePath);
+            outputDir.mkpath(QFileInfo(relativePath).path());
+            const QImage cooked = source.scaled(asset.size * scale, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+            QSaveFile output(outputPath);
+            if (!output.open(QIODevice::WriteOnly) || !cooked.save(&output, "PNG") || !output.commit()) {
+                err << "error: cannot write " << outputPath << "\n";
+                ++failures;
+                continue;
+            }
+
+            written.insert(cookedPath);
+            qrc += QString("        <file>%1</file>\n").arg(relativePath);
+            if (scale == 1) sourceBytes += QFileInfo(sourceFile).size();
+            cookedBytes += QFileInfo(outputPath).size();
+            out << asset.source << " -> " << cookedPath << " (" << cooked.width() << "x" << cooked.height() << ")\n";
+        }
+    }
+    qrc += "    </qresource>\n</RCC>\n";
+
+    if (failures > 0) {
+        err << failures << " asset(s) failed; cooked.qrc not written\n";
+        return 1;
+    }
+    QSaveFile qrcFile(outputDir.filePath("cooked.qrc"));
+    if (!qrcFile.open(QIODevice::WriteOnly) || qrcFile.write(qrc.toUtf8()) < 0 || !qrcFile.commit()) {
+        err << "error: cannot write " << qrcFile.fileName() << "\n";
+        return 1;
+    }
+    out << "cooked " << written.size() << " images: " << sourceBytes / 1024 << " KB of sources -> "
+        << cookedBytes / 1024 << " KB\n";
+    return 0;
+}
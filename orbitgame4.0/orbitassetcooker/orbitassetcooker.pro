@@ -0,0 +1,14 @@
+# 资源烘焙工具，把游戏按固定尺寸显示的贴图预先缩放好，生成 cooked/cooked.qrc（见 cookedassets.h）：
+#   orbitassetcooker --qrc sprites.qrc -o cooked levels.json
+# 一般不直接运行: 顶层 orbitgame.pro 先构建它，游戏工程构建时自动调用
+QT = core gui
+
+CONFIG += c++17 console cmdline
+CONFIG -= app_bundle
+
+TARGET = orbitassetcooker
+
+SOURCES += \
+    main.cpp
+
+include(../orbitcore.pri)
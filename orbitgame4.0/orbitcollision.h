@@ -0,0 +1,89 @@
+#ifndef ORBITCOLLISION_H
+#define ORBITCOLLISION_H
+
+#include <QtGlobal>
+#include <QtMath>
+#include <cmath>
+
+// ==========================================================================
+// 解析圆形碰撞。每个实体（飞船、收集品、障碍物、通关点、轨道）都只用一个半径描述，
+// 不再依赖贴图的透明度遮罩或 QGraphicsScene 的 collidingItems()。
+// 同一轨道上的物体直接在轨道坐标（到圆心的距离 + 角度）里比较，用余弦定理求距离。
+// ==========================================================================
+
+// 场景坐标中的两个圆是否重叠
+inline bool circlesOverlap(qreal ax, qreal ay, qreal aRadius,
+                           qreal bx, qreal by, qreal bRadius)
+{
+    const qreal dx = ax - bx;
+    const qreal dy = ay - by;
+    const qreal limit = aRadius + bRadius;
+    return dx * dx + dy * dy < limit * limit;
+}
+
+// 绕同一圆心的两点之间距离的平方: Ra^2 + Rb^2 - 2*Ra*Rb*cos(dTheta)
+inline qreal orbitDistanceSquared(qreal orbitRadiusA, qreal angleA,
+                                  qreal orbitRadiusB, qreal angleB)
+{
+    return orbitRadiusA * orbitRadiusA + orbitRadiusB * orbitRadiusB
+           - 2.0 * orbitRadiusA * orbitRadiusB * qCos(angleA - angleB);
+}
+
+// 轨道坐标中的两个圆是否重叠
+inline bool orbitCirclesOverlap(qreal orbitRadiusA, qreal angleA, qreal aRadius,
+                                qreal orbitRadiusB, qreal angleB, qreal bRadius)
+{
+    const qreal limit = aRadius + bRadius;
+    return orbitDistanceSquared(orbitRadiusA, angleA, orbitRadiusB, angleB) < limit * limit;
+}
+
+// angle 到逆时针圆弧 [arcStart, arcStart + arcSpan] 的最小角度差（落在弧内为 0）
+inline qreal angularDistanceToArc(qreal angle, qreal arcStart, qreal arcSpan)
+{
+    if (arcSpan >= 2.0 * M_PI) return 0;
+    qreal offset = std::fmod(angle - arcStart, 2.0 * M_PI);
+    if (offset < 0) offset += 2.0 * M_PI;
+    if (offset <= arcSpan) return 0;
+    return qMin(offset - arcSpan, 2.0 * M_PI - offset);
+}
+
+// 连续碰撞: 沿半径为 orbitRadiusA 的圆弧扫过 [arcStart, arcStart + arcSpan] 的圆
+// 是否在途中某一点与轨道坐标中的另一个圆重叠。
+// 固定半径下两点距离随角度差单调增加，因此只需比较弧上离对方最近的那一点（闭式解）
+inline bool orbitArcHitsCircle(qreal orbitRadiusA, qreal arcStart, qreal arcSpan, qreal aRadius,
+                               qreal orbitRadiusB, qreal angleB, qreal bRadius)
+{
+    return orbitCirclesOverlap(orbitRadiusA, 0, aRadius,
+                               orbitRadiusB, angularDistanceToArc(angleB, arcStart, arcSpan), bRadius);
+}
+
+// 半径为 orbitRadiusA 的圆周上，与位于 (orbitRadiusB, 角度 0) 的点距离小于 hitDistance 的角度范围
+// 是 (-halfWidth, halfWidth)。返回 false 表示圆周上没有这样的点
+inline bool orbitHitWindow(qreal orbitRadiusA, qreal orbitRadiusB, qreal hitDistance, qreal* halfWidth)
+{
+    if (orbitRadiusA <= 0 || orbitRadiusB <= 0) {
+        // 其中一点在圆心上，距离与角度无关
+        if (qAbs(orbitRadiusA - orbitRadiusB) >= hitDistance) return false;
+        *halfWidth = M_PI;
+        return true;
+    }
+    const qreal k = (orbitRadiusA * orbitRadiusA + orbitRadiusB * orbitRadiusB - hitDistance * hitDistance)
+                    / (2.0 * orbitRadiusA * orbitRadiusB);
+    if (k >= 1.0) return false;
+    *halfWidth = (k <= -1.0) ? M_PI : qAcos(k);
+    return true;
+}
+
+// 两点到圆心的距离不小于 minOrbitRadius / orbitRadius 时，距离小于 hitDistance
+// 所需的最大角度差（4*Ra*Rb*sin^2(dTheta/2) <= H^2）。返回 false 表示任何角度都可能命中
+inline bool orbitAngularReach(qreal minOrbitRadius, qreal orbitRadius, qreal hitDistance, qreal* reach)
+{
+    const qreal radiusProduct = minOrbitRadius * orbitRadius;
+    if (radiusProduct <= 0) return false;
+    const qreal sinHalf = hitDistance / (2.0 * qSqrt(radiusProduct));
+    if (sinHalf >= 1.0) return false;
+    *reach = 2.0 * qAsin(sinHalf) + 1e-9;
+    return true;
+}
+
+#endif // ORBITCOLLISION_H
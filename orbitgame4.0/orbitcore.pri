@@ -0,0 +1,29 @@
+# 游戏核心（规则与状态），只依赖 QtCore。
+# GUI 工程和无界面的验证/回放/求解工具都可以直接 include 这个文件。
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+SOURCES += \
+    $$PWD/compiledlevel.cpp \
+    $$PWD/cookedassets.cpp \
+    $$PWD/levelpack.cpp \
+    $$PWD/orbitsimulation.cpp \
+    $$PWD/orbitreplay.cpp \
+    $$PWD/orbitsolver.cpp \
+    $$PWD/trackspatialgrid.cpp \
+    $$PWD/trackdata.cpp \
+    $$PWD/trackgenerator.cpp
+
+HEADERS += \
+    $$PWD/compiledlevel.h \
+    $$PWD/cookedassets.h \
+    $$PWD/levelpack.h \
+    $$PWD/orbitsimulation.h \
+    $$PWD/orbitcollision.h \
+    $$PWD/orbitreplay.h \
+    $$PWD/orbitsolver.h \
+    $$PWD/threadpooltask.h \
+    $$PWD/trackspatialgrid.h \
+    $$PWD/trackdata.h \
+    $$PWD/trackgenerator.h
@@ -0,0 +1,16 @@
+# 核心的无界面单元测试（QtTest），只依赖 QtCore：
+#   qmake && make check
+QT = core testlib
+
+CONFIG += c++17 console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_orbitcore
+
+# 测试直接读取源码目录里的 level1.json / level1.orbl
+DEFINES += ORBIT_SOURCE_DIR=\\\"$$PWD/..\\\"
+
+SOURCES += \
+    tst_orbitcore.cpp
+
+include(../orbitcore.pri)
@@ -0,0 +1,781 @@
+// 文件: tst_orbitcore.cpp (orbitcoretests)
+// 游戏核心的无界面测试：录像编解码、流式关卡读取、编译后的关卡、求解计划的两种推进方式、
+// 按键判定、轨道空间索引与连续碰撞、驻留窗口、无尽模式的轨道生成和关卡热重载。
+#include <QtTest>
+#include <algorithm>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include "compiledlevel.h"
+#include "levelpack.h"
+#include "orbitreplay.h"
+#include "orbitsimulation.h"
+#include "orbitsolver.h"
+#include "trackdata.h"
+#include "trackgenerator.h"
+#include "trackspatialgrid.h"
+
+Q_DECLARE_METATYPE(OrbitJudgment)
+
+namespace {
+
+QString sourcePath(const char* fileName)
+{
+    return QStringLiteral(ORBIT_SOURCE_DIR "/") + QString::fromUtf8(fileName);
+}
+
+QByteArray readFile(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return QByteArray();
+    return file.readAll();
+}
+
+// 用 QJsonDocument 按 trackdata.h 里描述的格式解析关卡，作为流式读取的对照
+TrackData parseWithJsonDocument(const QByteArray& json)
+{
+    TrackData level;
+    const QJsonObject root = QJsonDocument::fromJson(json).object();
+    for (const QJsonValue& value : root["segments"].toArray()) {
+        if (value.isObject()) level.segments.push_back(TrackSegmentData::fromJsonObject(value.toObject()));
+    }
+    for (const QJsonValue& value : root["scenery"].toArray()) {
+        const QJsonObject object = value.toObject();
+        SceneryData item;
+        item.image = object["image"].toString();
+        item.x = object["x"].toDouble();
+        item.y = object["y"].toDouble();
+        item.width = object["width"].toDouble();
+        item.height = object["height"].toDouble();
+        item.z = object.contains("z") ? object["z"].toDouble() : DEFAULT_SCENERY_Z;
+        if (!item.image.isEmpty() && item.width > 0 && item.height > 0) level.scenery.push_back(item);
+    }
+    if (root["endTrigger"].isObject()) {
+        const QJsonObject endTrigger = root["endTrigger"].toObject();
+        level.endTrigger.x = endTrigger["x"].toDouble();
+        level.endTrigger.y = endTrigger["y"].toDouble();
+        level.endTrigger.radius = endTrigger.contains("radius") ? endTrigger["radius"].toDouble()
+                                                                : DEFAULT_END_TRIGGER_RADIUS;
+    }
+    return level;
+}
+
+template <typename Item>
+void compareItems(const std::vector<Item>& actual, const std::vector<Item>& expected)
+{
+    QCOMPARE(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); ++i) {
+        QCOMPARE(actual[i].angleDegrees, expected[i].angleDegrees);
+        QCOMPARE(actual[i].radialOffset, expected[i].radialOffset);
+    }
+}
+
+void compareSegment(const TrackSegmentData& actual, const TrackSegmentData& expected)
+{
+    QCOMPARE(actual.centerX, expected.centerX);
+    QCOMPARE(actual.centerY, expected.centerY);
+    QCOMPARE(actual.radius, expected.radius);
+    QCOMPARE(actual.tangentAngleDegrees, expected.tangentAngleDegrees);
+    compareItems(actual.collectibles, expected.collectibles);
+    if (QTest::currentTestFailed()) return;
+    compareItems(actual.obstacles, expected.obstacles);
+}
+
+void compareScenery(const SceneryData& actual, const SceneryData& expected)
+{
+    QCOMPARE(actual.image, expected.image);
+    QCOMPARE(actual.x, expected.x);
+    QCOMPARE(actual.y, expected.y);
+    QCOMPARE(actual.width, expected.width);
+    QCOMPARE(actual.height, expected.height);
+    QCOMPARE(actual.z, expected.z);
+}
+
+void compareEndTrigger(const EndTriggerData& actual, const EndTriggerData& expected)
+{
+    QCOMPARE(actual.x, expected.x);
+    QCOMPARE(actual.y, expected.y);
+    QCOMPARE(actual.radius, expected.radius);
+}
+
+void setUpSimulation(const TrackData& level, OrbitSimulation* sim)
+{
+    sim->loadLevel(level);
+    if (!level.segments.empty()) {
+        sim->setEndTrigger(level.endTrigger.x, level.endTrigger.y, level.endTrigger.radius);
+    }
+}
+
+TrackSegmentData makeSegment(double centerX, double centerY, double radius)
+{
+    TrackSegmentData segment;
+    segment.centerX = centerX;
+    segment.centerY = centerY;
+    segment.radius = radius;
+    segment.tangentAngleDegrees = 0;
+    return segment;
+}
+
+// level 中 [first, end) 这几条轨道组成的驻留窗口；firstCollectible / firstObstacle 返回窗口中第一个物品的整关编号
+TrackData levelWindow(const TrackData& level, int first, int end, int* firstCollectible, int* firstObstacle)
+{
+    *firstCollectible = 0;
+    *firstObstacle = 0;
+    for (int i = 0; i < first; ++i) {
+        *firstCollectible += static_cast<int>(level.segments[i].collectibles.size());
+        *firstObstacle += static_cast<int>(level.segments[i].obstacles.size());
+    }
+    TrackData window;
+    window.segments.assign(level.segments.begin() + first, level.segments.begin() + end);
+    return window;
+}
+
+// 与事件驱动回放相同，一次排好录像里的全部输入，之后只需按固定步长 step()
+void queueReplayInputs(const OrbitReplay& replay, OrbitSimulation* sim)
+{
+    for (const OrbitReplayInput& entry : replay.inputs) {
+        sim->queueInput(entry.input, OrbitReplay::toSeconds(entry.timeMicros), OrbitReplay::toSeconds(entry.applyMicros));
+    }
+}
+
+// 一个正常的录像：按时到达的 K、迟到的 J、恰好在当前时刻的 K
+OrbitReplay sampleReplay()
+{
+    OrbitReplay replay;
+    replay.levelHash = Q_UINT64_C(0x0123456789ABCDEF);
+    replay.seed = 42;
+    replay.addInput(OrbitInput::SwitchTrack, 0.5, 0.4);
+    replay.addInput(OrbitInput::SwitchOrbit, 1.25, 1.3);
+    replay.addInput(OrbitInput::SwitchTrack, 2.0, 2.0);
+    replay.durationMicros = 3000000;
+    return replay;
+}
+
+} // namespace
+
+class OrbitCoreTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void replayRoundTrip();
+    void replayRejectsTruncatedData();
+    void replayRejectsOversizedData();
+    void replayStopsAtDurationLimit();
+    void streamingReaderMatchesJsonDocument();
+    void streamingReaderReportsErrorPosition_data();
+    void streamingReaderReportsErrorPosition();
+    void compiledLevelMatchesJson();
+    void solverPlanMatchesEventScheduledRun();
+    void eventAdvanceLeavesWindowsItIsIn();
+    void levelPrefetcherPreparesNextLevel();
+    void lateKeyIsJudgedAtItsTimestamp_data();
+    void lateKeyIsJudgedAtItsTimestamp();
+    void spatialGridReturnsEveryNearbyTrack();
+    void largeStepDoesNotTunnelThroughItems();
+    void windowedLevelMatchesFullLevel();
+    void trackGeneratorIsDeterministic();
+    void hotReloadKeepsConsumedItems();
+};
+
+void OrbitCoreTest::replayRoundTrip()
+{
+    const OrbitReplay original = sampleReplay();
+    QVERIFY(original.inputs[1].late);
+    QVERIFY(original.inputs[2].late);
+    const QByteArray encoded = original.encode();
+
+    OrbitReplay decoded;
+    QString error;
+    QVERIFY2(decoded.decode(encoded, &error), qPrintable(error));
+    QCOMPARE(decoded.levelHash, original.levelHash);
+    QCOMPARE(decoded.seed, original.seed);
+    QCOMPARE(decoded.durationMicros, original.durationMicros);
+    QCOMPARE(decoded.inputs.size(), original.inputs.size());
+    for (size_t i = 0; i < original.inputs.size(); ++i) {
+        QCOMPARE(decoded.inputs[i].input, original.inputs[i].input);
+        QCOMPARE(decoded.inputs[i].timeMicros, original.inputs[i].timeMicros);
+        QCOMPARE(decoded.inputs[i].applyMicros, original.inputs[i].applyMicros);
+        QCOMPARE(decoded.inputs[i].late, original.inputs[i].late);
+    }
+    QCOMPARE(decoded.encode(), encoded);
+}
+
+void OrbitCoreTest::replayRejectsTruncatedData()
+{
+    const QByteArray encoded = sampleReplay().encode();
+    for (int size = 0; size < encoded.size(); ++size) {
+        OrbitReplay decoded;
+        QString error;
+        QVERIFY2(!decoded.decode(encoded.left(size), &error), qPrintable(QString("decoded %1 of %2 bytes").arg(size).arg(encoded.size())));
+        QVERIFY(!error.isEmpty());
+    }
+}
+
+void OrbitCoreTest::replayRejectsOversizedData()
+{
+    OrbitReplay decoded;
+    QString error;
+
+    // 时长超过上限
+    OrbitReplay tooLong = sampleReplay();
+    tooLong.durationMicros = ORBIT_REPLAY_MAX_DURATION_MICROS + 1;
+    QVERIFY(!decoded.decode(tooLong.encode(), &error));
+    QVERIFY2(error.contains("limit"), qPrintable(error));
+
+    // 最后一个输入之后空转太久
+    OrbitReplay idle = sampleReplay();
+    idle.durationMicros = idle.inputs.back().applyMicros + ORBIT_REPLAY_MAX_IDLE_MICROS + 1;
+    QVERIFY(!decoded.decode(idle.encode(), &error));
+    QVERIFY2(error.contains("past the last input"), qPrintable(error));
+
+    // 输入个数远多于文件能装下的
+    OrbitReplay empty;
+    QByteArray hugeCount = empty.encode();
+    hugeCount.chop(1); // 输入个数 0（一个字节）
+    hugeCount.append(QByteArray(9, '\xFF'));
+    hugeCount.append('\x01');
+    QVERIFY(!decoded.decode(hugeCount, &error));
+    QVERIFY2(error.contains("exceeds file size"), qPrintable(error));
+
+    // 结尾多出的字节
+    QVERIFY(!decoded.decode(sampleReplay().encode() + QByteArray(1, '\0'), &error));
+    QVERIFY2(error.contains("trailing"), qPrintable(error));
+}
+
+void OrbitCoreTest::replayStopsAtDurationLimit()
+{
+    TrackData level;
+    QVERIFY(level.loadLevelFromFile(sourcePath("level1.json")));
+    OrbitSimulation sim;
+    setUpSimulation(level, &sim);
+
+    // 绕过 decode() 直接构造的录像也不能让模拟超过上限
+    OrbitReplay tooLong;
+    tooLong.durationMicros = ORBIT_REPLAY_MAX_DURATION_MICROS * 2;
+    const OrbitReplayResult result = tooLong.replay(sim, true);
+    QVERIFY(result.budgetExceeded);
+    QVERIFY(result.time <= OrbitReplay::toSeconds(ORBIT_REPLAY_MAX_DURATION_MICROS) + SIM_FIXED_STEP_SECONDS);
+}
+
+void OrbitCoreTest::streamingReaderMatchesJsonDocument()
+{
+    const QByteArray json = readFile(sourcePath("level1.json"));
+    QVERIFY(!json.isEmpty());
+
+    TrackData streamed;
+    QString error;
+    QVERIFY2(streamed.loadLevelFromUtf8(json, &error), qPrintable(error));
+    const TrackData expected = parseWithJsonDocument(json);
+    QVERIFY(!expected.segments.empty());
+
+    QCOMPARE(streamed.segments.size(), expected.segments.size());
+    for (size_t i = 0; i < expected.segments.size(); ++i) {
+        compareSegment(streamed.segments[i], expected.segments[i]);
+        if (QTest::currentTestFailed()) QFAIL(qPrintable(QString("segment %1 differs").arg(i)));
+    }
+    QCOMPARE(streamed.scenery.size(), expected.scenery.size());
+    for (size_t i = 0; i < expected.scenery.size(); ++i) {
+        compareScenery(streamed.scenery[i], expected.scenery[i]);
+        if (QTest::currentTestFailed()) QFAIL(qPrintable(QString("scenery %1 differs").arg(i)));
+    }
+    compareEndTrigger(streamed.endTrigger, expected.endTrigger);
+}
+
+void OrbitCoreTest::streamingReaderReportsErrorPosition_data()
+{
+    QTest::addColumn<QByteArray>("json");
+    QTest::addColumn<QString>("expectedError");
+
+    QTest::newRow("extra comma")
+        << QByteArray("{\n    \"segments\": [\n        { \"centerX\": 1,, \"centerY\": 2 }\n    ]\n}")
+        << QString("line 3, column 24: expected a string");
+    // 列号按字符而不是 UTF-8 字节计算
+    QTest::newRow("extra comma after a non-ASCII key")
+        << QByteArray("{\n    \"segments\": [\n        { \"名称\": 1,, }\n    ]\n}")
+        << QString("line 3, column 19: expected a string");
+    QTest::newRow("invalid number")
+        << QByteArray("[ { \"radius\": 1.e5 } ]")
+        << QString("line 1, column 15: invalid number");
+    QTest::newRow("unterminated array")
+        << QByteArray("[\n  { \"radius\": 10 }\n")
+        << QString("line 3, column 1: expected ',' or ']'");
+}
+
+void OrbitCoreTest::streamingReaderReportsErrorPosition()
+{
+    QFETCH(QByteArray, json);
+    QFETCH(QString, expectedError);
+
+    TrackData level;
+    QString error;
+    QVERIFY(!level.loadLevelFromUtf8(json, &error));
+    QCOMPARE(error, expectedError);
+}
+
+void OrbitCoreTest::compiledLevelMatchesJson()
+{
+    TrackData level;
+    QVERIFY(level.loadLevelFromFile(sourcePath("level1.json")));
+
+    // .orbl 在构建时生成，这里自己编译一份再映射回来
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString compiledPath = dir.filePath("level1.orbl");
+    QFile compiledFile(compiledPath);
+    QVERIFY(compiledFile.open(QIODevice::WriteOnly));
+    compiledFile.write(CompiledLevel::compile(level));
+    compiledFile.close();
+
+    CompiledLevel compiled;
+    QString error;
+    QVERIFY2(compiled.open(compiledPath, &error), qPrintable(error));
+    QCOMPARE(compiled.segmentCount(), static_cast<int>(level.segments.size()));
+    for (int i = 0; i < compiled.segmentCount(); ++i) {
+        compareSegment(compiled.segmentData(i), level.segments[i]);
+        if (QTest::currentTestFailed()) QFAIL(qPrintable(QString("segment %1 differs").arg(i)));
+    }
+    QCOMPARE(compiled.sceneryCount(), static_cast<int>(level.scenery.size()));
+    for (int i = 0; i < compiled.sceneryCount(); ++i) {
+        compareScenery(compiled.sceneryData(i), level.scenery[i]);
+        if (QTest::currentTestFailed()) QFAIL(qPrintable(QString("scenery %1 differs").arg(i)));
+    }
+    compareEndTrigger(compiled.endTrigger(), level.endTrigger);
+}
+
+void OrbitCoreTest::solverPlanMatchesEventScheduledRun()
+{
+    TrackData level;
+    QVERIFY(level.loadLevelFromFile(sourcePath("level1.json")));
+
+    OrbitSolver solver;
+    const OrbitSolverResult plan = solver.solve(level, level.endTrigger.x, level.endTrigger.y, level.endTrigger.radius);
+    QVERIFY(!plan.replay.inputs.empty());
+
+    OrbitSimulation sim;
+    setUpSimulation(level, &sim);
+    const OrbitReplayResult fixedStep = plan.replay.replay(sim, false);
+    const OrbitReplayResult eventScheduled = plan.replay.replay(sim, true);
+
+    QVERIFY(!fixedStep.budgetExceeded);
+    QVERIFY(!eventScheduled.budgetExceeded);
+    QCOMPARE(fixedStep.score, plan.outcome.score);
+    QCOMPARE(fixedStep.health, plan.outcome.health);
+    QCOMPARE(eventScheduled.score, fixedStep.score);
+    QCOMPARE(eventScheduled.health, fixedStep.health);
+    QCOMPARE(eventScheduled.levelCompleted, fixedStep.levelCompleted);
+    QCOMPARE(eventScheduled.gameOver, fixedStep.gameOver);
+    QCOMPARE(eventScheduled.judgmentString(), fixedStep.judgmentString());
+}
+
+void OrbitCoreTest::eventAdvanceLeavesWindowsItIsIn()
+{
+    // 飞船从第二条轨道的圆盘里出发，外侧轨道有很长一段都在它的碰撞范围内；
+    // 中途按 J 回到外侧时仍在范围里。每次推进都必须离开当前时刻，不能靠事件上限才停下
+    TrackData level;
+    level.segments.push_back(makeSegment(0, 0, 300));
+    level.segments.push_back(makeSegment(0, 300, 250));
+    OrbitSimulation sim;
+    sim.loadLevel(level);
+    sim.queueInput(OrbitInput::SwitchOrbit, 0.25);
+    sim.queueInput(OrbitInput::SwitchOrbit, 0.75);
+
+    const qreal duration = 30.0;
+    int advances = 0;
+    int zeroAdvances = 0;
+    bool collided = false;
+    while (sim.isRunning() && sim.state().time < duration && advances < 1000) {
+        ++advances;
+        if (sim.advanceToNextEvent(duration - sim.state().time) <= 0) ++zeroAdvances;
+        for (const OrbitSimEvent& event : sim.takeEvents()) {
+            if (event.type == OrbitSimEvent::TrackCollision) collided = true;
+        }
+    }
+    QVERIFY(collided);
+    // 固定步长要 3600 步；事件推进只在判定点、无敌结束、进出碰撞范围和输入处停下
+    QVERIFY2(advances < 200, qPrintable(QString("%1 advances").arg(advances)));
+    QVERIFY(zeroAdvances <= 2); // 只有两个 J 输入本身不推进时间
+}
+
+void OrbitCoreTest::levelPrefetcherPreparesNextLevel()
+{
+    // 清单里至少要有两关，GameScene 玩第一关时才会预读第二关
+    LevelPack pack;
+    QVERIFY(pack.loadManifest(sourcePath("levels.json")));
+    QVERIFY(pack.levelCount() >= 2);
+    const QString jsonPath = pack.level(1).file;
+    TrackData expected;
+    QVERIFY(expected.loadLevelFromFile(jsonPath));
+    QVERIFY(!expected.segments.empty());
+
+    // JSON 关卡: 在后台整体解析
+    LevelPrefetcher prefetcher;
+    prefetcher.prefetch(jsonPath, 4);
+    PreparedLevel prepared;
+    QVERIFY(!prefetcher.take(pack.level(0).file, &prepared)); // 没有为这个文件预读
+    QVERIFY(prefetcher.take(jsonPath, &prepared));
+    QVERIFY(prepared.ok);
+    QVERIFY(!prepared.compiled);
+    QCOMPARE(prepared.level.segments.size(), expected.segments.size());
+    for (size_t i = 0; i < expected.segments.size(); ++i) {
+        compareSegment(prepared.level.segments[i], expected.segments[i]);
+        if (QTest::currentTestFailed()) QFAIL(qPrintable(QString("segment %1 differs").arg(i)));
+    }
+    compareEndTrigger(prepared.level.endTrigger, expected.endTrigger);
+    QVERIFY(!prefetcher.take(jsonPath, &prepared)); // 结果只能取一次
+
+    // .orbl 关卡: 主线程打开映射，后台拷出第一段窗口、装饰和通关点
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString compiledPath = dir.filePath("level2.orbl");
+    QFile compiledFile(compiledPath);
+    QVERIFY(compiledFile.open(QIODevice::WriteOnly));
+    compiledFile.write(CompiledLevel::compile(expected));
+    compiledFile.close();
+
+    const int windowTracks = 4;
+    prefetcher.prefetch(compiledPath, windowTracks);
+    PreparedLevel preparedCompiled;
+    QVERIFY(prefetcher.take(compiledPath, &preparedCompiled));
+    QVERIFY(preparedCompiled.compiled);
+    QCOMPARE(preparedCompiled.compiled->segmentCount(), static_cast<int>(expected.segments.size()));
+    QCOMPARE(preparedCompiled.level.segments.size(), static_cast<size_t>(windowTracks));
+    for (int i = 0; i < windowTracks; ++i) {
+        compareSegment(preparedCompiled.level.segments[i], expected.segments[i]);
+        if (QTest::currentTestFailed()) QFAIL(qPrintable(QString("segment %1 differs").arg(i)));
+    }
+    QCOMPARE(preparedCompiled.level.scenery.size(), expected.scenery.size());
+    for (size_t i = 0; i < expected.scenery.size(); ++i) {
+        compareScenery(preparedCompiled.level.scenery[i], expected.scenery[i]);
+        if (QTest::currentTestFailed()) QFAIL(qPrintable(QString("scenery %1 differs").arg(i)));
+    }
+    compareEndTrigger(preparedCompiled.level.endTrigger, expected.endTrigger);
+
+    // 换成别的文件时丢弃没取走的结果
+    prefetcher.prefetch(compiledPath, windowTracks);
+    prefetcher.prefetch(jsonPath, windowTracks);
+    QVERIFY(!prefetcher.take(compiledPath, &preparedCompiled));
+}
+
+void OrbitCoreTest::lateKeyIsJudgedAtItsTimestamp_data()
+{
+    // keyOffset: 按键时刻相对到达判定点的秒数；processedAt: 模拟跑到哪里才处理这个按键
+    QTest::addColumn<qreal>("keyOffset");
+    QTest::addColumn<qreal>("processedAt");
+    QTest::addColumn<OrbitJudgment>("judgment");
+
+    // 按处理时的角度判定会是 Good / Miss / Perfect / Good，按键时刻的角度才是对的
+    QTest::newRow("perfect, processed late") << 0.01 << 0.11 << OrbitJudgment::Perfect;
+    QTest::newRow("good, processed late") << 0.12 << 0.22 << OrbitJudgment::Good;
+    QTest::newRow("early good, processed near the top") << -0.12 << -0.02 << OrbitJudgment::Good;
+    QTest::newRow("miss, processed soon after") << 0.2 << 0.21 << OrbitJudgment::Miss;
+}
+
+void OrbitCoreTest::lateKeyIsJudgedAtItsTimestamp()
+{
+    QFETCH(qreal, keyOffset);
+    QFETCH(qreal, processedAt);
+    QFETCH(OrbitJudgment, judgment);
+
+    // 第二条轨道外切在第一条的判定点上。飞船走内侧，不会撞到它而改变角速度
+    TrackData level;
+    level.segments.push_back(makeSegment(0, 0, 300));
+    level.segments.push_back(makeSegment(0, -550, 250));
+    OrbitSimulation sim;
+    sim.loadLevel(level);
+    sim.queueInput(OrbitInput::SwitchOrbit, 0);
+    const qreal topTime = (ANGLE_TOP - ANGLE_BOTTOM) / sim.angularSpeed();
+
+    while (sim.state().time < topTime + processedAt) sim.step(SIM_FIXED_STEP_SECONDS);
+    sim.takeEvents();
+    sim.queueInput(OrbitInput::SwitchTrack, topTime + keyOffset);
+
+    const std::vector<OrbitSimEvent> events = sim.takeEvents();
+    QVERIFY(!events.empty());
+    QCOMPARE(events.front().type, OrbitSimEvent::Judgment);
+    QCOMPARE(events.front().judgment, judgment);
+    QCOMPARE(sim.state().trackIndex, judgment == OrbitJudgment::Miss ? 0 : 1);
+}
+
+void OrbitCoreTest::spatialGridReturnsEveryNearbyTrack()
+{
+    // 第一关的一串轨道，加上无尽模式生成的大小不一的轨道
+    TrackData level;
+    QVERIFY(level.loadLevelFromFile(sourcePath("level1.json")));
+    std::vector<TrackCircle> tracks;
+    for (const TrackSegmentData& segment : level.segments) tracks.push_back({segment.centerX, segment.centerY, segment.radius});
+    TrackGenerator generator(7);
+    for (int i = 0; i < 200; ++i) {
+        const TrackSegmentData segment = generator.next(i / 20);
+        tracks.push_back({segment.centerX + 5000, segment.centerY, segment.radius});
+    }
+
+    const qreal margin = BALL_RADIUS;
+    TrackSpatialGrid grid;
+    grid.build(tracks, margin);
+    QVERIFY(!grid.isEmpty());
+
+    // 在每条轨道内外两侧取点，与逐条比较的结果对照：网格给出的候选必须包含所有可能碰到的轨道
+    const qreal queryRadius = 50;
+    std::vector<int> near;
+    for (const TrackCircle& track : tracks) {
+        for (int k = 0; k < 16; ++k) {
+            const qreal angle = k * M_PI / 8;
+            for (qreal offset : {-margin, 0.0, margin * 0.99}) {
+                const qreal x = track.centerX + (track.radius + offset) * qCos(angle);
+                const qreal y = track.centerY + (track.radius + offset) * qSin(angle);
+                const int* begin = nullptr;
+                const int* end = nullptr;
+                grid.candidatesAt(x, y, &begin, &end);
+                near.clear();
+                grid.tracksNear(x, y, queryRadius, &near);
+                QVERIFY(std::is_sorted(near.begin(), near.end()));
+                QVERIFY(std::adjacent_find(near.begin(), near.end()) == near.end());
+
+                for (size_t j = 0; j < tracks.size(); ++j) {
+                    const qreal distance = qSqrt((x - tracks[j].centerX) * (x - tracks[j].centerX)
+                                                 + (y - tracks[j].centerY) * (y - tracks[j].centerY));
+                    const int index = static_cast<int>(j);
+                    if (distance < tracks[j].radius + margin - 1e-6 && std::find(begin, end, index) == end) {
+                        QFAIL(qPrintable(QString("track %1 missing from the cell at (%2, %3)").arg(j).arg(x).arg(y)));
+                    }
+                    if (distance < tracks[j].radius + margin + queryRadius - 1e-6
+                        && !std::binary_search(near.begin(), near.end(), index)) {
+                        QFAIL(qPrintable(QString("track %1 missing near (%2, %3)").arg(j).arg(x).arg(y)));
+                    }
+                }
+            }
+        }
+    }
+}
+
+void OrbitCoreTest::largeStepDoesNotTunnelThroughItems()
+{
+    // 飞船从 ANGLE_BOTTOM 出发（外侧），一步扫过 2 弧度，途中的收集品和障碍物都在命中范围以外很远的地方才被跨过
+    TrackData level;
+    TrackSegmentData segment = makeSegment(0, 0, 300);
+    segment.collectibles.push_back({qRadiansToDegrees(ANGLE_BOTTOM + 0.5), 10.0});
+    segment.obstacles.push_back({qRadiansToDegrees(ANGLE_BOTTOM + 1.0), 10.0});
+    segment.obstacles.push_back({qRadiansToDegrees(ANGLE_BOTTOM + 3.0), 10.0}); // 本步扫不到
+    level.segments.push_back(segment);
+    OrbitSimulation sim;
+    sim.loadLevel(level);
+
+    const qreal sweep = 2.0;
+    sim.step(sweep / sim.angularSpeed());
+    QVERIFY(sim.isCollectibleCollected(0));
+    QVERIFY(sim.isObstacleHit(0));
+    QVERIFY(!sim.isObstacleHit(1));
+    QCOMPARE(sim.state().health, MAX_HEALTH - 1);
+
+    bool collected = false;
+    bool hit = false;
+    for (const OrbitSimEvent& event : sim.takeEvents()) {
+        if (event.type == OrbitSimEvent::CollectibleCollected && event.index == 0) collected = true;
+        if (event.type == OrbitSimEvent::ObstacleHit) {
+            QCOMPARE(event.index, 0);
+            hit = true;
+        }
+    }
+    QVERIFY(collected);
+    QVERIFY(hit);
+}
+
+void OrbitCoreTest::windowedLevelMatchesFullLevel()
+{
+    TrackData level;
+    QVERIFY(level.loadLevelFromFile(sourcePath("level1.json")));
+    OrbitSolver solver;
+    const OrbitSolverResult plan = solver.solve(level, level.endTrigger.x, level.endTrigger.y, level.endTrigger.radius);
+    const qreal duration = OrbitReplay::toSeconds(plan.replay.durationMicros);
+
+    OrbitSimulation full;
+    setUpSimulation(level, &full);
+    queueReplayInputs(plan.replay, &full);
+    while (full.isRunning() && full.state().time < duration) full.step(SIM_FIXED_STEP_SECONDS);
+
+    // 同一份输入，只让当前轨道前后几条驻留；每次换窗口前记下要移出的物品的状态
+    const int behind = 2;
+    const int ahead = 3;
+    const int trackCount = static_cast<int>(level.segments.size());
+    int totalCollectibles = 0;
+    int totalObstacles = 0;
+    for (const TrackSegmentData& segment : level.segments) {
+        totalCollectibles += static_cast<int>(segment.collectibles.size());
+        totalObstacles += static_cast<int>(segment.obstacles.size());
+    }
+    std::vector<bool> collected(totalCollectibles, false);
+    std::vector<bool> hit(totalObstacles, false);
+
+    OrbitSimulation windowed;
+    int firstCollectible = 0;
+    int firstObstacle = 0;
+    windowed.loadLevelWindow(levelWindow(level, 0, qMin(trackCount, ahead + 1), &firstCollectible, &firstObstacle),
+                             0, firstCollectible, firstObstacle, trackCount);
+    windowed.setEndTrigger(level.endTrigger.x, level.endTrigger.y, level.endTrigger.radius);
+    queueReplayInputs(plan.replay, &windowed);
+
+    auto recordResidentItems = [&]() {
+        for (int i = firstCollectible; i < firstCollectible + windowed.collectibleCount(); ++i) {
+            collected[i] = windowed.isCollectibleCollected(i);
+        }
+        for (int i = firstObstacle; i < firstObstacle + windowed.obstacleCount(); ++i) hit[i] = windowed.isObstacleHit(i);
+    };
+
+    int windowMoves = 0;
+    while (windowed.isRunning() && windowed.state().time < duration) {
+        windowed.step(SIM_FIXED_STEP_SECONDS);
+        const int trackIndex = windowed.state().trackIndex;
+        const int first = qMax(0, trackIndex - behind);
+        const int end = qMin(trackCount, trackIndex + ahead + 1);
+        if (first == windowed.firstResidentTrack() && end == first + windowed.residentTrackCount()) continue;
+
+        recordResidentItems();
+        windowed.setLevelWindow(levelWindow(level, first, end, &firstCollectible, &firstObstacle),
+                                first, firstCollectible, firstObstacle, trackCount);
+        QCOMPARE(windowed.firstResidentTrack(), first);
+        ++windowMoves;
+        // 仍驻留的物品保留已收集/已撞过的标记，新加载的物品都还没处理过
+        for (int i = firstCollectible; i < firstCollectible + windowed.collectibleCount(); ++i) {
+            QCOMPARE(windowed.isCollectibleCollected(i), bool(collected[i]));
+        }
+        for (int i = firstObstacle; i < firstObstacle + windowed.obstacleCount(); ++i) {
+            QCOMPARE(windowed.isObstacleHit(i), bool(hit[i]));
+        }
+    }
+    recordResidentItems();
+    QVERIFY(windowMoves > 0);
+
+    QCOMPARE(windowed.state().score, full.state().score);
+    QCOMPARE(windowed.state().health, full.state().health);
+    QCOMPARE(windowed.state().trackIndex, full.state().trackIndex);
+    QCOMPARE(windowed.state().levelCompleted, full.state().levelCompleted);
+    QCOMPARE(windowed.state().time, full.state().time);
+    int collectedCount = 0;
+    for (int i = 0; i < totalCollectibles; ++i) {
+        QCOMPARE(bool(collected[i]), full.isCollectibleCollected(i));
+        if (collected[i]) ++collectedCount;
+    }
+    for (int i = 0; i < totalObstacles; ++i) QCOMPARE(bool(hit[i]), full.isObstacleHit(i));
+    QVERIFY(collectedCount > 0);
+}
+
+void OrbitCoreTest::trackGeneratorIsDeterministic()
+{
+    auto generate = [](TrackGenerator* generator, int count) {
+        std::vector<TrackSegmentData> segments;
+        for (int i = 0; i < count; ++i) segments.push_back(generator->next(i / 10));
+        return segments;
+    };
+
+    TrackGenerator first(12345);
+    TrackGenerator second(12345);
+    const std::vector<TrackSegmentData> expected = generate(&first, 150);
+    const std::vector<TrackSegmentData> actual = generate(&second, 150);
+    QCOMPARE(first.generatedCount(), 150);
+    int itemCount = 0;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        compareSegment(actual[i], expected[i]);
+        if (QTest::currentTestFailed()) QFAIL(qPrintable(QString("segment %1 differs").arg(i)));
+        itemCount += static_cast<int>(expected[i].collectibles.size() + expected[i].obstacles.size());
+        // 新轨道的底部落在上一条轨道的判定点上
+        if (i > 0) {
+            QCOMPARE(expected[i].centerX, expected[i - 1].centerX);
+            QCOMPARE(expected[i].centerY + expected[i].radius, expected[i - 1].centerY - expected[i - 1].radius);
+        }
+    }
+    QVERIFY(itemCount > 0);
+
+    // reset() 之后从头生成同样的轨道，换一个种子则不同
+    first.reset(12345);
+    const std::vector<TrackSegmentData> again = generate(&first, 150);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        compareSegment(again[i], expected[i]);
+        if (QTest::currentTestFailed()) QFAIL(qPrintable(QString("segment %1 differs after reset").arg(i)));
+    }
+    TrackGenerator other(54321);
+    const std::vector<TrackSegmentData> different = generate(&other, 150);
+    bool anyDifferent = false;
+    for (size_t i = 1; i < expected.size() && !anyDifferent; ++i) anyDifferent = different[i].radius != expected[i].radius;
+    QVERIFY(anyDifferent);
+}
+
+void OrbitCoreTest::hotReloadKeepsConsumedItems()
+{
+    TrackData level;
+    QVERIFY(level.loadLevelFromFile(sourcePath("level1.json")));
+    OrbitSolver solver;
+    const OrbitSolverResult plan = solver.solve(level, level.endTrigger.x, level.endTrigger.y, level.endTrigger.radius);
+
+    // 按计划跑到一半，已经收集了一些物品
+    OrbitSimulation sim;
+    setUpSimulation(level, &sim);
+    queueReplayInputs(plan.replay, &sim);
+    const qreal halfway = OrbitReplay::toSeconds(plan.replay.durationMicros) / 2;
+    while (sim.isRunning() && sim.state().time < halfway) sim.step(SIM_FIXED_STEP_SECONDS);
+    QVERIFY(sim.isRunning());
+    std::vector<bool> collected;
+    for (int i = 0; i < sim.collectibleCount(); ++i) collected.push_back(sim.isCollectibleCollected(i));
+    std::vector<bool> hit;
+    for (int i = 0; i < sim.obstacleCount(); ++i) hit.push_back(sim.isObstacleHit(i));
+    const auto consumed = std::find(collected.begin(), collected.end(), true);
+    QVERIFY(consumed != collected.end());
+
+    // 编辑: 挪动一个已收集的收集品（算新物品）、交换一条轨道上的两个收集品（仍配得上）、在最后一条轨道上加一个
+    TrackData edited = level;
+    QList<int> expectedCollectibleOrigin;
+    for (int i = 0; i < static_cast<int>(collected.size()); ++i) expectedCollectibleOrigin.append(i);
+    const int moved = static_cast<int>(consumed - collected.begin());
+    int swapped = -1;
+    int first = 0;
+    for (TrackSegmentData& segment : edited.segments) {
+        const int count = static_cast<int>(segment.collectibles.size());
+        if (moved >= first && moved < first + count) segment.collectibles[moved - first].angleDegrees += 1.0;
+        if (swapped < 0 && count >= 2 && (moved < first || moved >= first + 2)) {
+            std::swap(segment.collectibles[0], segment.collectibles[1]);
+            swapped = first;
+        }
+        first += count;
+    }
+    QVERIFY(swapped >= 0);
+    expectedCollectibleOrigin[moved] = -1;
+    std::swap(expectedCollectibleOrigin[swapped], expectedCollectibleOrigin[swapped + 1]);
+    edited.segments.back().collectibles.push_back({123.0, 10.0});
+    expectedCollectibleOrigin.append(-1);
+
+    std::vector<int> collectibleOrigin;
+    std::vector<int> obstacleOrigin;
+    int oldFirstCollectible = 0;
+    int oldFirstObstacle = 0;
+    for (size_t i = 0; i < edited.segments.size(); ++i) {
+        const std::vector<int> collectibles = matchSegmentItems(level.segments[i].collectibles, edited.segments[i].collectibles,
+                                                                oldFirstCollectible);
+        const std::vector<int> obstacles = matchSegmentItems(level.segments[i].obstacles, edited.segments[i].obstacles,
+                                                             oldFirstObstacle);
+        collectibleOrigin.insert(collectibleOrigin.end(), collectibles.begin(), collectibles.end());
+        obstacleOrigin.insert(obstacleOrigin.end(), obstacles.begin(), obstacles.end());
+        oldFirstCollectible += static_cast<int>(level.segments[i].collectibles.size());
+        oldFirstObstacle += static_cast<int>(level.segments[i].obstacles.size());
+    }
+    QCOMPARE(QList<int>(collectibleOrigin.begin(), collectibleOrigin.end()), expectedCollectibleOrigin);
+    for (size_t i = 0; i < obstacleOrigin.size(); ++i) QCOMPARE(obstacleOrigin[i], static_cast<int>(i));
+
+    const OrbitSimState before = sim.state();
+    QVERIFY(sim.replaceLevel(edited, collectibleOrigin, obstacleOrigin));
+    QCOMPARE(sim.state().trackIndex, before.trackIndex);
+    QCOMPARE(sim.state().angle, before.angle);
+    QCOMPARE(sim.collectibleCount(), static_cast<int>(collectibleOrigin.size()));
+    for (int i = 0; i < sim.collectibleCount(); ++i) {
+        const int origin = collectibleOrigin[i];
+        QCOMPARE(sim.isCollectibleCollected(i), origin >= 0 && collected[origin]);
+    }
+    for (int i = 0; i < sim.obstacleCount(); ++i) QCOMPARE(sim.isObstacleHit(i), bool(hit[i]));
+    QVERIFY(!sim.isCollectibleCollected(moved));
+}
+
+QTEST_GUILESS_MAIN(OrbitCoreTest)
+
+#include "tst_orbitcore.moc"
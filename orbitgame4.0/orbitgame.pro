@@ -0,0 +1,32 @@
+# 整个工程: 先构建 orbitassetcooker 和 orbitlevelcompiler（游戏构建时用它们烘焙资源、编译关卡，见 orbitgame2.pro），
+# 再构建游戏和其他工具。
+#   qmake orbitgame.pro && make
+# 核心的单元测试在 orbitcoretests 里，make check 会运行。
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    orbitassetcooker \
+    orbitlevelcompiler \
+    orbitreplaytool \
+    orbitsolvertool \
+    orbitcoretests \
+    game
+
+game.file = orbitgame2.pro
+game.depends = orbitassetcooker orbitlevelcompiler
+
+# 游戏工程构建时调用的工具，把它们构建出来的位置经 .qmake.stash 传给子工程（见 orbitgame2.pro）
+defineReplace(orbitToolPath) {
+    tool_path = $$OUT_PWD/$$1
+    win32 {
+        CONFIG(debug, debug|release): tool_path = $$tool_path/debug
+        else: tool_path = $$tool_path/release
+    }
+    tool_path = $$tool_path/$$1
+    win32: tool_path = $${tool_path}.exe
+    return($$tool_path)
+}
+isEmpty(ORBIT_ASSET_COOKER): ORBIT_ASSET_COOKER = $$orbitToolPath(orbitassetcooker)
+isEmpty(ORBIT_LEVEL_COMPILER): ORBIT_LEVEL_COMPILER = $$orbitToolPath(orbitlevelcompiler)
+cache(ORBIT_ASSET_COOKER, set stash)
+cache(ORBIT_LEVEL_COMPILER, set stash)
@@ -8,6 +8,7 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    assetregistry.cpp \
     collectibleitem.cpp \
     customclickableitem.cpp \
     endtriggeritem.cpp \
@@ -16,10 +17,10 @@ SOURCES += \
     main.cpp \
     mainwindow.cpp \
     obstacleitem.cpp \
-    startscene.cpp \
-    trackdata.cpp
+    startscene.cpp
 
 HEADERS += \
+    assetregistry.h \
     collectibleitem.h \
     customclickableitem.h \
     endtriggeritem.h \
@@ -27,8 +28,9 @@ HEADERS += \
     gamescene.h \
     mainwindow.h \
     obstacleitem.h \
-    startscene.h \
-    trackdata.h
+    startscene.h
+
+include(orbitcore.pri)
 
 FORMS += \
     mainwindow.ui
@@ -40,3 +42,71 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 !isEmpty(target.path): INSTALLS += target
  RESOURCES += \
     resources.qrc
+
+# 资源烘焙: 飞船、物品和行星在运行时要缩放到固定尺寸，构建时由 orbitassetcooker 预先缩放好，
+# 生成 cooked/cooked.qrc 并编进程序。levels.json、关卡文件、原图或 orbitassetcooker 本身变了都会重新烘焙。
+# orbitassetcooker 由顶层的 orbitgame.pro 先构建，它的位置经 .qmake.stash 传过来；
+# 单独构建本工程时可以用 qmake ORBIT_ASSET_COOKER=/path/to/orbitassetcooker 指定已经构建好的烘焙工具
+isEmpty(ORBIT_ASSET_COOKER) {
+    # 没有烘焙工具: 原图和媒体直接编进程序，贴图在运行时缩放，不生成 sprites.rcc / media.rcc
+    message("orbitassetcooker is not available; embedding sprites.qrc and media.qrc without cooked assets. Build orbitgame.pro to cook them.")
+    RESOURCES += sprites.qrc media.qrc
+    DEFINES += ORBIT_EMBEDDED_ASSETS
+} else {
+    COOK_MANIFESTS = $$PWD/levels.json
+    cookassets.input = COOK_MANIFESTS
+    cookassets.output = $$OUT_PWD/cooked/qrc_cooked.cpp
+    cookassets.depends = $$ORBIT_ASSET_COOKER $$PWD/sprites.qrc $$files($$PWD/*.json) $$files($$PWD/*.png)
+    cookassets.commands = $$shell_path($$ORBIT_ASSET_COOKER) --qrc $$shell_path($$PWD/sprites.qrc) -o $$shell_path($$OUT_PWD/cooked) ${QMAKE_FILE_IN} \
+        && $$shell_path($$[QT_HOST_LIBEXECS]/rcc) -name cooked $$shell_path($$OUT_PWD/cooked/cooked.qrc) -o ${QMAKE_FILE_OUT}
+    cookassets.variable_out = GENERATED_SOURCES
+    cookassets.name = cook assets ${QMAKE_FILE_IN}
+    QMAKE_EXTRA_COMPILERS += cookassets
+
+    # 原图不编进程序，构建为外部资源包 sprites.rcc 放在程序旁边，运行时映射注册（AssetRegistry::registerSpriteBundle）。
+    # 只有没烘焙过的尺寸（例如热重载时改了装饰的大小）才会读到它
+    spritebundle.target = $$OUT_PWD/sprites.rcc
+    spritebundle.depends = $$PWD/sprites.qrc $$files($$PWD/*.png)
+    spritebundle.commands = $$shell_path($$[QT_HOST_LIBEXECS]/rcc) -binary $$shell_path($$PWD/sprites.qrc) -o $$shell_path($$OUT_PWD/sprites.rcc)
+    QMAKE_EXTRA_TARGETS += spritebundle
+    PRE_TARGETDEPS += $$OUT_PWD/sprites.rcc
+    OTHER_FILES += sprites.qrc
+    !isEmpty(target.path) {
+        spritebundle_install.files = $$OUT_PWD/sprites.rcc
+        spritebundle_install.path = $$target.path
+        spritebundle_install.CONFIG += no_check_exist
+        INSTALLS += spritebundle_install
+    }
+
+    # 视频和背景音乐不编进程序，构建为外部资源包 media.rcc 放在程序旁边，运行时映射注册
+    # (AssetRegistry::registerMediaBundle)，程序大小和启动时要映射的内容不再随过场视频增长
+    mediabundle.target = $$OUT_PWD/media.rcc
+    mediabundle.depends = $$PWD/media.qrc $$PWD/intro_video.mp4 $$PWD/end_video.mp4 $$PWD/softmusic.mp3
+    mediabundle.commands = $$shell_path($$[QT_HOST_LIBEXECS]/rcc) -binary -no-compress $$shell_path($$PWD/media.qrc) -o $$shell_path($$OUT_PWD/media.rcc)
+    QMAKE_EXTRA_TARGETS += mediabundle
+    PRE_TARGETDEPS += $$OUT_PWD/media.rcc
+    OTHER_FILES += media.qrc
+    !isEmpty(target.path) {
+        mediabundle_install.files = $$OUT_PWD/media.rcc
+        mediabundle_install.path = $$target.path
+        mediabundle_install.CONFIG += no_check_exist
+        INSTALLS += mediabundle_install
+    }
+}
+
+# 编译后的关卡: levels.json 里写了 compiled 的关卡由 orbitlevelcompiler 编译成 .orbl，生成 compiledlevels/levels.qrc
+# 并编进程序（前缀 /levels，不压缩以便直接映射）。.orbl 是生成的文件，不提交到仓库；关卡 JSON 或编译器变了都会重新编译。
+# 单独构建本工程时可以用 qmake ORBIT_LEVEL_COMPILER=/path/to/orbitlevelcompiler 指定，没有时游戏直接读 JSON
+isEmpty(ORBIT_LEVEL_COMPILER) {
+    message("orbitlevelcompiler is not available; levels will be loaded from JSON. Build orbitgame.pro to compile them.")
+} else {
+    COMPILE_LEVEL_MANIFESTS = $$PWD/levels.json
+    compilelevels.input = COMPILE_LEVEL_MANIFESTS
+    compilelevels.output = $$OUT_PWD/compiledlevels/qrc_compiledlevels.cpp
+    compilelevels.depends = $$ORBIT_LEVEL_COMPILER $$files($$PWD/*.json)
+    compilelevels.commands = $$shell_path($$ORBIT_LEVEL_COMPILER) --manifest ${QMAKE_FILE_IN} -o $$shell_path($$OUT_PWD/compiledlevels) \
+        && $$shell_path($$[QT_HOST_LIBEXECS]/rcc) -name compiledlevels $$shell_path($$OUT_PWD/compiledlevels/levels.qrc) -o ${QMAKE_FILE_OUT}
+    compilelevels.variable_out = GENERATED_SOURCES
+    compilelevels.name = compile levels ${QMAKE_FILE_IN}
+    QMAKE_EXTRA_COMPILERS += compilelevels
+}
@@ -0,0 +1,202 @@
+// 文件: main.cpp (orbitlevelcompiler)
+// 把关卡 JSON 编译成 CompiledLevel (.orbl)：定长的轨道表 + 物品表 + 装饰表，游戏直接映射使用，不需要解析。
+// 编译后会重新打开输出文件，逐条与 JSON 的内容比对，保证两者完全一致。
+// --manifest 模式编译关卡包清单里所有写了 compiled 的关卡，并生成 levels.qrc（游戏构建时由 orbitgame2.pro 调用）。
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QDir>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QSaveFile>
+#include <QTextStream>
+
+#include "trackdata.h"
+#include "compiledlevel.h"
+#include "levelpack.h"
+
+namespace {
+
+bool sameItems(const CompiledLevel& compiled, const CompiledSegment& segment, const TrackSegmentData& source)
+{
+    if (segment.collectibleCount != source.collectibles.size() || segment.obstacleCount != source.obstacles.size()) {
+        return false;
+    }
+    for (quint32 i = 0; i < segment.collectibleCount; ++i) {
+        const CompiledItem item = compiled.collectible(static_cast<int>(segment.firstCollectible + i));
+        if (item.angleDegrees != source.collectibles[i].angleDegrees || item.radialOffset != source.collectibles[i].radialOffset) {
+            return false;
+        }
+    }
+    for (quint32 i = 0; i < segment.obstacleCount; ++i) {
+        const CompiledItem item = compiled.obstacle(static_cast<int>(segment.firstObstacle + i));
+        if (item.angleDegrees != source.obstacles[i].angleDegrees || item.radialOffset != source.obstacles[i].radialOffset) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool sameScenery(const CompiledLevel& compiled, const TrackData& source)
+{
+    if (compiled.sceneryCount() != static_cast<int>(source.scenery.size())) return false;
+    for (int i = 0; i < compiled.sceneryCount(); ++i) {
+        const SceneryData item = compiled.sceneryData(i);
+        const SceneryData& expected = source.scenery[i];
+        if (item.image != expected.image || item.x != expected.x || item.y != expected.y || item.width != expected.width
+            || item.height != expected.height || item.z != expected.z) {
+            return false;
+        }
+    }
+    const EndTriggerData endTrigger = compiled.endTrigger();
+    return endTrigger.x == source.endTrigger.x && endTrigger.y == source.endTrigger.y
+           && endTrigger.radius == source.endTrigger.radius;
+}
+
+// 编译 input 写到 output，再打开输出文件与 JSON 逐条比对
+bool compileLevel(const QString& input, const QString& output, QTextStream& out, QTextStream& err)
+{
+    TrackData level;
+    if (!level.loadLevelFromFile(input)) {
+        err << "Failed to load level " << input << Qt::endl;
+        return false;
+    }
+
+    QFile file(output);
+    if (!file.open(QIODevice::WriteOnly)) {
+        err << "Cannot write " << output << ": " << file.errorString() << Qt::endl;
+        return false;
+    }
+    const QByteArray data = CompiledLevel::compile(level);
+    file.write(data);
+    file.close();
+
+    CompiledLevel compiled;
+    QString error;
+    bool ok = compiled.open(output, &error);
+    if (ok && compiled.segmentCount() != static_cast<int>(level.segments.size())) {
+        ok = false;
+        error = "segment count mismatch";
+    }
+    for (int i = 0; ok && i < compiled.segmentCount(); ++i) {
+        const CompiledSegment segment = compiled.segment(i);
+        const TrackSegmentData& source = level.segments[i];
+        if (segment.centerX != source.centerX || segment.centerY != source.centerY || segment.radius != source.radius
+            || segment.tangentAngleDegrees != source.tangentAngleDegrees || !sameItems(compiled, segment, source)) {
+            ok = false;
+            error = QString("segment %1 does not match the JSON").arg(i);
+        }
+    }
+    if (ok && !sameScenery(compiled, level)) {
+        ok = false;
+        error = "scenery or end trigger does not match the JSON";
+    }
+    if (!ok) {
+        err << output << ": verification failed: " << error << Qt::endl;
+        return false;
+    }
+
+    out << input << " -> " << output
+        << "\tsegments=" << compiled.segmentCount()
+        << "\tcollectibles=" << compiled.collectibleCount()
+        << "\tobstacles=" << compiled.obstacleCount()
+        << "\tscenery=" << compiled.sceneryCount()
+        << "\tbytes=" << data.size() << Qt::endl;
+    return true;
+}
+
+// 编译清单里所有写了 compiled 的关卡，输出到 outputPath 下与清单中相同的相对路径，并生成 levels.qrc
+// （前缀 /levels，与清单放在资源里时的路径一致；不压缩以便直接映射）
+bool compileManifest(const QString& manifestPath, const QString& outputPath, QTextStream& out, QTextStream& err)
+{
+    LevelPack pack;
+    QString errorString;
+    if (!pack.loadManifest(manifestPath, &errorString)) {
+        err << "error: " << errorString << Qt::endl;
+        return false;
+    }
+    const QDir manifestDir = QFileInfo(manifestPath).dir();
+    const QDir outputDir(outputPath);
+    if (!outputDir.mkpath(".")) {
+        err << "error: cannot create " << outputDir.path() << Qt::endl;
+        return false;
+    }
+
+    QString qrc = "<RCC>\n    <!-- orbitlevelcompiler 生成，不要手动修改 -->\n    <qresource prefix=\"/levels\">\n";
+    int failures = 0;
+    for (int i = 0; i < pack.levelCount(); ++i) {
+        const LevelPackEntry& entry = pack.level(i);
+        if (entry.compiledFile.isEmpty()) continue;
+        const QString relativePath = manifestDir.relativeFilePath(entry.compiledFile);
+        outputDir.mkpath(QFileInfo(relativePath).path());
+        if (!compileLevel(entry.file, outputDir.filePath(relativePath), out, err)) {
+            ++failures;
+            continue;
+        }
+        qrc += QString("        <file compression-algorithm=\"none\">%1</file>\n").arg(relativePath);
+    }
+    qrc += "    </qresource>\n</RCC>\n";
+
+    if (failures > 0) {
+        err << failures << " level(s) failed; levels.qrc not written" << Qt::endl;
+        return false;
+    }
+    QSaveFile qrcFile(outputDir.filePath("levels.qrc"));
+    if (!qrcFile.open(QIODevice::WriteOnly) || qrcFile.write(qrc.toUtf8()) < 0 || !qrcFile.commit()) {
+        err << "error: cannot write " << qrcFile.fileName() << Qt::endl;
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("orbitlevelcompiler");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Compiles OrbitGame level JSON into the memory-mapped .orbl format.");
+    parser.addHelpOption();
+    QCommandLineOption outputOption(QStringList() << "o" << "output",
+                                    "Output file (only with a single input; default: <input>.orbl next to the input), "
+                                    "or the output directory with --manifest.", "file");
+    QCommandLineOption manifestOption("manifest",
+                                      "Compile every level of this level pack that names a compiled file, "
+                                      "and write levels.qrc listing them into the output directory.", "levels.json");
+    QCommandLineOption verboseOption("verbose", "Keep the core's debug output.");
+    parser.addOption(outputOption);
+    parser.addOption(manifestOption);
+    parser.addOption(verboseOption);
+    parser.addPositionalArgument("levels", "Level JSON files.", "<level.json>...");
+    parser.process(app);
+
+    const QStringList inputs = parser.positionalArguments();
+    if (parser.isSet(manifestOption)) {
+        if (!inputs.isEmpty() || !parser.isSet(outputOption)) parser.showHelp(2);
+    } else if (inputs.isEmpty() || (parser.isSet(outputOption) && inputs.size() != 1)) {
+        parser.showHelp(2);
+    }
+    if (!parser.isSet(verboseOption)) {
+        QLoggingCategory::setFilterRules("*.debug=false");
+    }
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    if (parser.isSet(manifestOption)) {
+        return compileManifest(parser.value(manifestOption), parser.value(outputOption), out, err) ? 0 : 1;
+    }
+
+    int failures = 0;
+    for (const QString& input : inputs) {
+        const QFileInfo info(input);
+        const QString output = parser.isSet(outputOption)
+                                   ? parser.value(outputOption)
+                                   : info.dir().filePath(info.completeBaseName() + ".orbl");
+
+        if (!compileLevel(input, output, out, err)) ++failures;
+    }
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,14 @@
+# 关卡编译工具，把关卡 JSON 编译成游戏直接映射使用的 .orbl，只依赖 QtCore：
+#   orbitlevelcompiler [-o 输出.orbl] <关卡.json>...
+#   orbitlevelcompiler --manifest levels.json -o 输出目录     （游戏构建时由 orbitgame2.pro 调用）
+QT = core
+
+CONFIG += c++17 console cmdline
+CONFIG -= app_bundle
+
+TARGET = orbitlevelcompiler
+
+SOURCES += \
+    main.cpp
+
+include(../orbitcore.pri)
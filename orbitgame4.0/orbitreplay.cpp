@@ -0,0 +1,258 @@
+// 文件: orbitreplay.cpp
+#include "orbitreplay.h"
+#include <cmath>
+#include <QDebug>
+
+namespace {
+
+const char REPLAY_MAGIC[4] = {'O', 'R', 'P', 'L'};
+
+void appendVarint(QByteArray& out, quint64 value)
+{
+    while (value >= 0x80) {
+        out.append(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.append(static_cast<char>(value));
+}
+
+bool readVarint(const QByteArray& data, int* pos, quint64* value)
+{
+    quint64 result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (*pos >= data.size()) return false;
+        const quint8 byte = static_cast<quint8>(data.at((*pos)++));
+        result |= static_cast<quint64>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false; // 超过 10 个字节，数据损坏
+}
+
+quint64 zigzagEncode(qint64 value)
+{
+    return (static_cast<quint64>(value) << 1) ^ static_cast<quint64>(value >> 63);
+}
+
+qint64 zigzagDecode(quint64 value)
+{
+    return static_cast<qint64>(value >> 1) ^ -static_cast<qint64>(value & 1);
+}
+
+} // namespace
+
+QString OrbitReplayResult::judgmentString() const
+{
+    QString text;
+    text.reserve(static_cast<int>(judgments.size()));
+    for (OrbitJudgment judgment : judgments) {
+        switch (judgment) {
+        case OrbitJudgment::Perfect: text.append(QLatin1Char('P')); break;
+        case OrbitJudgment::Good:    text.append(QLatin1Char('G')); break;
+        case OrbitJudgment::Miss:    text.append(QLatin1Char('M')); break;
+        case OrbitJudgment::None:    break;
+        }
+    }
+    return text;
+}
+
+OrbitReplay::OrbitReplay()
+    : levelHash(0),
+    seed(0),
+    durationMicros(0)
+{
+}
+
+void OrbitReplay::clear()
+{
+    levelHash = 0;
+    seed = 0;
+    durationMicros = 0;
+    inputs.clear();
+}
+
+qint64 OrbitReplay::toMicros(qreal seconds)
+{
+    return qRound64(seconds * 1e6);
+}
+
+qreal OrbitReplay::toSeconds(qint64 micros)
+{
+    return micros / 1e6;
+}
+
+void OrbitReplay::addInput(OrbitInput input, qreal inputTime, qreal currentSimTime)
+{
+    OrbitReplayInput entry;
+    entry.input = input;
+    entry.timeMicros = toMicros(inputTime);
+    entry.applyMicros = entry.timeMicros;
+    entry.late = inputTime <= currentSimTime; // 与 OrbitSimulation::queueInput 立即处理的条件一致
+    if (entry.late) {
+        // 迟到的输入在当前步的边界上立即生效；向下取整保证回放时也落在同一个边界上
+        entry.applyMicros = qMax(entry.timeMicros, static_cast<qint64>(std::floor(currentSimTime * 1e6)));
+    }
+    inputs.push_back(entry);
+}
+
+QByteArray OrbitReplay::encode() const
+{
+    QByteArray out;
+    out.reserve(32 + static_cast<int>(inputs.size()) * 4);
+    out.append(REPLAY_MAGIC, sizeof(REPLAY_MAGIC));
+    out.append(static_cast<char>(ORBIT_REPLAY_VERSION));
+    for (int i = 0; i < 8; ++i) out.append(static_cast<char>((levelHash >> (8 * i)) & 0xFF));
+    appendVarint(out, seed);
+    appendVarint(out, static_cast<quint64>(qMax<qint64>(0, durationMicros)));
+    appendVarint(out, inputs.size());
+
+    qint64 previousMicros = 0;
+    for (const OrbitReplayInput& entry : inputs) {
+        const quint64 header = (zigzagEncode(entry.timeMicros - previousMicros) << 2)
+                               | (entry.late ? 2u : 0u)
+                               | (entry.input == OrbitInput::SwitchOrbit ? 1u : 0u);
+        appendVarint(out, header);
+        if (entry.late) appendVarint(out, static_cast<quint64>(qMax<qint64>(0, entry.applyMicros - entry.timeMicros)));
+        previousMicros = entry.timeMicros;
+    }
+    return out;
+}
+
+bool OrbitReplay::decode(const QByteArray& data, QString* errorString)
+{
+    auto fail = [errorString](const QString& message) {
+        if (errorString) *errorString = message;
+        return false;
+    };
+
+    clear();
+    if (data.size() < 13 || !data.startsWith(QByteArray(REPLAY_MAGIC, sizeof(REPLAY_MAGIC)))) {
+        return fail(QStringLiteral("not a replay file"));
+    }
+    const quint8 version = static_cast<quint8>(data.at(4));
+    if (version != ORBIT_REPLAY_VERSION) {
+        return fail(QStringLiteral("unsupported replay version %1").arg(version));
+    }
+    for (int i = 0; i < 8; ++i) {
+        levelHash |= static_cast<quint64>(static_cast<quint8>(data.at(5 + i))) << (8 * i);
+    }
+
+    int pos = 13;
+    quint64 duration = 0;
+    quint64 count = 0;
+    if (!readVarint(data, &pos, &seed) || !readVarint(data, &pos, &duration) || !readVarint(data, &pos, &count)) {
+        return fail(QStringLiteral("truncated header"));
+    }
+    // 每个输入至少 1 个字节，提前拒绝声称有海量输入的损坏文件
+    if (count > static_cast<quint64>(data.size() - pos)) {
+        return fail(QStringLiteral("input count %1 exceeds file size").arg(count));
+    }
+    if (duration > static_cast<quint64>(ORBIT_REPLAY_MAX_DURATION_MICROS)) {
+        return fail(QStringLiteral("duration %1 us exceeds the %2 us limit").arg(duration).arg(ORBIT_REPLAY_MAX_DURATION_MICROS));
+    }
+    durationMicros = static_cast<qint64>(duration);
+
+    inputs.reserve(count);
+    qint64 previousMicros = 0;
+    qint64 lastInputMicros = 0;
+    for (quint64 i = 0; i < count; ++i) {
+        quint64 header = 0;
+        if (!readVarint(data, &pos, &header)) return fail(QStringLiteral("truncated input %1").arg(i));
+        OrbitReplayInput entry;
+        entry.input = (header & 1u) ? OrbitInput::SwitchOrbit : OrbitInput::SwitchTrack;
+        entry.timeMicros = previousMicros + zigzagDecode(header >> 2);
+        entry.applyMicros = entry.timeMicros;
+        entry.late = (header & 2u) != 0;
+        if (entry.late) {
+            quint64 lateMicros = 0;
+            if (!readVarint(data, &pos, &lateMicros)) return fail(QStringLiteral("truncated input %1").arg(i));
+            if (lateMicros > static_cast<quint64>(ORBIT_REPLAY_MAX_DURATION_MICROS)) {
+                return fail(QStringLiteral("input %1 is late by %2 us").arg(i).arg(lateMicros));
+            }
+            entry.applyMicros += static_cast<qint64>(lateMicros);
+        }
+        if (entry.timeMicros < 0 || entry.applyMicros > ORBIT_REPLAY_MAX_DURATION_MICROS) {
+            return fail(QStringLiteral("input %1 at %2 us is out of range").arg(i).arg(entry.timeMicros));
+        }
+        inputs.push_back(entry);
+        previousMicros = entry.timeMicros;
+        lastInputMicros = qMax(lastInputMicros, entry.applyMicros);
+    }
+    if (pos != data.size()) {
+        return fail(QStringLiteral("%1 trailing bytes").arg(data.size() - pos));
+    }
+    if (durationMicros - lastInputMicros > ORBIT_REPLAY_MAX_IDLE_MICROS) {
+        return fail(QStringLiteral("duration %1 us is %2 us past the last input")
+                        .arg(durationMicros).arg(durationMicros - lastInputMicros));
+    }
+    return true;
+}
+
+OrbitReplayResult OrbitReplay::replay(OrbitSimulation& sim, bool eventScheduled) const
+{
+    OrbitReplayResult result;
+    sim.reset();
+
+    auto collectJudgments = [&sim, &result]() {
+        for (const OrbitSimEvent& event : sim.takeEvents()) {
+            if (event.type == OrbitSimEvent::Judgment) result.judgments.push_back(event.judgment);
+        }
+    };
+
+    // decode() 已经拒绝了过长的录像；这里再设一道硬上限，直接构造的 OrbitReplay 也不会让校验卡住
+    const qreal duration = toSeconds(qMin(durationMicros, ORBIT_REPLAY_MAX_DURATION_MICROS));
+    result.budgetExceeded = durationMicros > ORBIT_REPLAY_MAX_DURATION_MICROS;
+    if (eventScheduled) {
+        for (const OrbitReplayInput& entry : inputs) {
+            sim.queueInput(entry.input, toSeconds(entry.timeMicros), toSeconds(entry.applyMicros));
+        }
+        collectJudgments();
+        // 每个事件至少对应一个输入、一次判定或一个固定步长那么多的模拟时间，超过这个次数说明事件调度卡住了
+        const qint64 eventBudget = static_cast<qint64>(inputs.size()) * 4
+                                   + static_cast<qint64>(duration / SIM_FIXED_STEP_SECONDS) + 1;
+        qint64 eventCount = 0;
+        while (sim.isRunning() && sim.state().time < duration) {
+            if (++eventCount > eventBudget) {
+                result.budgetExceeded = true;
+                break;
+            }
+            sim.advanceToNextEvent(duration - sim.state().time);
+            collectJudgments();
+        }
+    } else {
+        // 与 GameScene::updateGame 相同: 只推进整数个固定步长。
+        // 准时的输入直接排队；迟到的输入在录制时那个步长边界上生效（界面在两帧之间立即处理它们），
+        // 这样两次模拟的每一步都完全相同
+        std::vector<const OrbitReplayInput*> lateInputs;
+        for (const OrbitReplayInput& entry : inputs) {
+            if (entry.late) lateInputs.push_back(&entry);
+            else sim.queueInput(entry.input, toSeconds(entry.timeMicros));
+        }
+        size_t nextLate = 0;
+        auto applyDueLateInputs = [&]() {
+            const qint64 nowMicros = static_cast<qint64>(std::floor(sim.state().time * 1e6));
+            while (nextLate < lateInputs.size() && lateInputs[nextLate]->applyMicros <= nowMicros) {
+                sim.queueInput(lateInputs[nextLate]->input, toSeconds(lateInputs[nextLate]->timeMicros));
+                ++nextLate;
+            }
+        };
+
+        applyDueLateInputs();
+        collectJudgments();
+        while (sim.isRunning() && sim.state().time + SIM_FIXED_STEP_SECONDS / 2.0 < duration) {
+            sim.step(SIM_FIXED_STEP_SECONDS);
+            applyDueLateInputs();
+            collectJudgments();
+        }
+    }
+
+    const OrbitSimState& state = sim.state();
+    result.score = state.score;
+    result.health = state.health;
+    result.levelCompleted = state.levelCompleted;
+    result.gameOver = state.gameOver;
+    result.time = state.time;
+    return result;
+}
@@ -0,0 +1,89 @@
+#ifndef ORBITREPLAY_H
+#define ORBITREPLAY_H
+
+#include <vector>
+#include <QtGlobal>
+#include <QByteArray>
+#include <QString>
+
+#include "orbitsimulation.h"
+
+// ==========================================================================
+// OrbitReplay: 一局游戏的二进制记录（关卡指纹、随机种子、带时间戳的 K/J 输入）。
+// 输入时间以微秒为单位做差分，再用 zigzag + varint 编码，一局通常只有几百字节。
+// 用同一套 OrbitSimulation 规则重新模拟即可得到分数、生命与判定序列，不需要界面。
+//
+// 文件布局（小端）:
+//   "ORPL"  魔数
+//   u8      版本号 (ORBIT_REPLAY_VERSION)
+//   u64     关卡指纹 (OrbitSimulation::levelHash)
+//   varint  随机种子（目前的关卡没有随机内容，记录为 0，留给随机生成的关卡）
+//   varint  录制结束时的模拟时间（微秒）
+//   varint  输入个数
+//   每个输入:
+//     varint  (zigzag(与上一个输入的时间差) << 2) | (迟到标记 << 1) | 输入类型(0=K, 1=J)
+//     varint  迟到时长（微秒，可以为 0），仅当迟到标记为 1 时存在：按键送达时模拟已经跑过按键时刻，
+//             输入在 时间 + 迟到时长 所在的步长边界上才生效，判定仍按按键时刻
+// ==========================================================================
+
+const quint8 ORBIT_REPLAY_VERSION = 1;
+
+// 校验工具要处理大量提交的录像，每个只能花几毫秒。飞船停在没有障碍的轨道上时一局不会自己结束，
+// 所以录像的时长必须有上限: 超过 ORBIT_REPLAY_MAX_DURATION_MICROS，或者比最后一个输入晚
+// ORBIT_REPLAY_MAX_IDLE_MICROS 以上的录像在 decode() 时就被拒绝
+const qint64 ORBIT_REPLAY_MAX_DURATION_MICROS = Q_INT64_C(3600000000); // 1 小时
+const qint64 ORBIT_REPLAY_MAX_IDLE_MICROS = Q_INT64_C(300000000);      // 最后一个输入之后最多 5 分钟
+
+struct OrbitReplayInput {
+    OrbitInput input;
+    qint64 timeMicros;  // 按键时刻（判定时刻）
+    qint64 applyMicros; // 生效时刻，>= timeMicros
+    bool late;          // 按键送达时模拟已经跑过了按键时刻，在 applyMicros 所在的步长边界上立即生效
+};
+
+// 重新模拟的结果
+struct OrbitReplayResult {
+    int score;
+    int health;
+    bool levelCompleted;
+    bool gameOver;
+    qreal time;                           // 结束时的模拟时间（秒）
+    bool budgetExceeded;                  // 模拟时长或事件次数超过上限被中止，结果无效
+    std::vector<OrbitJudgment> judgments; // 每次 K 键的判定
+
+    // 判定序列，例如 "PPGM": P=Perfect, G=Good, M=Miss
+    QString judgmentString() const;
+};
+
+class OrbitReplay
+{
+public:
+    OrbitReplay();
+
+    void clear();
+    // 记录一次输入。inputTime 为按键时刻；currentSimTime 为此刻模拟已经到达的时间，
+    // 按键时刻早于它时输入会立即生效（与 OrbitSimulation::queueInput 的行为一致）
+    void addInput(OrbitInput input, qreal inputTime, qreal currentSimTime);
+
+    QByteArray encode() const;
+    bool decode(const QByteArray& data, QString* errorString = nullptr);
+
+    // 用 sim 中已加载的关卡重新模拟（调用前需要 loadLevel / setEndTrigger）。
+    // eventScheduled 为 false 时按界面相同的固定步长推进，与录制时逐步一致，校验成绩只能用这种方式；
+    // 为 true 时使用事件驱动推进，更快，但碰撞在事件时刻而不是步长边界上检查，个别录像的结果会与游戏不同，
+    // 只给机器人和求解器估算用。无论 durationMicros 是多少，最多模拟
+    // ORBIT_REPLAY_MAX_DURATION_MICROS，超出时中止并设置 budgetExceeded
+    OrbitReplayResult replay(OrbitSimulation& sim, bool eventScheduled = false) const;
+
+    // 秒 <-> 微秒。界面在排队输入之前先取整到微秒，保证回放与录制时使用完全相同的时间
+    static qint64 toMicros(qreal seconds);
+    static qreal toSeconds(qint64 micros);
+    static qreal quantize(qreal seconds) { return toSeconds(toMicros(seconds)); }
+
+    quint64 levelHash;
+    quint64 seed;
+    qint64 durationMicros;
+    std::vector<OrbitReplayInput> inputs;
+};
+
+#endif // ORBITREPLAY_H
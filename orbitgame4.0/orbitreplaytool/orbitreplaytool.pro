@@ -0,0 +1,13 @@
+# 无界面回放校验工具，只依赖 QtCore：
+#   orbitreplaytool [--verbose] <关卡.json> <录像.orr>...
+QT = core
+
+CONFIG += c++17 console cmdline
+CONFIG -= app_bundle
+
+TARGET = orbitreplaytool
+
+SOURCES += \
+    main.cpp
+
+include(../orbitcore.pri)
@@ -0,0 +1,825 @@
+// 文件: orbitsimulation.cpp
+#include "orbitsimulation.h"
+#include <QDebug>
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+// FNV-1a over the raw bits of everything that affects the rules
+class LevelHasher
+{
+public:
+    void mixBytes(const void* data, size_t size)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            m_hash ^= bytes[i];
+            m_hash *= 1099511628211ULL;
+        }
+    }
+    void mixReal(qreal value)
+    {
+        double d = value;
+        mixBytes(&d, sizeof(d));
+    }
+    void mixInt(qint64 value) { mixBytes(&value, sizeof(value)); }
+    void mixEndTrigger(bool hasEnd, qreal x, qreal y, qreal radius)
+    {
+        mixInt(hasEnd ? 1 : 0);
+        if (hasEnd) {
+            mixReal(x);
+            mixReal(y);
+            mixReal(radius);
+        }
+    }
+    quint64 value() const { return m_hash; }
+
+private:
+    quint64 m_hash = 14695981039346656037ULL;
+};
+
+} // namespace
+
+OrbitSimulation::OrbitSimulation()
+    : m_trackBase(0),
+    m_collectibleBase(0),
+    m_obstacleBase(0),
+    m_levelTrackCount(0),
+    m_hasEndTrigger(false),
+    m_endTriggerX(0),
+    m_endTriggerY(0),
+    m_endTriggerRadius(0)
+{
+    reset();
+}
+
+void OrbitSimulation::loadLevel(const TrackData& level)
+{
+    loadLevelWindow(level, 0, 0, 0, static_cast<int>(level.segments.size()));
+}
+
+void OrbitSimulation::loadLevelWindow(const TrackData& window, int firstTrack, int firstCollectible, int firstObstacle, int levelTrackCount)
+{
+    m_trackBase = firstTrack;
+    m_collectibleBase = firstCollectible;
+    m_obstacleBase = firstObstacle;
+    m_levelTrackCount = levelTrackCount;
+    buildLevelTables(window);
+    reset();
+    // 只在加载关卡时输出；换驻留窗口 (setLevelWindow) 每次按 K 都会重建，不打日志
+    qDebug() << "OrbitSimulation: track grid" << m_trackGrid.columns() << "x" << m_trackGrid.rows()
+             << "cells of size" << m_trackGrid.cellSize() << "for" << m_tracks.size() << "tracks,"
+             << m_trackGrid.entryCount() << "entries.";
+}
+
+void OrbitSimulation::setLevelWindow(const TrackData& window, int firstTrack, int firstCollectible, int firstObstacle, int levelTrackCount)
+{
+    const int windowTracks = static_cast<int>(window.segments.size());
+    if (m_state.trackIndex < firstTrack || m_state.trackIndex >= firstTrack + windowTracks) {
+        qWarning() << "OrbitSimulation: level window [" << firstTrack << "," << firstTrack + windowTracks
+                   << ") does not contain the current track" << m_state.trackIndex << ". Ignoring it.";
+        return;
+    }
+
+    // 物品在新旧窗口里都按整关编号连续排列，按编号把仍驻留的物品的状态搬过去
+    const std::vector<Item> oldCollectibles = std::move(m_collectibles);
+    const std::vector<Item> oldObstacles = std::move(m_obstacles);
+    const int oldCollectibleBase = m_collectibleBase;
+    const int oldObstacleBase = m_obstacleBase;
+
+    m_trackBase = firstTrack;
+    m_collectibleBase = firstCollectible;
+    m_obstacleBase = firstObstacle;
+    m_levelTrackCount = levelTrackCount;
+    buildLevelTables(window);
+
+    auto carryOver = [](const std::vector<Item>& oldItems, int oldBase, std::vector<Item>* items, int base) {
+        for (size_t i = 0; i < items->size(); ++i) {
+            const qint64 old = qint64(base) + qint64(i) - oldBase;
+            if (old >= 0 && old < qint64(oldItems.size())) (*items)[i].consumed = oldItems[old].consumed;
+        }
+    };
+    carryOver(oldCollectibles, oldCollectibleBase, &m_collectibles, m_collectibleBase);
+    carryOver(oldObstacles, oldObstacleBase, &m_obstacles, m_obstacleBase);
+}
+
+bool OrbitSimulation::replaceLevel(const TrackData& level, const std::vector<int>& collectibleOrigin,
+                                   const std::vector<int>& obstacleOrigin)
+{
+    if (m_trackBase != 0 || m_state.trackIndex >= static_cast<int>(level.segments.size())) {
+        qWarning() << "OrbitSimulation: the edited level no longer contains the current track" << m_state.trackIndex;
+        return false;
+    }
+
+    const std::vector<Item> oldCollectibles = std::move(m_collectibles);
+    const std::vector<Item> oldObstacles = std::move(m_obstacles);
+    m_levelTrackCount = static_cast<int>(level.segments.size());
+    buildLevelTables(level);
+
+    auto carryOver = [](const std::vector<Item>& oldItems, const std::vector<int>& origin, std::vector<Item>* items) {
+        for (size_t i = 0; i < items->size() && i < origin.size(); ++i) {
+            if (origin[i] >= 0 && origin[i] < static_cast<int>(oldItems.size())) (*items)[i].consumed = oldItems[origin[i]].consumed;
+        }
+    };
+    carryOver(oldCollectibles, collectibleOrigin, &m_collectibles);
+    carryOver(oldObstacles, obstacleOrigin, &m_obstacles);
+    return true;
+}
+
+int OrbitSimulation::residentTrack(int trackIndex) const
+{
+    const int local = trackIndex - m_trackBase;
+    return (local >= 0 && local < static_cast<int>(m_tracks.size())) ? local : -1;
+}
+
+void OrbitSimulation::buildLevelTables(const TrackData& level)
+{
+    m_tracks.clear();
+    m_collectibles.clear();
+    m_obstacles.clear();
+    m_tracks.reserve(level.segments.size());
+
+    // 收集品和障碍物按 "轨道顺序 -> 轨道内顺序" 编号，与 GameScene 创建图元的顺序一致
+    for (size_t i = 0; i < level.segments.size(); ++i) {
+        const TrackSegmentData& segment = level.segments[i];
+        m_tracks.push_back({segment.centerX, segment.centerY, segment.radius});
+
+        for (const CollectibleData& cData : segment.collectibles) {
+            Item item;
+            item.trackIndex = static_cast<int>(i);
+            item.angle = qDegreesToRadians(cData.angleDegrees);
+            item.radialOffset = cData.radialOffset;
+            item.orbitRadius = segment.radius + item.radialOffset;
+            item.hitRadius = COLLECTIBLE_HIT_RADIUS;
+            item.consumed = false;
+            m_collectibles.push_back(item);
+        }
+        for (const ObstacleData& oData : segment.obstacles) {
+            Item item;
+            item.trackIndex = static_cast<int>(i);
+            item.angle = qDegreesToRadians(oData.angleDegrees);
+            item.radialOffset = oData.radialOffset;
+            item.orbitRadius = segment.radius + item.radialOffset;
+            item.hitRadius = OBSTACLE_HIT_RADIUS;
+            item.consumed = false;
+            m_obstacles.push_back(item);
+        }
+    }
+    const qreal effectiveBallRadius = BALL_RADIUS * TRACK_COLLISION_EFFECTIVE_RADIUS_FACTOR;
+    m_trackGrid.build(m_tracks, effectiveBallRadius);
+
+    // Neighbour rings the ship could touch while flying on the outer orbit of each ring
+    m_trackNeighbourStart.assign(1, 0);
+    m_trackNeighbours.clear();
+    std::vector<int> nearby;
+    for (size_t i = 0; i < m_tracks.size(); ++i) {
+        const TrackCircle& track = m_tracks[i];
+        const qreal reach = track.radius + BALL_RADIUS + ORBIT_PADDING;
+        nearby.clear();
+        m_trackGrid.tracksNear(track.centerX, track.centerY, reach, &nearby);
+        for (int j : nearby) {
+            if (j == static_cast<int>(i)) continue;
+            if (circlesOverlap(track.centerX, track.centerY, reach,
+                               m_tracks[j].centerX, m_tracks[j].centerY, m_tracks[j].radius + effectiveBallRadius)) {
+                m_trackNeighbours.push_back(j);
+            }
+        }
+        m_trackNeighbourStart.push_back(static_cast<int>(m_trackNeighbours.size()));
+    }
+    buildItemBuckets(m_collectibles, &m_collectibleBuckets);
+    buildItemBuckets(m_obstacles, &m_obstacleBuckets);
+}
+
+void OrbitSimulation::buildItemBuckets(const std::vector<Item>& items, ItemBuckets* buckets) const
+{
+    const int trackCount = static_cast<int>(m_tracks.size());
+    buckets->trackStart.assign(trackCount + 1, 0);
+    buckets->minRadius.assign(trackCount, 0);
+    for (const Item& item : items) buckets->trackStart[item.trackIndex + 1]++;
+    for (int i = 0; i < trackCount; ++i) buckets->trackStart[i + 1] += buckets->trackStart[i];
+
+    std::vector<int> fill(buckets->trackStart.begin(), buckets->trackStart.end() - 1);
+    buckets->items.assign(items.size(), -1);
+    for (size_t i = 0; i < items.size(); ++i) {
+        buckets->items[fill[items[i].trackIndex]++] = static_cast<int>(i);
+    }
+
+    auto normalizedAngle = [](qreal angle) {
+        angle = std::fmod(angle, 2.0 * M_PI);
+        if (angle < 0) angle += 2.0 * M_PI;
+        return angle;
+    };
+
+    buckets->angles.resize(items.size());
+    buckets->maxHitRadius = 0;
+    for (const Item& item : items) buckets->maxHitRadius = qMax(buckets->maxHitRadius, item.hitRadius);
+    for (int t = 0; t < trackCount; ++t) {
+        auto first = buckets->items.begin() + buckets->trackStart[t];
+        auto last = buckets->items.begin() + buckets->trackStart[t + 1];
+        std::sort(first, last, [&](int a, int b) {
+            const qreal angleA = normalizedAngle(items[a].angle);
+            const qreal angleB = normalizedAngle(items[b].angle);
+            if (angleA != angleB) return angleA < angleB;
+            return items[a].radialOffset < items[b].radialOffset;
+        });
+
+        qreal minRadius = m_tracks[t].radius;
+        for (int k = buckets->trackStart[t]; k < buckets->trackStart[t + 1]; ++k) {
+            const Item& item = items[buckets->items[k]];
+            buckets->angles[k] = normalizedAngle(item.angle);
+            minRadius = qMin(minRadius, item.orbitRadius);
+        }
+        buckets->minRadius[t] = minRadius;
+    }
+}
+
+void OrbitSimulation::setEndTrigger(qreal x, qreal y, qreal radius)
+{
+    m_hasEndTrigger = radius > 0;
+    m_endTriggerX = x;
+    m_endTriggerY = y;
+    m_endTriggerRadius = radius;
+}
+
+void OrbitSimulation::reset()
+{
+    m_state.trackIndex = 0;
+    m_state.angle = ANGLE_BOTTOM;                     // Start at the bottom of the first track
+    m_state.orbitOffset = BALL_RADIUS + ORBIT_PADDING; // Start on the outer orbit
+    m_state.rotationDirection = 1;
+    m_state.linearSpeed = BASE_LINEAR_SPEED;
+    m_state.speedLevel = 0;
+    m_state.score = 0;
+    m_state.health = MAX_HEALTH;
+    m_state.damageCooldownRemaining = 0;
+    m_state.gameOver = false;
+    m_state.levelCompleted = false;
+    m_state.time = 0;
+
+    for (Item& item : m_collectibles) item.consumed = false;
+    for (Item& item : m_obstacles) item.consumed = false;
+    m_pendingInputs.clear();
+    m_events.clear();
+}
+
+quint64 OrbitSimulation::levelHash() const
+{
+    LevelHasher hasher;
+    hasher.mixInt(static_cast<qint64>(m_tracks.size()));
+    for (const TrackCircle& track : m_tracks) {
+        hasher.mixReal(track.centerX);
+        hasher.mixReal(track.centerY);
+        hasher.mixReal(track.radius);
+    }
+    for (const std::vector<Item>* items : {&m_collectibles, &m_obstacles}) {
+        hasher.mixInt(static_cast<qint64>(items->size()));
+        for (const Item& item : *items) {
+            hasher.mixInt(item.trackIndex + m_trackBase);
+            hasher.mixReal(item.angle);
+            hasher.mixReal(item.radialOffset);
+        }
+    }
+    hasher.mixEndTrigger(m_hasEndTrigger, m_endTriggerX, m_endTriggerY, m_endTriggerRadius);
+    return hasher.value();
+}
+
+quint64 OrbitSimulation::levelHash(int trackCount, const std::function<TrackSegmentData(int)>& segmentAt,
+                                   qreal endX, qreal endY, qreal endRadius)
+{
+    // 与成员版本的混合顺序完全相同；物品数要在物品之前混入，所以轨道要读三遍
+    LevelHasher hasher;
+    hasher.mixInt(trackCount);
+    qint64 collectibleCount = 0;
+    qint64 obstacleCount = 0;
+    for (int i = 0; i < trackCount; ++i) {
+        const TrackSegmentData segment = segmentAt(i);
+        hasher.mixReal(segment.centerX);
+        hasher.mixReal(segment.centerY);
+        hasher.mixReal(segment.radius);
+        collectibleCount += static_cast<qint64>(segment.collectibles.size());
+        obstacleCount += static_cast<qint64>(segment.obstacles.size());
+    }
+    hasher.mixInt(collectibleCount);
+    for (int i = 0; i < trackCount; ++i) {
+        for (const CollectibleData& item : segmentAt(i).collectibles) {
+            hasher.mixInt(i);
+            hasher.mixReal(qDegreesToRadians(item.angleDegrees));
+            hasher.mixReal(item.radialOffset);
+        }
+    }
+    hasher.mixInt(obstacleCount);
+    for (int i = 0; i < trackCount; ++i) {
+        for (const ObstacleData& item : segmentAt(i).obstacles) {
+            hasher.mixInt(i);
+            hasher.mixReal(qDegreesToRadians(item.angleDegrees));
+            hasher.mixReal(item.radialOffset);
+        }
+    }
+    hasher.mixEndTrigger(endRadius > 0, endX, endY, endRadius);
+    return hasher.value();
+}
+
+std::vector<OrbitSimEvent> OrbitSimulation::takeEvents()
+{
+    std::vector<OrbitSimEvent> events;
+    events.swap(m_events);
+    return events;
+}
+
+bool OrbitSimulation::isCollectibleCollected(int index) const
+{
+    index -= m_collectibleBase;
+    return index >= 0 && index < collectibleCount() && m_collectibles[index].consumed;
+}
+
+bool OrbitSimulation::isObstacleHit(int index) const
+{
+    index -= m_obstacleBase;
+    return index >= 0 && index < obstacleCount() && m_obstacles[index].consumed;
+}
+
+qreal OrbitSimulation::effectiveOrbitRadius() const
+{
+    return effectiveOrbitRadius(m_state);
+}
+
+qreal OrbitSimulation::effectiveOrbitRadius(const OrbitSimState& state) const
+{
+    const int track = residentTrack(state.trackIndex);
+    if (track < 0) return BALL_RADIUS;
+    qreal effectiveRadius = m_tracks[track].radius + state.orbitOffset;
+    // Prevent ball from going inside the track center point if on inner orbit
+    if (effectiveRadius < BALL_RADIUS) effectiveRadius = BALL_RADIUS;
+    return effectiveRadius;
+}
+
+qreal OrbitSimulation::angularSpeed() const
+{
+    qreal effectiveRadius = effectiveOrbitRadius();
+    return (effectiveRadius > 0.01) ? (m_state.linearSpeed / effectiveRadius) : 0; // Avoid division by zero
+}
+
+void OrbitSimulation::shipPosition(qreal* x, qreal* y) const
+{
+    shipPosition(m_state, x, y);
+}
+
+void OrbitSimulation::shipPosition(const OrbitSimState& state, qreal* x, qreal* y) const
+{
+    const int trackIndex = residentTrack(state.trackIndex);
+    if (trackIndex < 0) {
+        *x = 0;
+        *y = 0;
+        return;
+    }
+    const TrackCircle& track = m_tracks[trackIndex];
+    qreal effectiveRadius = effectiveOrbitRadius(state);
+    *x = track.centerX + effectiveRadius * qCos(state.angle);
+    *y = track.centerY + effectiveRadius * qSin(state.angle);
+}
+
+OrbitSimState OrbitSimulation::interpolate(const OrbitSimState& from, const OrbitSimState& to, qreal alpha)
+{
+    OrbitSimState result = to;
+    // 换轨、方向改变或 J 键切换内外侧时两个状态之间没有连续的路径，直接取新状态（与模拟一样是跳过去的）
+    if (from.trackIndex != to.trackIndex || from.rotationDirection != to.rotationDirection
+        || (from.orbitOffset < 0) != (to.orbitOffset < 0)) {
+        return result;
+    }
+
+    // Shortest signed angle difference, so wrapping past 0/2PI does not spin the ship backwards
+    qreal angleDelta = to.angle - from.angle;
+    while (angleDelta <= -M_PI) angleDelta += 2.0 * M_PI;
+    while (angleDelta > M_PI) angleDelta -= 2.0 * M_PI;
+
+    result.angle = from.angle + angleDelta * alpha;
+    while (result.angle >= 2.0 * M_PI) result.angle -= 2.0 * M_PI;
+    while (result.angle < 0) result.angle += 2.0 * M_PI;
+    result.orbitOffset = from.orbitOffset + (to.orbitOffset - from.orbitOffset) * alpha;
+    return result;
+}
+
+void OrbitSimulation::step(qreal dtSeconds)
+{
+    if (!isRunning() || dtSeconds <= 0) return;
+
+    const qreal endTime = m_state.time + dtSeconds;
+    // Apply queued inputs at their own timestamps instead of at the end of the step
+    while (!m_pendingInputs.empty() && m_pendingInputs.front().time <= endTime && isRunning()) {
+        const PendingInput pending = m_pendingInputs.front();
+        m_pendingInputs.pop_front();
+        if (pending.time > m_state.time) advance(pending.time - m_state.time);
+        if (!isRunning()) return;
+        applyInput(pending.input, pending.judgeTime);
+    }
+    if (isRunning() && endTime > m_state.time) advance(endTime - m_state.time);
+}
+
+void OrbitSimulation::queueInput(OrbitInput input, qreal simTime)
+{
+    if (!isRunning()) return;
+    if (simTime <= m_state.time) {
+        applyInput(input, simTime);
+        return;
+    }
+    queueInput(input, simTime, simTime);
+}
+
+void OrbitSimulation::queueInput(OrbitInput input, qreal simTime, qreal applyTime)
+{
+    if (!isRunning()) return;
+    if (applyTime <= m_state.time) {
+        applyInput(input, simTime);
+        return;
+    }
+    // Keep the queue ordered by time; inputs almost always arrive in order, so search from the back
+    auto it = m_pendingInputs.end();
+    while (it != m_pendingInputs.begin() && (it - 1)->time > applyTime) --it;
+    m_pendingInputs.insert(it, {input, applyTime, simTime});
+}
+
+void OrbitSimulation::applyInput(OrbitInput input, qreal simTime)
+{
+    if (input == OrbitInput::SwitchTrack) {
+        judgeSwitchTrackAt(simTime);
+    } else {
+        pressSwitchOrbit();
+    }
+}
+
+qreal OrbitSimulation::angleAt(qreal simTime) const
+{
+    qreal angle = m_state.angle + angularSpeed() * (simTime - m_state.time) * m_state.rotationDirection;
+    while (angle >= 2.0 * M_PI) angle -= 2.0 * M_PI;
+    while (angle < 0) angle += 2.0 * M_PI;
+    return angle;
+}
+
+qreal OrbitSimulation::timeToOrbitWindow(qreal targetOrbitRadius, qreal targetAngle, qreal hitDistance) const
+{
+    const qreal never = std::numeric_limits<qreal>::infinity();
+    const qreal omega = angularSpeed();
+    qreal halfWidth = 0;
+    if (omega <= 0 || !orbitHitWindow(effectiveOrbitRadius(), targetOrbitRadius, hitDistance, &halfWidth)) {
+        return never;
+    }
+
+    // 目标在运动方向前方多少弧度
+    qreal ahead = std::fmod((targetAngle - m_state.angle) * m_state.rotationDirection, 2.0 * M_PI);
+    if (ahead < 0) ahead += 2.0 * M_PI;
+    // 已经在范围内（进入时的判定已经做过）: 下一个时刻是离开范围，不再原地返回 0
+    if (ahead < halfWidth) return (ahead + halfWidth) / omega;
+    if (ahead > 2.0 * M_PI - halfWidth) return (ahead + halfWidth - 2.0 * M_PI) / omega;
+    return (ahead - halfWidth) / omega;
+}
+
+qreal OrbitSimulation::timeToNextItem(const ItemBuckets& buckets, const std::vector<Item>& items) const
+{
+    qreal next = std::numeric_limits<qreal>::infinity();
+    const int track = residentTrack(m_state.trackIndex);
+    if (track < 0) return next;
+    for (int k = buckets.trackStart[track]; k < buckets.trackStart[track + 1]; ++k) {
+        const Item& item = items[buckets.items[k]];
+        if (item.consumed) continue;
+        next = qMin(next, timeToOrbitWindow(item.orbitRadius, item.angle, BALL_RADIUS + item.hitRadius));
+    }
+    return next;
+}
+
+qreal OrbitSimulation::timeToNextEvent() const
+{
+    if (!isRunning()) return 0;
+
+    // 到达判定点（正好在判定点上时取下一圈）
+    const qreal omega = angularSpeed();
+    qreal next = std::numeric_limits<qreal>::infinity();
+    if (omega > 0) {
+        qreal toTop = std::fmod((ANGLE_TOP - m_state.angle) * m_state.rotationDirection, 2.0 * M_PI);
+        if (toTop <= 0) toTop += 2.0 * M_PI;
+        next = toTop / omega;
+    }
+
+    if (m_state.damageCooldownRemaining > 0) next = qMin(next, m_state.damageCooldownRemaining);
+
+    // 无敌时间内障碍物和轨道碰撞都不生效；无敌结束本身就是一个事件，到时再看是否正处在碰撞范围内
+    next = qMin(next, timeToNextItem(m_collectibleBuckets, m_collectibles));
+    if (m_state.canTakeDamage()) next = qMin(next, timeToNextItem(m_obstacleBuckets, m_obstacles));
+
+    const int trackIndex = residentTrack(m_state.trackIndex);
+    if (trackIndex < 0) return std::numeric_limits<qreal>::infinity();
+    const TrackCircle& track = m_tracks[trackIndex];
+    if (m_state.orbitOffset > 0 && m_state.canTakeDamage()) {
+        const qreal effectiveBallRadius = BALL_RADIUS * TRACK_COLLISION_EFFECTIVE_RADIUS_FACTOR;
+        for (int k = m_trackNeighbourStart[trackIndex]; k < m_trackNeighbourStart[trackIndex + 1]; ++k) {
+            const TrackCircle& other = m_tracks[m_trackNeighbours[k]];
+            const qreal dx = other.centerX - track.centerX;
+            const qreal dy = other.centerY - track.centerY;
+            next = qMin(next, timeToOrbitWindow(qSqrt(dx * dx + dy * dy), qAtan2(dy, dx),
+                                                other.radius + effectiveBallRadius));
+        }
+    }
+
+    if (m_hasEndTrigger) {
+        const qreal dx = m_endTriggerX - track.centerX;
+        const qreal dy = m_endTriggerY - track.centerY;
+        next = qMin(next, timeToOrbitWindow(qSqrt(dx * dx + dy * dy), qAtan2(dy, dx),
+                                            BALL_RADIUS + m_endTriggerRadius));
+    }
+    return next;
+}
+
+qreal OrbitSimulation::advanceToNextEvent(qreal maxSeconds)
+{
+    if (!isRunning()) return 0;
+
+    // 已经到时间的输入先处理
+    if (!m_pendingInputs.empty() && m_pendingInputs.front().time <= m_state.time) {
+        const PendingInput pending = m_pendingInputs.front();
+        m_pendingInputs.pop_front();
+        applyInput(pending.input, pending.judgeTime);
+        return 0;
+    }
+
+    // 相邻轨道和通关点按飞船位置判定。输入可能刚把飞船放进它们的范围里，先在当前位置检查一次；
+    // 之后 timeToNextEvent 对已经在范围内的目标给出离开的时刻，不会按 SIM_EVENT_EPSILON_SECONDS 原地反复推进
+    if (m_state.canTakeDamage()) checkTrackCollisions();
+    checkEndTrigger();
+    if (!isRunning()) return 0;
+
+    qreal dt = qMin(timeToNextEvent() + SIM_EVENT_EPSILON_SECONDS, maxSeconds);
+    if (!m_pendingInputs.empty()) dt = qMin(dt, m_pendingInputs.front().time - m_state.time);
+    step(dt);
+    return dt;
+}
+
+void OrbitSimulation::advance(qreal dtSeconds)
+{
+    // 本步开始时剩余的无敌时间，这段时间里扫过的弧不会被障碍物伤害
+    const qreal invulnerableSeconds = qBound<qreal>(0, m_state.damageCooldownRemaining, dtSeconds);
+    m_state.time += dtSeconds;
+    advanceCooldown(dtSeconds);
+
+    const qreal previousAngle = m_state.angle;
+    const qreal sweep = angularSpeed() * dtSeconds;
+    m_state.angle += sweep * m_state.rotationDirection;
+
+    // Normalize angle to be within [0, 2*PI)
+    while (m_state.angle >= 2.0 * M_PI) m_state.angle -= 2.0 * M_PI;
+    while (m_state.angle < 0) m_state.angle += 2.0 * M_PI;
+
+    // 本步扫过的角度区间，按逆时针方向表示为 [sweepStart, sweepStart + sweep]。
+    // 物品按整段圆弧做连续碰撞，速度再快、步长再大也不会跳过
+    const qreal sweepStart = (m_state.rotationDirection > 0) ? previousAngle : previousAngle - sweep;
+    checkCollectibles(sweepStart, sweep);
+    // 障碍物只检查无敌时间结束之后扫过的那一段
+    const qreal vulnerableSweep = sweep * (dtSeconds - invulnerableSeconds) / dtSeconds;
+    const qreal obstacleSweepStart = (m_state.rotationDirection > 0) ? previousAngle + (sweep - vulnerableSweep) : sweepStart;
+    checkObstacles(obstacleSweepStart, vulnerableSweep);
+    if (m_state.canTakeDamage()) { // Only check for track collisions if not in cooldown
+        checkTrackCollisions();
+    }
+    checkEndTrigger();
+}
+
+void OrbitSimulation::advanceCooldown(qreal dtSeconds)
+{
+    if (m_state.damageCooldownRemaining > 0) {
+        m_state.damageCooldownRemaining -= dtSeconds;
+        if (m_state.damageCooldownRemaining < 0) m_state.damageCooldownRemaining = 0;
+    }
+}
+
+void OrbitSimulation::findItemCandidates(const ItemBuckets& buckets, qreal sweepStart, qreal sweep, std::vector<int>* out) const
+{
+    const int track = residentTrack(m_state.trackIndex);
+    if (track < 0) return;
+    const int first = buckets.trackStart[track];
+    const int last = buckets.trackStart[track + 1];
+    if (first == last) return;
+
+    // 角度容差用本轨道上离圆心最近的物品估算，是一个保守的上界
+    qreal margin = 0;
+    const bool wholeRing = !orbitAngularReach(buckets.minRadius[track], effectiveOrbitRadius(),
+                                              BALL_RADIUS + buckets.maxHitRadius, &margin);
+
+    qreal start = sweepStart - margin;
+    const qreal span = sweep + 2.0 * margin;
+    if (wholeRing || span >= 2.0 * M_PI) {
+        for (int k = first; k < last; ++k) out->push_back(buckets.items[k]);
+        return;
+    }
+
+    start = std::fmod(start, 2.0 * M_PI);
+    if (start < 0) start += 2.0 * M_PI;
+    const qreal end = start + span;
+
+    auto appendRange = [&](qreal from, qreal to) {
+        auto begin = buckets.angles.begin() + first;
+        auto finish = buckets.angles.begin() + last;
+        auto lo = std::lower_bound(begin, finish, from);
+        auto hi = std::upper_bound(lo, finish, to);
+        for (auto it = lo; it != hi; ++it) out->push_back(buckets.items[it - buckets.angles.begin()]);
+    };
+    if (end < 2.0 * M_PI) {
+        appendRange(start, end);
+    } else { // 区间跨过 0/2PI
+        appendRange(start, 2.0 * M_PI);
+        appendRange(0, end - 2.0 * M_PI);
+    }
+}
+
+void OrbitSimulation::checkCollectibles(qreal sweepStart, qreal sweep)
+{
+    m_candidateScratch.clear();
+    findItemCandidates(m_collectibleBuckets, sweepStart, sweep, &m_candidateScratch);
+    if (m_candidateScratch.empty()) return;
+
+    // 候选物品都在当前轨道上，直接在轨道坐标中与扫过的圆弧比较；按飞船经过的先后顺序处理
+    const qreal shipOrbitRadius = effectiveOrbitRadius();
+    const int count = static_cast<int>(m_candidateScratch.size());
+
+    for (int n = 0; n < count; ++n) {
+        const int i = m_candidateScratch[(m_state.rotationDirection > 0) ? n : count - 1 - n];
+        Item& item = m_collectibles[i];
+        if (item.consumed) continue;
+        if (orbitArcHitsCircle(shipOrbitRadius, sweepStart, sweep, BALL_RADIUS,
+                               item.orbitRadius, item.angle, item.hitRadius)) {
+            item.consumed = true;
+            pushEvent(OrbitSimEvent::CollectibleCollected, i + m_collectibleBase);
+            addScore(DEFAULT_SCORE_PER_COLLECTIBLE);
+        }
+    }
+}
+
+void OrbitSimulation::checkObstacles(qreal sweepStart, qreal sweep)
+{
+    if (!m_state.canTakeDamage()) return; // 无敌时间内障碍物不生效，保留给之后再撞
+
+    m_candidateScratch.clear();
+    findItemCandidates(m_obstacleBuckets, sweepStart, sweep, &m_candidateScratch);
+    if (m_candidateScratch.empty()) return;
+
+    // 候选物品都在当前轨道上，直接在轨道坐标中与扫过的圆弧比较；按飞船经过的先后顺序处理
+    const qreal shipOrbitRadius = effectiveOrbitRadius();
+    const int count = static_cast<int>(m_candidateScratch.size());
+
+    for (int n = 0; n < count; ++n) {
+        const int i = m_candidateScratch[(m_state.rotationDirection > 0) ? n : count - 1 - n];
+        Item& item = m_obstacles[i];
+        if (item.consumed) continue;
+        if (orbitArcHitsCircle(shipOrbitRadius, sweepStart, sweep, BALL_RADIUS,
+                               item.orbitRadius, item.angle, item.hitRadius)) {
+            item.consumed = true;
+            pushEvent(OrbitSimEvent::ObstacleHit, i + m_obstacleBase);
+            takeDamage();
+            return; // 受伤后进入无敌时间，本帧不再处理其他障碍物
+        }
+    }
+}
+
+void OrbitSimulation::checkTrackCollisions()
+{
+    // Only check if ball is on the outer orbit and can take damage
+    if (m_state.orbitOffset <= 0 || !m_state.canTakeDamage()) return;
+
+    qreal shipX, shipY;
+    shipPosition(&shipX, &shipY);
+    const qreal effectiveBallRadius = BALL_RADIUS * TRACK_COLLISION_EFFECTIVE_RADIUS_FACTOR;
+
+    // Only the rings registered in the ship's grid cell can overlap it (ascending index order)
+    const int* candidate;
+    const int* candidateEnd;
+    m_trackGrid.candidatesAt(shipX, shipY, &candidate, &candidateEnd);
+    const int currentTrack = residentTrack(m_state.trackIndex);
+    for (; candidate != candidateEnd; ++candidate) {
+        const int i = *candidate;
+        if (i == currentTrack) continue;
+
+        const TrackCircle& other = m_tracks[i];
+        if (circlesOverlap(shipX, shipY, effectiveBallRadius, other.centerX, other.centerY, other.radius)) {
+            pushEvent(OrbitSimEvent::TrackCollision, i + m_trackBase);
+            // Force ball to inner orbit of current track as a penalty/evasive maneuver
+            m_state.orbitOffset = -(BALL_RADIUS + ORBIT_PADDING);
+            takeDamage();
+            return;
+        }
+    }
+}
+
+void OrbitSimulation::checkEndTrigger()
+{
+    if (!m_hasEndTrigger || !isRunning()) return;
+
+    qreal shipX, shipY;
+    shipPosition(&shipX, &shipY);
+    if (circlesOverlap(shipX, shipY, BALL_RADIUS, m_endTriggerX, m_endTriggerY, m_endTriggerRadius)) {
+        m_state.levelCompleted = true;
+        pushEvent(OrbitSimEvent::LevelCompleted);
+    }
+}
+
+void OrbitSimulation::takeDamage()
+{
+    m_state.health--;
+    m_state.damageCooldownRemaining = DAMAGE_COOLDOWN_MS / 1000.0; // Start invincibility cooldown
+    if (m_state.health <= 0 && !m_state.gameOver) {
+        m_state.gameOver = true;
+        pushEvent(OrbitSimEvent::GameOver);
+    }
+}
+
+void OrbitSimulation::addScore(int amount)
+{
+    m_state.score += amount;
+
+    // Speed up logic
+    int targetLevel = m_state.score / SCORE_THRESHOLD_FOR_SPEEDUP;
+    if (targetLevel > m_state.speedLevel) {
+        m_state.speedLevel = targetLevel;
+        m_state.linearSpeed = BASE_LINEAR_SPEED * qPow(SPEEDUP_FACTOR, m_state.speedLevel);
+        pushEvent(OrbitSimEvent::SpeedUp, m_state.speedLevel);
+    }
+}
+
+OrbitJudgment OrbitSimulation::pressSwitchTrack()
+{
+    return judgeSwitchTrackAt(m_state.time);
+}
+
+OrbitJudgment OrbitSimulation::judgeSwitchTrackAt(qreal simTime)
+{
+    if (!isRunning()) return OrbitJudgment::None;
+
+    // Check if it's possible to switch to the next track
+    if (m_state.trackIndex + 1 >= trackCount()) {
+        return OrbitJudgment::None;
+    }
+    if (residentTrack(m_state.trackIndex + 1) < 0) {
+        // 流式加载跟不上时按最后一条轨道处理：不判定、不加分、不给无敌时间，留在当前轨道
+        qWarning() << "OrbitSimulation: track" << m_state.trackIndex + 1 << "is not resident. Staying on track" << m_state.trackIndex;
+        return OrbitJudgment::None;
+    }
+
+    // Calculate angle difference from the target (top of the circle) at the moment of the key press
+    qreal angleDiff = angleAt(simTime) - ANGLE_TOP;
+    // Normalize angle difference to be within -PI to PI
+    while (angleDiff <= -M_PI) angleDiff += 2.0 * M_PI;
+    while (angleDiff > M_PI) angleDiff -= 2.0 * M_PI;
+    qreal absAngleDiff = qAbs(angleDiff);
+
+    // Tolerances (convert from milliseconds to radians based on angular speed)
+    qreal perfectAngleTolerance = angularSpeed() * (PERFECT_MS / 1000.0);
+    qreal goodAngleTolerance = angularSpeed() * (GOOD_MS / 1000.0);
+
+    OrbitJudgment judgment;
+    if (absAngleDiff <= perfectAngleTolerance) {
+        judgment = OrbitJudgment::Perfect;
+    } else if (absAngleDiff <= goodAngleTolerance) {
+        judgment = OrbitJudgment::Good;
+    } else {
+        judgment = OrbitJudgment::Miss;
+    }
+    pushEvent(OrbitSimEvent::Judgment, m_state.trackIndex, judgment);
+
+    if (judgment == OrbitJudgment::Miss) {
+        // 乱按 K 只扣血，不触发无敌时间
+        m_state.health--;
+        if (m_state.health <= 0 && !m_state.gameOver) {
+            m_state.gameOver = true;
+            pushEvent(OrbitSimEvent::GameOver);
+        }
+        return judgment;
+    }
+
+    addScore(judgment == OrbitJudgment::Perfect ? SCORE_PERFECT : SCORE_GOOD);
+    switchTrack();
+    // Post-switch invulnerability
+    m_state.damageCooldownRemaining = DAMAGE_COOLDOWN_MS / 1000.0;
+    return judgment;
+}
+
+void OrbitSimulation::pressSwitchOrbit()
+{
+    if (!isRunning()) return;
+    m_state.orbitOffset = -m_state.orbitOffset; // Toggle sign
+    pushEvent(OrbitSimEvent::OrbitSwitched);
+}
+
+void OrbitSimulation::switchTrack()
+{
+    // judgeSwitchTrackAt 已经检查过，不能飞到没有数据的轨道上
+    if (m_state.trackIndex + 1 >= trackCount() || residentTrack(m_state.trackIndex + 1) < 0) return;
+
+    m_state.trackIndex++;
+    m_state.rotationDirection = -m_state.rotationDirection; // Reverse rotation on new track
+    m_state.angle = ANGLE_BOTTOM;                           // Reset angle to a consistent starting point
+    // 切换后飞船位于新轨道的内侧
+    m_state.orbitOffset = -(BALL_RADIUS + ORBIT_PADDING);
+    pushEvent(OrbitSimEvent::TrackSwitched, m_state.trackIndex);
+}
+
+void OrbitSimulation::pushEvent(OrbitSimEvent::Type type, int index, OrbitJudgment judgment)
+{
+    m_events.push_back({type, index, judgment});
+}
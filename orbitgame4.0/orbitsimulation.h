@@ -0,0 +1,269 @@
+#ifndef ORBITSIMULATION_H
+#define ORBITSIMULATION_H
+
+#include <vector>
+#include <deque>
+#include <functional>
+#include <QtGlobal>
+#include <QtMath>
+
+#include "trackdata.h"
+#include "trackspatialgrid.h"
+#include "orbitcollision.h"
+
+// ==========================================================================
+// OrbitSimulation: 不依赖 QtGui / QGraphicsScene 的游戏核心。
+// 保存全部游戏状态（轨道索引、角度、内外侧偏移、速度等级、生命、物品状态），
+// 并实现每一帧的推进规则与 K/J 按键判定。GameScene 只负责把这里的状态画出来，
+// 因此同一套规则可以在无界面的 Linux 机器上批量回放、验证关卡。
+// ==========================================================================
+
+// --- 游戏规则常量 ---
+const qreal BASE_LINEAR_SPEED = 150.0;
+const int SCORE_PERFECT = 2;
+const int SCORE_GOOD = 1;
+const int DEFAULT_SCORE_PER_COLLECTIBLE = 1;
+const int SCORE_THRESHOLD_FOR_SPEEDUP = 50;
+const qreal SPEEDUP_FACTOR = 1.1;
+const qreal BALL_RADIUS = 10.0;
+const qreal ORBIT_PADDING = 3.0;
+const qreal PERFECT_MS = 80.0;
+const qreal GOOD_MS = 160.0;
+const int DAMAGE_COOLDOWN_MS = 500;
+const int MAX_HEALTH = 10;
+const qreal ANGLE_TOP = 3 * M_PI / 2.0;
+const qreal ANGLE_BOTTOM = M_PI / 2.0;
+
+// 固定模拟步长（秒）。界面按真实流逝的时间累积，每攒够一步推进一次；
+// 无界面回放使用同一步长，因此结果与帧率无关
+const qreal SIM_FIXED_STEP_SECONDS = 1.0 / 120.0;
+// 事件驱动推进时越过事件时刻的一点余量，保证落在边界上的点判定（轨道/通关点）能够触发
+const qreal SIM_EVENT_EPSILON_SECONDS = 1e-7;
+
+// 轨道碰撞有效半径调整因子。值小于1.0会减少轨道间碰撞的敏感度，1.0为原始行为。
+// 值越小，飞船需要更深入地“侵入”其他轨道的范围才会判定为碰撞。
+const qreal TRACK_COLLISION_EFFECTIVE_RADIUS_FACTOR = 0.8;
+
+// --- 碰撞半径（见 orbitcollision.h，碰撞只按半径计算，与贴图形状无关） ---
+const qreal DEFAULT_COLLECTIBLE_TARGET_SIZE = 25.0; // 收集品贴图边长
+const qreal DEFAULT_OBSTACLE_TARGET_SIZE = 25.0;    // 障碍物贴图边长
+const qreal DEFAULT_END_POINT_RADIUS = DEFAULT_END_TRIGGER_RADIUS; // 默认通关点半径（通关点的位置写在关卡文件里）
+const qreal COLLECTIBLE_HIT_RADIUS = DEFAULT_COLLECTIBLE_TARGET_SIZE / 2.0;
+const qreal OBSTACLE_HIT_RADIUS = DEFAULT_OBSTACLE_TARGET_SIZE / 2.0;
+
+// K 键判定结果
+enum class OrbitJudgment {
+    None,
+    Perfect,
+    Good,
+    Miss
+};
+
+// 玩家输入
+enum class OrbitInput {
+    SwitchTrack, // K
+    SwitchOrbit  // J
+};
+
+// 一次 step()/按键 产生的事件，GameScene 据此播放特效、刷新 HUD
+struct OrbitSimEvent {
+    enum Type {
+        Judgment,             // K 键判定，judgment 字段有效
+        CollectibleCollected, // index 为收集品索引
+        ObstacleHit,          // index 为障碍物索引
+        TrackCollision,       // index 为被撞到的轨道索引
+        TrackSwitched,        // index 为新的轨道索引
+        OrbitSwitched,        // J 键切换内外侧
+        SpeedUp,              // index 为新的速度等级
+        GameOver,             // 生命耗尽
+        LevelCompleted        // 飞船碰到通关点
+    };
+
+    Type type;
+    int index;
+    OrbitJudgment judgment;
+};
+
+// 游戏状态（纯数据，可以直接拷贝用于快照/插值）
+struct OrbitSimState {
+    int trackIndex;
+    qreal angle;                   // 飞船在当前轨道上的角度（弧度, [0, 2PI)）
+    qreal orbitOffset;             // 正数为外侧, 负数为内侧
+    int rotationDirection;         // 1 或 -1
+    qreal linearSpeed;
+    int speedLevel;
+    int score;
+    int health;
+    qreal damageCooldownRemaining; // 剩余无敌时间（秒）, <= 0 表示可以受伤
+    bool gameOver;                 // 生命耗尽
+    bool levelCompleted;           // 到达通关点
+    qreal time;                    // 累计模拟时间（秒）
+
+    bool canTakeDamage() const { return damageCooldownRemaining <= 0.0; }
+};
+
+class OrbitSimulation
+{
+public:
+    OrbitSimulation();
+
+    // 从关卡数据构建轨道与物品表，并重置状态
+    void loadLevel(const TrackData& level);
+
+    // --- 流式关卡 ---
+    // 只让整关中的一段轨道驻留: window 是从 firstTrack 开始的连续几条轨道，
+    // firstCollectible / firstObstacle 是窗口中第一个收集品/障碍物在整关中的编号，levelTrackCount 是整关的轨道数。
+    // 轨道索引、事件和 isCollectibleCollected/isObstacleHit 的参数始终是整关中的编号，与窗口无关。
+    // 同 loadLevel，加载后重置状态（窗口应包含第一条轨道）
+    void loadLevelWindow(const TrackData& window, int firstTrack, int firstCollectible, int firstObstacle, int levelTrackCount);
+    // 游戏进行中移动窗口: 状态不变，仍在窗口内的物品保留已收集/已撞过的标记。
+    // 当前轨道必须在新窗口内；要换到下一条轨道，下一条轨道也必须已经在窗口内
+    void setLevelWindow(const TrackData& window, int firstTrack, int firstCollectible, int firstObstacle, int levelTrackCount);
+    // 关卡热重载: 换成修改过的整关（非流式），状态不变。collectibleOrigin / obstacleOrigin 给出新关卡中
+    // 每个物品在旧关卡里的编号（-1 表示新增），已收集/已撞过的标记按它搬过去。
+    // 当前轨道被删掉时不做任何修改，返回 false
+    bool replaceLevel(const TrackData& level, const std::vector<int>& collectibleOrigin, const std::vector<int>& obstacleOrigin);
+    int firstResidentTrack() const { return m_trackBase; }
+    int residentTrackCount() const { return static_cast<int>(m_tracks.size()); }
+    // 设置通关触发点（场景坐标）。radius <= 0 表示没有通关点
+    void setEndTrigger(qreal x, qreal y, qreal radius);
+    // 回到第一条轨道的起点，恢复全部物品
+    void reset();
+
+    // 推进 dtSeconds 秒：移动飞船并处理所有碰撞。
+    // 落在这段时间内的排队输入会在各自的时刻生效（步长在输入时刻处被切开）
+    void step(qreal dtSeconds);
+    // 按输入发生的模拟时间排队。时间早于当前状态的输入会立即处理，
+    // 判定使用从当前状态解析倒推出的角度，因此判定精度与帧率无关
+    void queueInput(OrbitInput input, qreal simTime);
+    // 同上，但输入在 applyTime 才真正生效（判定仍按 simTime）。
+    // 回放用它重现界面中“按键到达时模拟已经跑过了按键时刻”的情况
+    void queueInput(OrbitInput input, qreal simTime, qreal applyTime);
+    // K 键：在判定点附近切换到下一条轨道（按当前模拟时间判定）。已经是最后一条轨道，
+    // 或者下一条轨道不在驻留窗口里时返回 None，状态不变
+    OrbitJudgment pressSwitchTrack();
+    // J 键：切换轨道内外侧
+    void pressSwitchOrbit();
+    // 飞船在 simTime 时刻的角度（沿当前轨道解析外推，不改变状态）
+    qreal angleAt(qreal simTime) const;
+
+    // --- 事件驱动推进 ---
+    // 圆轨道上接下来会发生的事都能解析算出: 到达判定点 ANGLE_TOP、进入某个物品的命中范围、
+    // 无敌时间结束、进入相邻轨道或通关点的碰撞范围。
+    // 离最近一个这样的时刻还有多少秒（不含排队的输入）
+    qreal timeToNextEvent() const;
+    // 直接推进到下一个事件（不超过 maxSeconds，也不跨过排队的输入），返回实际推进的秒数。
+    // 无界面回放/机器人跑完一整关只需要几百次推进，而不是上万个固定步长
+    qreal advanceToNextEvent(qreal maxSeconds);
+
+    const OrbitSimState& state() const { return m_state; }
+    // 当前关卡（轨道、物品、通关点）的 64 位指纹，回放文件用它确认是同一关。
+    // 只覆盖驻留的轨道，流式加载时请用下面的静态版本
+    quint64 levelHash() const;
+    // 同一个指纹，但轨道由 segmentAt(0 .. trackCount - 1) 逐条提供，整关不必同时驻留内存
+    static quint64 levelHash(int trackCount, const std::function<TrackSegmentData(int)>& segmentAt,
+                             qreal endX, qreal endY, qreal endRadius);
+    bool isRunning() const { return !m_state.gameOver && !m_state.levelCompleted && !m_tracks.empty(); }
+
+    // 取走自上次调用以来产生的事件
+    std::vector<OrbitSimEvent> takeEvents();
+
+    int trackCount() const { return m_levelTrackCount; } // 整关的轨道数
+    // 驻留的收集品/障碍物数
+    int collectibleCount() const { return static_cast<int>(m_collectibles.size()); }
+    int obstacleCount() const { return static_cast<int>(m_obstacles.size()); }
+    bool isCollectibleCollected(int index) const;
+    bool isObstacleHit(int index) const;
+
+    // 飞船当前所在的实际轨道半径（轨道半径 + 内外侧偏移）
+    qreal effectiveOrbitRadius() const;
+    // 当前轨道上的角速度（弧度/秒，不含方向）
+    qreal angularSpeed() const;
+    // 飞船中心的场景坐标
+    void shipPosition(qreal* x, qreal* y) const;
+    // 按任意状态（例如两次模拟之间插值出的状态）计算飞船中心
+    void shipPosition(const OrbitSimState& state, qreal* x, qreal* y) const;
+    // 在两个模拟状态之间插值，alpha 为 0 时等于 from，为 1 时等于 to。
+    // 换轨、反向或切换内外侧时没有连续路径，直接返回 to
+    static OrbitSimState interpolate(const OrbitSimState& from, const OrbitSimState& to, qreal alpha);
+
+private:
+    struct Item {
+        int trackIndex;     // 驻留轨道表 m_tracks 中的位置
+        qreal angle;        // 弧度
+        qreal radialOffset;
+        qreal orbitRadius;  // 到轨道圆心的距离（轨道半径 + 径向偏移）
+        qreal hitRadius;
+        bool consumed;      // 已收集 / 已撞过
+    };
+
+    // 按轨道分桶、桶内按 (角度, 径向偏移) 排好序的物品索引（扁平数组）。
+    // 飞船只会碰到自己当前轨道上的物品，查询时对本步扫过的角度区间做二分查找即可
+    struct ItemBuckets {
+        std::vector<int> trackStart; // 轨道 i 的物品位于 [trackStart[i], trackStart[i + 1])
+        std::vector<qreal> angles;   // 归一化到 [0, 2PI) 的角度，与 items 一一对应
+        std::vector<int> items;      // 物品在 m_collectibles / m_obstacles 中的索引
+        std::vector<qreal> minRadius; // 每条轨道上物品到圆心的最小距离，用来估算角度容差
+        qreal maxHitRadius = 0;
+    };
+
+    struct PendingInput {
+        OrbitInput input;
+        qreal time;      // 生效时刻
+        qreal judgeTime; // 判定时刻（K 键按这个时刻的角度判定）
+    };
+
+    // 按窗口重建轨道、空间索引和物品表（物品全部未处理）
+    void buildLevelTables(const TrackData& window);
+    // 整关的轨道编号在 m_tracks 中的位置，不在窗口内时返回 -1
+    int residentTrack(int trackIndex) const;
+    qreal effectiveOrbitRadius(const OrbitSimState& state) const;
+    void advance(qreal dtSeconds);
+    // 沿当前运动方向，飞船进入与 (targetOrbitRadius, targetAngle)（当前轨道坐标）距离小于 hitDistance 的范围
+    // 还需要多少秒。已经在范围内时返回离开范围的时刻（扫过的圆弧仍会判定这段范围），永远进不去时返回无穷大
+    qreal timeToOrbitWindow(qreal targetOrbitRadius, qreal targetAngle, qreal hitDistance) const;
+    // 当前轨道上 buckets 中尚未处理的物品里，最早进入命中范围的时间
+    qreal timeToNextItem(const ItemBuckets& buckets, const std::vector<Item>& items) const;
+    void applyInput(OrbitInput input, qreal simTime);
+    OrbitJudgment judgeSwitchTrackAt(qreal simTime);
+    void advanceCooldown(qreal dtSeconds);
+    void buildItemBuckets(const std::vector<Item>& items, ItemBuckets* buckets) const;
+    // 把当前轨道上、角度落在扫过区间 [sweepStart, sweepStart + sweep]（含命中容差）内的物品追加到 out
+    void findItemCandidates(const ItemBuckets& buckets, qreal sweepStart, qreal sweep, std::vector<int>* out) const;
+    void checkCollectibles(qreal sweepStart, qreal sweep);
+    void checkObstacles(qreal sweepStart, qreal sweep);
+    void checkTrackCollisions();
+    void checkEndTrigger();
+    void takeDamage();
+    void addScore(int amount);
+    void switchTrack();
+    void pushEvent(OrbitSimEvent::Type type, int index = -1, OrbitJudgment judgment = OrbitJudgment::None);
+
+    // 驻留窗口: m_tracks[0] 是整关第 m_trackBase 条轨道，物品同理
+    int m_trackBase;
+    int m_collectibleBase;
+    int m_obstacleBase;
+    int m_levelTrackCount;
+
+    std::vector<TrackCircle> m_tracks;
+    TrackSpatialGrid m_trackGrid; // 轨道碰撞的空间索引，loadLevel 时构建
+    // 每条轨道在外侧飞行时可能撞到的相邻轨道（CSR 布局），供事件驱动推进计算碰撞时刻
+    std::vector<int> m_trackNeighbourStart;
+    std::vector<int> m_trackNeighbours;
+    std::vector<Item> m_collectibles;
+    std::vector<Item> m_obstacles;
+    ItemBuckets m_collectibleBuckets;
+    ItemBuckets m_obstacleBuckets;
+    std::vector<int> m_candidateScratch; // findItemCandidates 的结果缓冲，避免每步分配
+
+    bool m_hasEndTrigger;
+    qreal m_endTriggerX;
+    qreal m_endTriggerY;
+    qreal m_endTriggerRadius;
+
+    OrbitSimState m_state;
+    std::deque<PendingInput> m_pendingInputs; // 按时间排序
+    std::vector<OrbitSimEvent> m_events;
+};
+
+#endif // ORBITSIMULATION_H
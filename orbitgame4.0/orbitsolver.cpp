@@ -0,0 +1,398 @@
+#include "orbitsolver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <QDebug>
+
+namespace {
+
+// 某一侧在 [from, to]（progress）内不能停留 / 可以拿到某个收集品
+struct SolverWindow {
+    enum Kind {
+        Collectible,
+        Obstacle,
+        Ring,
+        End // 通关点所在的一侧以外都算不能停留
+    };
+    qreal from;
+    qreal to;
+    bool outer;
+    Kind kind;
+    int index; // 收集品 / 障碍物在本轨道内的索引，或相邻轨道索引
+};
+
+qreal normalizeAngle(qreal angle)
+{
+    angle = std::fmod(angle, 2.0 * M_PI);
+    if (angle < 0) angle += 2.0 * M_PI;
+    return angle;
+}
+
+// 把以 center 为中心、半宽 halfWidth 的命中范围（可能跨过 0/2PI）裁剪到 [0, arc] 后追加到 out
+void addWindows(qreal center, qreal halfWidth, qreal arc, SolverWindow window, std::vector<SolverWindow>* out)
+{
+    if (halfWidth <= 0) return;
+    if (halfWidth >= M_PI) {
+        window.from = 0;
+        window.to = arc;
+        out->push_back(window);
+        return;
+    }
+    // arc 最多接近 2PI，往前往后各平移一圈就能覆盖所有重复
+    for (int turn = -1; turn <= 1; ++turn) {
+        const qreal from = center - halfWidth + turn * 2.0 * M_PI;
+        const qreal to = center + halfWidth + turn * 2.0 * M_PI;
+        if (to < 0 || from > arc) continue;
+        window.from = qMax<qreal>(from, 0);
+        window.to = qMin(to, arc);
+        out->push_back(window);
+    }
+}
+
+qreal sideRadius(qreal trackRadius, bool outer)
+{
+    // 与 OrbitSimulation::effectiveOrbitRadius 相同
+    const qreal offset = outer ? (BALL_RADIUS + ORBIT_PADDING) : -(BALL_RADIUS + ORBIT_PADDING);
+    return qMax(trackRadius + offset, BALL_RADIUS);
+}
+
+} // namespace
+
+OrbitSolver::OrbitSolver()
+{
+}
+
+qreal OrbitSolver::progressOf(int trackIndex, qreal angle) const
+{
+    const int direction = (trackIndex % 2 == 0) ? 1 : -1;
+    return normalizeAngle(direction * (angle - ANGLE_BOTTOM));
+}
+
+bool OrbitSolver::desiredOuter(int trackIndex, qreal progress) const
+{
+    const std::vector<Toggle>& plan = m_plans[trackIndex];
+    auto it = std::upper_bound(plan.begin(), plan.end(), progress,
+                               [](qreal p, const Toggle& toggle) { return p < toggle.progress; });
+    if (it == plan.begin()) return plan.front().outer;
+    return (it - 1)->outer;
+}
+
+OrbitSolverResult OrbitSolver::solve(const TrackData& level, qreal endX, qreal endY, qreal endRadius)
+{
+    OrbitSolverResult result;
+    result.endReachable = endRadius <= 0;
+    const int trackCount = static_cast<int>(level.segments.size());
+    m_plans.assign(trackCount, std::vector<Toggle>());
+    m_arcs.assign(trackCount, M_PI);
+    m_radii.resize(trackCount);
+    if (trackCount == 0) return result;
+
+    std::vector<TrackCircle> tracks;
+    tracks.reserve(trackCount);
+    for (int i = 0; i < trackCount; ++i) {
+        const TrackSegmentData& segment = level.segments[i];
+        tracks.push_back({segment.centerX, segment.centerY, segment.radius});
+        m_radii[i] = segment.radius;
+    }
+    TrackSpatialGrid grid;
+    grid.build(tracks, BALL_RADIUS * TRACK_COLLISION_EFFECTIVE_RADIUS_FACTOR);
+
+    // 按计划估算每条轨道上的速度（影响换轨后无敌时间覆盖的角度）
+    int expectedScore = 0;
+    int firstObstacle = 0;
+    for (int i = 0; i < trackCount; ++i) {
+        const qreal linearSpeed = BASE_LINEAR_SPEED * qPow(SPEEDUP_FACTOR, expectedScore / SCORE_THRESHOLD_FOR_SPEEDUP);
+        planTrack(level, i, grid, linearSpeed, endX, endY, endRadius, &result);
+        // planTrack 里的物品索引是轨道内的局部索引，这里换算成 OrbitSimulation 使用的全局索引
+        OrbitSolverSegment& segment = result.segments.back();
+        for (int& index : segment.unavoidableObstacles) index += firstObstacle;
+        firstObstacle += static_cast<int>(level.segments[i].obstacles.size());
+        expectedScore += segment.plannedCollectibles * DEFAULT_SCORE_PER_COLLECTIBLE + SCORE_PERFECT;
+    }
+
+    execute(level, endX, endY, endRadius, &result);
+    return result;
+}
+
+void OrbitSolver::planTrack(const TrackData& level, int trackIndex, const TrackSpatialGrid& grid, qreal linearSpeed,
+                            qreal endX, qreal endY, qreal endRadius, OrbitSolverResult* result)
+{
+    const TrackSegmentData& segment = level.segments[trackIndex];
+    const bool lastTrack = trackIndex + 1 == static_cast<int>(level.segments.size());
+    const qreal outerRadius = sideRadius(segment.radius, true);
+    const qreal innerRadius = sideRadius(segment.radius, false);
+
+    // 要飞过的角度：普通轨道飞到 ANGLE_TOP 按 K；最后一条轨道飞到第一次碰到通关点为止
+    qreal arc = M_PI;
+    bool hasEnd = false;
+    bool endOuter = false;
+    if (lastTrack && endRadius > 0) {
+        const qreal dx = endX - segment.centerX;
+        const qreal dy = endY - segment.centerY;
+        const qreal endDistance = qSqrt(dx * dx + dy * dy);
+        const qreal center = progressOf(trackIndex, qAtan2(dy, dx));
+        qreal best = std::numeric_limits<qreal>::infinity();
+        for (bool outer : {true, false}) {
+            qreal halfWidth;
+            if (!orbitHitWindow(sideRadius(segment.radius, outer), endDistance, BALL_RADIUS + endRadius, &halfWidth)) continue;
+            // 命中范围里（离边界留出余量）最早的位置；起点已经在范围内时为 0
+            qreal entry = 0;
+            if (halfWidth < M_PI && qAbs(normalizeAngle(center + M_PI) - M_PI) > halfWidth) {
+                entry = normalizeAngle(center - halfWidth + qMin(SOLVER_ANGLE_MARGIN, halfWidth));
+            }
+            if (entry < best) {
+                best = entry;
+                endOuter = outer;
+            }
+        }
+        if (best < std::numeric_limits<qreal>::infinity()) {
+            arc = qMax(best, SOLVER_ANGLE_MARGIN);
+            hasEnd = true;
+            result->endReachable = true;
+        }
+    }
+    m_arcs[trackIndex] = arc;
+
+    // 换轨后有 DAMAGE_COOLDOWN_MS 的无敌时间，这段角度内的障碍物和相邻轨道都不算危险。
+    // 按外侧（角速度较慢）估算，保守一些
+    qreal graceProgress = 0;
+    if (trackIndex > 0) {
+        graceProgress = qMax<qreal>(linearSpeed * (DAMAGE_COOLDOWN_MS / 1000.0) / outerRadius - SOLVER_ANGLE_MARGIN, 0);
+    }
+
+    // --- 每一侧的命中范围 ---
+    std::vector<SolverWindow> windows;
+    const int collectibleCount = static_cast<int>(segment.collectibles.size());
+    for (int c = 0; c < collectibleCount; ++c) {
+        const CollectibleData& data = segment.collectibles[c];
+        const qreal center = progressOf(trackIndex, qDegreesToRadians(data.angleDegrees));
+        for (bool outer : {true, false}) {
+            qreal halfWidth;
+            if (!orbitHitWindow(outer ? outerRadius : innerRadius, segment.radius + data.radialOffset,
+                                BALL_RADIUS + COLLECTIBLE_HIT_RADIUS, &halfWidth)) continue;
+            // 收集品的范围往里收一点，计划执行稍有偏差也能拿到
+            addWindows(center, halfWidth - SOLVER_ANGLE_MARGIN, arc, {0, 0, outer, SolverWindow::Collectible, c}, &windows);
+        }
+    }
+    for (int o = 0; o < static_cast<int>(segment.obstacles.size()); ++o) {
+        const ObstacleData& data = segment.obstacles[o];
+        const qreal center = progressOf(trackIndex, qDegreesToRadians(data.angleDegrees));
+        for (bool outer : {true, false}) {
+            qreal halfWidth;
+            if (!orbitHitWindow(outer ? outerRadius : innerRadius, segment.radius + data.radialOffset,
+                                BALL_RADIUS + OBSTACLE_HIT_RADIUS, &halfWidth)) continue;
+            addWindows(center, halfWidth + SOLVER_ANGLE_MARGIN, arc, {0, 0, outer, SolverWindow::Obstacle, o}, &windows);
+        }
+    }
+    // 相邻轨道只在外侧飞行时会撞上（与 OrbitSimulation::checkTrackCollisions 相同）
+    const qreal effectiveBallRadius = BALL_RADIUS * TRACK_COLLISION_EFFECTIVE_RADIUS_FACTOR;
+    std::vector<int> nearby;
+    grid.tracksNear(segment.centerX, segment.centerY, outerRadius, &nearby);
+    for (int j : nearby) {
+        if (j == trackIndex) continue;
+        const TrackSegmentData& other = level.segments[j];
+        const qreal dx = other.centerX - segment.centerX;
+        const qreal dy = other.centerY - segment.centerY;
+        qreal halfWidth;
+        if (!orbitHitWindow(outerRadius, qSqrt(dx * dx + dy * dy), other.radius + effectiveBallRadius, &halfWidth)) continue;
+        addWindows(progressOf(trackIndex, qAtan2(dy, dx)), halfWidth + SOLVER_ANGLE_MARGIN, arc,
+                   {0, 0, true, SolverWindow::Ring, j}, &windows);
+    }
+    for (SolverWindow& window : windows) {
+        if (window.kind != SolverWindow::Collectible) window.from = qMax(window.from, graceProgress);
+    }
+    windows.erase(std::remove_if(windows.begin(), windows.end(),
+                                 [](const SolverWindow& window) { return window.to <= window.from; }),
+                  windows.end());
+    // 到达终点前的最后一小段必须在能碰到通关点的那一侧
+    if (hasEnd) {
+        windows.push_back({qMax<qreal>(arc - SOLVER_ANGLE_MARGIN, 0), arc, !endOuter, SolverWindow::End, -1});
+    }
+
+    // --- 按所有窗口端点把 [0, arc] 切成小段，每段内两侧的情况不变 ---
+    std::vector<qreal> breaks = {0, arc};
+    for (const SolverWindow& window : windows) {
+        breaks.push_back(window.from);
+        breaks.push_back(window.to);
+    }
+    std::sort(breaks.begin(), breaks.end());
+    breaks.erase(std::unique(breaks.begin(), breaks.end()), breaks.end());
+
+    // 每个收集品最晚还能在哪里拿到（两侧取较晚的），用于按截止时间优先分配
+    std::vector<qreal> deadline(collectibleCount, -1);
+    for (const SolverWindow& window : windows) {
+        if (window.kind == SolverWindow::Collectible) deadline[window.index] = qMax(deadline[window.index], window.to);
+    }
+    std::vector<bool> collected(collectibleCount, false);
+    int reachable = 0;
+    for (int c = 0; c < collectibleCount; ++c) {
+        if (deadline[c] >= 0) reachable++;
+    }
+
+    OrbitSolverSegment report;
+    report.trackIndex = trackIndex;
+    report.arcRadians = arc;
+    report.collectibles = collectibleCount;
+    report.reachableCollectibles = reachable;
+    report.plannedCollectibles = 0;
+    report.orbitSwitches = 0;
+
+    std::vector<Toggle>& plan = m_plans[trackIndex];
+    bool current = (trackIndex == 0); // 第一条轨道从外侧出发，之后每次换轨都落在内侧
+    for (size_t k = 0; k + 1 < breaks.size(); ++k) {
+        const qreal from = breaks[k];
+        const qreal to = breaks[k + 1];
+        if (to - from <= 0) continue;
+        const qreal mid = 0.5 * (from + to);
+
+        bool blocked[2] = {false, false}; // [0] 内侧, [1] 外侧
+        bool ringBlocked = false;
+        qreal earliestNeed[2] = {std::numeric_limits<qreal>::infinity(), std::numeric_limits<qreal>::infinity()};
+        for (const SolverWindow& window : windows) {
+            if (mid < window.from || mid > window.to) continue;
+            const int side = window.outer ? 1 : 0;
+            if (window.kind == SolverWindow::Collectible) {
+                if (!collected[window.index]) earliestNeed[side] = qMin(earliestNeed[side], deadline[window.index]);
+            } else {
+                blocked[side] = true;
+                if (window.kind == SolverWindow::Ring) ringBlocked = true;
+            }
+        }
+
+        bool outer;
+        if (blocked[0] && blocked[1]) {
+            // 无论走哪边都会受伤：外侧撞轨道还会被强制推到内侧，所以走内侧
+            outer = false;
+            for (const SolverWindow& window : windows) {
+                if (mid < window.from || mid > window.to) continue;
+                if (window.kind == SolverWindow::Obstacle && !window.outer) {
+                    if (std::find(report.unavoidableObstacles.begin(), report.unavoidableObstacles.end(), window.index)
+                        == report.unavoidableObstacles.end()) {
+                        report.unavoidableObstacles.push_back(window.index);
+                    }
+                }
+                if (ringBlocked && window.kind == SolverWindow::Ring) {
+                    if (std::find(report.unavoidableRings.begin(), report.unavoidableRings.end(), window.index)
+                        == report.unavoidableRings.end()) {
+                        report.unavoidableRings.push_back(window.index);
+                    }
+                }
+            }
+        } else if (blocked[0] || blocked[1]) {
+            outer = blocked[0];
+        } else if (earliestNeed[0] != earliestNeed[1]) {
+            // 两侧都安全：先去拿截止得早的收集品
+            outer = earliestNeed[1] < earliestNeed[0];
+        } else {
+            outer = current; // 没有需要，保持当前一侧，少按 J
+        }
+
+        for (const SolverWindow& window : windows) {
+            if (window.kind == SolverWindow::Collectible && window.outer == outer
+                && mid >= window.from && mid <= window.to && !collected[window.index]) {
+                collected[window.index] = true;
+                report.plannedCollectibles++;
+            }
+        }
+        if (plan.empty() || outer != current) {
+            if (!plan.empty() || outer != (trackIndex == 0)) report.orbitSwitches++;
+            plan.push_back({plan.empty() ? 0 : from, outer});
+            current = outer;
+        }
+    }
+    if (plan.empty()) plan.push_back({0, current});
+
+    if (!report.unavoidableObstacles.empty() || !report.unavoidableRings.empty()) {
+        qDebug() << "OrbitSolver: track" << trackIndex << "has unavoidable damage, obstacles"
+                 << report.unavoidableObstacles.size() << "rings" << report.unavoidableRings.size();
+    }
+    result->segments.push_back(report);
+}
+
+void OrbitSolver::execute(const TrackData& level, qreal endX, qreal endY, qreal endRadius, OrbitSolverResult* result)
+{
+    OrbitSimulation sim;
+    sim.loadLevel(level);
+    sim.setEndTrigger(endX, endY, endRadius);
+
+    OrbitReplay& replay = result->replay;
+    replay.clear();
+    replay.levelHash = sim.levelHash();
+
+    // 与 GameScene::queueRecordedInput 相同：先取整到微秒，再记录并排队
+    auto queue = [&](OrbitInput input, qreal time) {
+        time = OrbitReplay::quantize(time);
+        replay.addInput(input, time, sim.state().time);
+        sim.queueInput(input, time);
+    };
+
+    const int lastTrack = sim.trackCount() - 1;
+    qreal stopTime = SOLVER_MAX_SIM_SECONDS;
+    bool onLastTrack = false;
+    while (sim.isRunning() && sim.state().time < stopTime) {
+        const OrbitSimState& state = sim.state();
+        if (!onLastTrack && state.trackIndex == lastTrack) {
+            // 没有通关点（或者没碰到）时关卡不会自己结束: 飞完计划的角度再多飞一圈就停。
+            // 按外侧的角速度（较慢）估算，速度等级只会上升
+            onLastTrack = true;
+            const qreal slowestOmega = state.linearSpeed / sideRadius(m_radii[lastTrack], true);
+            stopTime = qMin(stopTime, state.time + (m_arcs[lastTrack] + 2.0 * M_PI) / slowestOmega);
+        }
+        const qreal tickEnd = state.time + SIM_FIXED_STEP_SECONDS;
+        // 离步长终点太近的输入会被量化到下一步，留到下一步再排
+        const qreal latest = tickEnd - 2e-6;
+
+        int track = state.trackIndex;
+        qreal progress = normalizeAngle(state.rotationDirection * (state.angle - ANGLE_BOTTOM));
+        bool outer = state.orbitOffset > 0;
+        qreal time = state.time;
+
+        // 被轨道碰撞推到内侧、或者刚换轨时，按计划立即回到应在的一侧
+        if (outer != desiredOuter(track, progress)) {
+            queue(OrbitInput::SwitchOrbit, time);
+            outer = !outer;
+        }
+
+        // 本步内计划中的 J 与 K，按解析出的时刻逐个排队（速度等级在一步内几乎不变）
+        while (true) {
+            const std::vector<Toggle>& plan = m_plans[track];
+            auto next = std::upper_bound(plan.begin(), plan.end(), progress,
+                                         [](qreal p, const Toggle& toggle) { return p < toggle.progress; });
+            const bool switchNext = track < lastTrack && (next == plan.end() || next->progress >= m_arcs[track]);
+            const qreal target = switchNext ? m_arcs[track] : (next == plan.end() ? -1 : next->progress);
+            if (target < progress) break;
+
+            const qreal omega = state.linearSpeed / sideRadius(m_radii[track], outer);
+            const qreal eventTime = time + (target - progress) / omega;
+            if (eventTime >= latest) break;
+            time = eventTime;
+
+            if (switchNext) {
+                queue(OrbitInput::SwitchTrack, time);
+                ++track;
+                progress = 0;
+                outer = false;
+                if (desiredOuter(track, 0)) {
+                    queue(OrbitInput::SwitchOrbit, time);
+                    outer = true;
+                }
+            } else {
+                progress = target;
+                if (next->outer != outer) {
+                    queue(OrbitInput::SwitchOrbit, time);
+                    outer = next->outer;
+                }
+            }
+        }
+
+        sim.step(SIM_FIXED_STEP_SECONDS);
+        sim.takeEvents();
+    }
+    replay.durationMicros = OrbitReplay::toMicros(sim.state().time);
+
+    // 用录像重新模拟一遍，结果即 orbitreplaytool 会得到的结果
+    result->outcome = replay.replay(sim);
+    qDebug() << "OrbitSolver: finished with score" << result->outcome.score << "health" << result->outcome.health
+             << "completed" << result->outcome.levelCompleted << "inputs" << replay.inputs.size();
+}
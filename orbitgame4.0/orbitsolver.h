@@ -0,0 +1,73 @@
+#ifndef ORBITSOLVER_H
+#define ORBITSOLVER_H
+
+#include <vector>
+#include <QtGlobal>
+
+#include "trackdata.h"
+#include "orbitsimulation.h"
+#include "orbitreplay.h"
+
+// ==========================================================================
+// OrbitSolver: 为一个关卡计算自动游玩的输入计划。
+// 每条轨道上飞船从底部 (ANGLE_BOTTOM) 沿运动方向飞过半圈到判定点 (ANGLE_TOP)，在那里按 K。
+// 沿途把每个物品、相邻轨道在内/外侧的命中范围解析算成角度区间，按区间端点切成小段，从前往后逐段贪心地
+// 决定走内侧还是外侧（J）：先避开会受伤的一侧；两侧都安全时去拿截止位置最早的收集品（最早截止优先），
+// 都不需要时留在原来一侧少按 J。这是贪心计划，不保证拿到的收集品最多、按 J 最少。
+// 两侧都躲不开的障碍物、以及外侧会撞上相邻轨道而内侧又被障碍物挡住的地方会被标记出来——
+// 这些位置无论怎样输入都会受伤。
+// 计划最后在 OrbitSimulation 里按固定步长执行一遍，生成的 OrbitReplay 可以直接用 orbitreplaytool 校验。
+// ==========================================================================
+
+// 计划里离危险区间边界留出的角度余量（弧度），避免输入恰好落在边界上
+const qreal SOLVER_ANGLE_MARGIN = 0.01;
+// 执行计划时最多模拟的时间（秒），防止计划失效、一直到不了最后一条轨道时无限运行。
+// 到了最后一条轨道后，飞完计划的角度再多飞一圈仍没有结束就会停下，不必跑到这个上限
+const qreal SOLVER_MAX_SIM_SECONDS = 3600.0;
+
+// 每条轨道的计划摘要
+struct OrbitSolverSegment {
+    int trackIndex;
+    qreal arcRadians;                        // 在这条轨道上要飞过的角度
+    int collectibles;                        // 轨道上的收集品数
+    int reachableCollectibles;               // 飞过的角度内、至少一侧能碰到的收集品数
+    int plannedCollectibles;                 // 计划能拿到的收集品数
+    int orbitSwitches;                       // 计划的 J 次数
+    std::vector<int> unavoidableObstacles;   // 内外侧都躲不开的障碍物（关卡内的障碍物索引）
+    std::vector<int> unavoidableRings;       // 外侧会撞上、内侧又被障碍物挡住的相邻轨道索引
+};
+
+struct OrbitSolverResult {
+    std::vector<OrbitSolverSegment> segments;
+    bool endReachable;          // 最后一条轨道上能否碰到通关点
+    OrbitReplay replay;         // 计划对应的输入
+    OrbitReplayResult outcome;  // 按固定步长重新模拟 replay 的结果
+};
+
+class OrbitSolver
+{
+public:
+    OrbitSolver();
+
+    // endRadius <= 0 表示关卡没有通关点（最后一条轨道只飞半圈）
+    OrbitSolverResult solve(const TrackData& level, qreal endX, qreal endY, qreal endRadius);
+
+private:
+    // 从 progress 起（沿运动方向离开 ANGLE_BOTTOM 的角度）飞船应该在的一侧
+    struct Toggle {
+        qreal progress;
+        bool outer;
+    };
+
+    void planTrack(const TrackData& level, int trackIndex, const TrackSpatialGrid& grid, qreal linearSpeed,
+                   qreal endX, qreal endY, qreal endRadius, OrbitSolverResult* result);
+    bool desiredOuter(int trackIndex, qreal progress) const;
+    qreal progressOf(int trackIndex, qreal angle) const;
+    void execute(const TrackData& level, qreal endX, qreal endY, qreal endRadius, OrbitSolverResult* result);
+
+    std::vector<std::vector<Toggle>> m_plans; // 每条轨道按 progress 排序的内外侧计划
+    std::vector<qreal> m_arcs;                // 每条轨道要飞过的角度
+    std::vector<qreal> m_radii;
+};
+
+#endif // ORBITSOLVER_H
@@ -0,0 +1,141 @@
+// 文件: main.cpp (orbitsolvertool)
+// 用 OrbitSolver 为关卡计算每条轨道上 K/J 的时机（贪心计划，见 orbitsolver.h），输出每条轨道能拿到的收集品、
+// 必须按 J 的次数，以及无论怎样输入都会受伤的位置（两侧都躲不开的障碍物 / 外侧撞轨道而内侧被挡住）。
+// 计划会按游戏规则完整执行一遍，可以用 --replay 保存成录像，再交给 orbitreplaytool 校验。
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QLoggingCategory>
+#include <QStringList>
+#include <QTextStream>
+
+#include "trackdata.h"
+#include "orbitsimulation.h"
+#include "orbitsolver.h"
+
+namespace {
+
+QString indexList(const std::vector<int>& indices)
+{
+    QStringList parts;
+    for (int index : indices) parts << QString::number(index);
+    return parts.join(',');
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("orbitsolvertool");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Plans K/J inputs for OrbitGame levels and reports unavoidable damage.");
+    parser.addHelpOption();
+    QCommandLineOption replayOption("replay", "Write the planned run as <dir>/<level>.orr.", "dir");
+    QCommandLineOption scheduleOption("schedule", "Print every planned input with its time.");
+    QCommandLineOption quietOption("quiet", "Only print segments with unavoidable damage and the summary.");
+    QCommandLineOption verboseOption("verbose", "Keep the core's debug output.");
+    parser.addOption(replayOption);
+    parser.addOption(scheduleOption);
+    parser.addOption(quietOption);
+    parser.addOption(verboseOption);
+    parser.addPositionalArgument("levels", "Level JSON files.", "<level>...");
+    parser.process(app);
+
+    const QStringList levels = parser.positionalArguments();
+    if (levels.isEmpty()) {
+        parser.showHelp(2);
+    }
+    if (!parser.isSet(verboseOption)) {
+        QLoggingCategory::setFilterRules("*.debug=false");
+    }
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    int failures = 0;
+    QElapsedTimer timer;
+    for (const QString& path : levels) {
+        const QString name = QFileInfo(path).completeBaseName();
+        TrackData level;
+        if (!level.loadLevelFromFile(path)) {
+            err << "Failed to load level " << path << Qt::endl;
+            ++failures;
+            continue;
+        }
+
+        timer.start();
+        OrbitSolver solver;
+        const OrbitSolverResult result = solver.solve(level, level.endTrigger.x, level.endTrigger.y, level.endTrigger.radius);
+        const qreal elapsedMs = timer.nsecsElapsed() / 1e6;
+
+        out << "== " << name << " (" << level.segments.size() << " tracks)" << Qt::endl;
+        out << "track\tarc\tcollect\tJ\tunavoidable" << Qt::endl;
+        int planned = 0;
+        int reachable = 0;
+        int total = 0;
+        int switches = 0;
+        int flagged = 0;
+        for (const OrbitSolverSegment& segment : result.segments) {
+            planned += segment.plannedCollectibles;
+            reachable += segment.reachableCollectibles;
+            total += segment.collectibles;
+            switches += segment.orbitSwitches;
+
+            QString flags;
+            if (!segment.unavoidableRings.empty()) {
+                flags += "rings " + indexList(segment.unavoidableRings) + " ";
+            }
+            if (!segment.unavoidableObstacles.empty()) {
+                flags += "obstacles " + indexList(segment.unavoidableObstacles);
+            }
+            if (!flags.isEmpty()) ++flagged;
+            if (parser.isSet(quietOption) && flags.isEmpty()) continue;
+
+            out << segment.trackIndex
+                << "\t" << QString::number(qRadiansToDegrees(segment.arcRadians), 'f', 1)
+                << "\t" << segment.plannedCollectibles << "/" << segment.reachableCollectibles << "/" << segment.collectibles
+                << "\t" << segment.orbitSwitches
+                << "\t" << (flags.isEmpty() ? QString("-") : flags.trimmed()) << Qt::endl;
+        }
+
+        if (parser.isSet(scheduleOption)) {
+            for (const OrbitReplayInput& input : result.replay.inputs) {
+                out << QString::number(OrbitReplay::toSeconds(input.timeMicros), 'f', 6) << "\t"
+                    << (input.input == OrbitInput::SwitchTrack ? "K" : "J") << Qt::endl;
+            }
+        }
+
+        const OrbitReplayResult& outcome = result.outcome;
+        out << "collectibles " << planned << "/" << reachable << "/" << total
+            << "\tJ=" << switches
+            << "\tunavoidable-segments=" << flagged
+            << "\t" << (outcome.levelCompleted ? "completed" : (outcome.gameOver ? "game-over" : "unfinished"))
+            << "\tscore=" << outcome.score
+            << "\thealth=" << outcome.health
+            << "\ttime=" << QString::number(outcome.time, 'f', 3) << "s"
+            << "\t(" << QString::number(elapsedMs, 'f', 2) << " ms)" << Qt::endl;
+        if (!result.endReachable) {
+            out << "WARNING: the end trigger cannot be reached from the last track" << Qt::endl;
+        }
+        if (!outcome.levelCompleted) {
+            ++failures;
+        }
+
+        if (parser.isSet(replayOption)) {
+            const QString replayPath = QDir(parser.value(replayOption)).filePath(name + ".orr");
+            QFile file(replayPath);
+            if (!QDir().mkpath(parser.value(replayOption)) || !file.open(QIODevice::WriteOnly)) {
+                err << "Cannot write replay " << replayPath << ": " << file.errorString() << Qt::endl;
+                ++failures;
+                continue;
+            }
+            file.write(result.replay.encode());
+        }
+    }
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,13 @@
+# 无界面关卡求解工具，只依赖 QtCore：
+#   orbitsolvertool [--replay 输出.orr] [--schedule] <关卡.json>...
+QT = core
+
+CONFIG += c++17 console cmdline
+CONFIG -= app_bundle
+
+TARGET = orbitsolvertool
+
+SOURCES += \
+    main.cpp
+
+include(../orbitcore.pri)
@@ -1,11 +1,13 @@
 // 文件: startscene.cpp
 #include "startscene.h"
 #include "customclickableitem.h"
+#include "assetregistry.h"
 #include <QPixmap>
 #include <QGraphicsView>
 #include <QDebug>
 #include <QApplication>
-#include <QFontDatabase> // <--- 添加 QFontDatabase 头文件
+#include <QKeyEvent>
+#include <QTransform>
 
 // --- 定义期望的按钮尺寸 ---
 const qreal DESIRED_BUTTON_WIDTH = 1000.0;
@@ -17,6 +19,10 @@ const qreal TOP_MARGIN_TITLE_PIXELS = 300.0;
 const qreal TITLE_TO_START_BUTTON_SPACING_PIXELS = 250.0;
 const qreal BUTTON_SPACING_PIXELS = -150.0;
 
+// --- 背景 ---
+const char* const START_BACKGROUND_PATH = ":/images/game_background.png";
+const int MAX_CACHED_BACKGROUND_SIZES = 3; // 窗口/最大化/全屏之间来回切换时不用重新缩放
+
 // --- 备用Y位置因子 ---
 const qreal FALLBACK_Y_FACTOR_START_BUTTON = 0.40;
 const qreal FALLBACK_Y_FACTOR_TUTORIAL_BUTTON_NO_TITLE_NO_START = 0.60;
@@ -25,6 +31,11 @@ const qreal FALLBACK_Y_FACTOR_TUTORIAL_BUTTON_NO_TITLE_NO_START = 0.60;
 const qreal TEXT_TO_CLOSE_BUTTON_SPACING = 20.0;
 const qreal CLOSE_BUTTON_BOTTOM_MARGIN = 20.0;
 
+static QSize desiredButtonSize()
+{
+    return QSize(static_cast<int>(DESIRED_BUTTON_WIDTH), static_cast<int>(DESIRED_BUTTON_HEIGHT));
+}
+
 
 StartScene::StartScene(QObject *parent) : QGraphicsScene(parent),
     m_backgroundItem(nullptr),
@@ -39,6 +50,14 @@ StartScene::StartScene(QObject *parent) : QGraphicsScene(parent),
     m_englishFontFamily("Arial")   // <--- 初始化为默认英文字体
 {
     loadCustomFonts(); // <--- 在构造函数中调用加载字体的方法
+
+    // 渲染比例变了（窗口移到另一块屏幕等），按当前视图大小重新布局，换上重新光栅化的矢量图
+    connect(AssetRegistry::instance(), &AssetRegistry::renderScaleChanged, this, [this]() {
+        if (!views().isEmpty() && views().first()) {
+            m_layoutSize = QSize(); // 尺寸没变也要重新布局，换上新的矢量图
+            setupUi(views().first()->size());
+        }
+    });
 }
 
 StartScene::~StartScene()
@@ -47,57 +66,40 @@ StartScene::~StartScene()
 
 void StartScene::loadCustomFonts()
 {
-    // 假设您的自定义字体文件在资源路径 :/fonts/ 下
-    // 请将 "YourChineseFontFile.ttf" 和 "YourEnglishFontFile.ttf" 替换为您的实际文件名
-    int chineseFontId = QFontDatabase::addApplicationFont(":/fonts/MyChineseFont.ttf"); // 与 GameScene 保持一致
-    if (chineseFontId != -1) {
-        QStringList fontFamilies = QFontDatabase::applicationFontFamilies(chineseFontId);
-        if (!fontFamilies.isEmpty()) {
-            m_chineseFontFamily = fontFamilies.at(0);
-            qDebug() << "StartScene: Custom Chinese font loaded:" << m_chineseFontFamily;
-        } else {
-            qWarning() << "StartScene: Failed to retrieve font family name for Chinese font. Using default:" << m_chineseFontFamily;
-        }
-    } else {
-        qWarning() << "StartScene: Failed to load custom Chinese font from ':/fonts/MyChineseFont.ttf'. Using default:" << m_chineseFontFamily;
-    }
-
-    int englishFontId = QFontDatabase::addApplicationFont(":/fonts/MyEnglishFont.ttf"); // 与 GameScene 保持一致
-    if (englishFontId != -1) {
-        QStringList fontFamilies = QFontDatabase::applicationFontFamilies(englishFontId);
-        if (!fontFamilies.isEmpty()) {
-            m_englishFontFamily = fontFamilies.at(0);
-            qDebug() << "StartScene: Custom English font loaded:" << m_englishFontFamily;
-        } else {
-            qWarning() << "StartScene: Failed to retrieve font family name for English font. Using default:" << m_englishFontFamily;
-        }
-    } else {
-        qWarning() << "StartScene: Failed to load custom English font from ':/fonts/MyEnglishFont.ttf'. Using default:" << m_englishFontFamily;
-    }
+    // 与 GameScene 用同一份注册表: 字体文件整个程序只注册一次
+    m_chineseFontFamily = AssetRegistry::instance()->fontFamily(CHINESE_FONT_PATH, m_chineseFontFamily);
+    m_englishFontFamily = AssetRegistry::instance()->fontFamily(ENGLISH_FONT_PATH, m_englishFontFamily);
+    qDebug() << "StartScene: Using fonts" << m_chineseFontFamily << m_englishFontFamily;
 }
 
-void StartScene::setupUi(const QSize& viewSize)
+void StartScene::setupUi(const QSize& viewSize, bool interactive)
 {
+    if (!interactive && viewSize == m_layoutSize) {
+        // 图片和位置都没变（例如从游戏返回开始界面），只需要恢复初始状态
+        if (m_isTutorialVisible) showTutorialContent(false, viewSize);
+        return;
+    }
+    if (interactive && (m_titleItem || m_startButton || m_tutorialButton)) {
+        // 拖动中每个 resize 事件都会来：图片不变，只挪位置，也不打日志；停下来后再做一次完整布局
+        updateBackground(viewSize, true);
+        setSceneRect(0, 0, viewSize.width(), viewSize.height());
+        positionItems(viewSize, false);
+        if (m_isTutorialVisible) showTutorialContent(false, viewSize);
+        m_layoutSize = QSize();
+        return;
+    }
     qDebug() << "StartScene: setupUi called with viewSize:" << viewSize;
     qDebug() << "StartScene: Using fixed pixel spacing. TITLE_TO_START_BUTTON_SPACING_PIXELS =" << TITLE_TO_START_BUTTON_SPACING_PIXELS
              << "BUTTON_SPACING_PIXELS =" << BUTTON_SPACING_PIXELS;
 
     // 1. 背景设置
-    const QString bgPath = ":/images/game_background.png";
-    QPixmap bgPixmap(bgPath);
-    if (bgPixmap.isNull()) {
-        qWarning() << "StartScene: Failed to load background image '" << bgPath << "'. Using fallback darkGray brush.";
-        setBackgroundBrush(Qt::darkGray);
-    } else {
-        setBackgroundBrush(QBrush(bgPixmap.scaled(viewSize, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation)));
-        qDebug() << "StartScene: Background image '" << bgPath << "' loaded and set.";
-    }
+    updateBackground(viewSize, interactive);
     setSceneRect(0, 0, viewSize.width(), viewSize.height());
 
 
     // 2. 游戏标题
     const QString titlePath = ":/images/game_title.png";
-    QPixmap titlePixmapOriginal(titlePath);
+    QPixmap titlePixmapOriginal = AssetRegistry::instance()->pixmap(titlePath);
     qDebug() << "StartScene: Attempting to load title image '" << titlePath << "'. IsNull:" << titlePixmapOriginal.isNull() << "Size:" << titlePixmapOriginal.size();
 
     if (!titlePixmapOriginal.isNull()) {
@@ -106,10 +108,7 @@ void StartScene::setupUi(const QSize& viewSize)
             addItem(m_titleItem);
         }
         m_titleItem->setPixmap(titlePixmapOriginal);
-        m_titleItem->setPos((viewSize.width() - m_titleItem->boundingRect().width()) / 2,
-                            TOP_MARGIN_TITLE_PIXELS);
         m_titleItem->setVisible(true);
-        qDebug() << "StartScene: Title item created/updated. Pos:" << m_titleItem->pos() << "Size:" << m_titleItem->boundingRect().size() << "Visible:" << m_titleItem->isVisible();
     } else {
         qWarning() << "StartScene: Failed to load title image '" << titlePath << "'. Title will not be shown.";
         if (m_titleItem) {
@@ -119,14 +118,11 @@ void StartScene::setupUi(const QSize& viewSize)
 
     // 3. 开始按钮
     const QString startButtonPath = ":/images/start_button.png";
-    QPixmap startButtonPixmapOriginal(startButtonPath);
-    qDebug() << "StartScene: Attempting to load start button image '" << startButtonPath << "'. IsNull:" << startButtonPixmapOriginal.isNull() << "Size:" << startButtonPixmapOriginal.size();
-
-    if (!startButtonPixmapOriginal.isNull()) {
-        QPixmap startButtonPixmapScaled = startButtonPixmapOriginal.scaled(
-            DESIRED_BUTTON_WIDTH, DESIRED_BUTTON_HEIGHT,
-            Qt::KeepAspectRatio, Qt::SmoothTransformation
-            );
+    // 缩放（或矢量图光栅化）的结果由 AssetRegistry 缓存，重新布局时不再重复
+    QPixmap startButtonPixmapScaled = AssetRegistry::instance()->pixmap(startButtonPath, desiredButtonSize());
+    qDebug() << "StartScene: Attempting to load start button image '" << startButtonPath << "'. IsNull:" << startButtonPixmapScaled.isNull() << "Size:" << startButtonPixmapScaled.size();
+
+    if (!startButtonPixmapScaled.isNull()) {
         if (!m_startButton) {
             m_startButton = new CustomClickableItem(startButtonPixmapScaled);
             addItem(m_startButton);
@@ -134,18 +130,7 @@ void StartScene::setupUi(const QSize& viewSize)
         } else {
             m_startButton->setPixmap(startButtonPixmapScaled);
         }
-
-        qreal startButtonX = (viewSize.width() - m_startButton->boundingRect().width()) / 2;
-        qreal startButtonY;
-        if (m_titleItem && m_titleItem->isVisible() && !m_titleItem->pixmap().isNull()) {
-            startButtonY = m_titleItem->y() + m_titleItem->boundingRect().height() + TITLE_TO_START_BUTTON_SPACING_PIXELS;
-        } else {
-            startButtonY = viewSize.height() * FALLBACK_Y_FACTOR_START_BUTTON;
-            qWarning() << "StartScene: Title item is not available for start button positioning, using fallback Y for start button.";
-        }
-        m_startButton->setPos(startButtonX, startButtonY);
         m_startButton->setVisible(true);
-        qDebug() << "StartScene: Start button created/updated. Pos:" << m_startButton->pos() << "Size:" << m_startButton->boundingRect().size() << "Visible:" << m_startButton->isVisible() << "Enabled:" << m_startButton->isEnabled();
     } else {
         qWarning() << "StartScene: Failed to load start button image '" << startButtonPath << "'. Start button will not be shown.";
         if (m_startButton) {
@@ -155,14 +140,10 @@ void StartScene::setupUi(const QSize& viewSize)
 
     // 4. 教程按钮
     const QString tutorialButtonPath = ":/images/tutorial_button.png";
-    QPixmap tutorialButtonPixmapOriginal(tutorialButtonPath);
-    qDebug() << "StartScene: Attempting to load tutorial button image '" << tutorialButtonPath << "'. IsNull:" << tutorialButtonPixmapOriginal.isNull() << "Size:" << tutorialButtonPixmapOriginal.size();
-
-    if (!tutorialButtonPixmapOriginal.isNull()) {
-        QPixmap tutorialButtonPixmapScaled = tutorialButtonPixmapOriginal.scaled(
-            DESIRED_BUTTON_WIDTH, DESIRED_BUTTON_HEIGHT,
-            Qt::KeepAspectRatio, Qt::SmoothTransformation
-            );
+    QPixmap tutorialButtonPixmapScaled = AssetRegistry::instance()->pixmap(tutorialButtonPath, desiredButtonSize());
+    qDebug() << "StartScene: Attempting to load tutorial button image '" << tutorialButtonPath << "'. IsNull:" << tutorialButtonPixmapScaled.isNull() << "Size:" << tutorialButtonPixmapScaled.size();
+
+    if (!tutorialButtonPixmapScaled.isNull()) {
         if (!m_tutorialButton) {
             m_tutorialButton = new CustomClickableItem(tutorialButtonPixmapScaled);
             addItem(m_tutorialButton);
@@ -183,31 +164,99 @@ void StartScene::setupUi(const QSize& viewSize)
         } else {
             m_tutorialButton->setPixmap(tutorialButtonPixmapScaled);
         }
+        m_tutorialButton->setVisible(true);
+    } else {
+        qWarning() << "StartScene: Failed to load tutorial button image '" << tutorialButtonPath << "'. Tutorial button will not be shown.";
+        if (m_tutorialButton) {
+            m_tutorialButton->setVisible(false);
+        }
+    }
 
+    positionItems(viewSize, true);
+    if (m_titleItem && m_titleItem->isVisible()) {
+        qDebug() << "StartScene: Title item created/updated. Pos:" << m_titleItem->pos() << "Size:" << m_titleItem->boundingRect().size() << "Visible:" << m_titleItem->isVisible();
+    }
+    if (m_startButton && m_startButton->isVisible()) {
+        qDebug() << "StartScene: Start button created/updated. Pos:" << m_startButton->pos() << "Size:" << m_startButton->boundingRect().size() << "Visible:" << m_startButton->isVisible() << "Enabled:" << m_startButton->isEnabled();
+    }
+    if (m_tutorialButton && m_tutorialButton->isVisible()) {
+        qDebug() << "StartScene: Tutorial button created/updated. Pos:" << m_tutorialButton->pos() << "Size:" << m_tutorialButton->boundingRect().size() << "Visible:" << m_tutorialButton->isVisible() << "Enabled:" << m_tutorialButton->isEnabled();
+    }
+
+    showTutorialContent(false, viewSize);
+    m_layoutSize = interactive ? QSize() : viewSize; // 拖动中的布局背景不精确，停下来后还要再来一次
+    qDebug() << "StartScene: setupUi completed. Initial tutorial visibility:" << m_isTutorialVisible;
+}
+
+void StartScene::positionItems(const QSize& viewSize, bool verbose)
+{
+    if (m_titleItem && m_titleItem->isVisible()) {
+        m_titleItem->setPos((viewSize.width() - m_titleItem->boundingRect().width()) / 2,
+                            TOP_MARGIN_TITLE_PIXELS);
+    }
+
+    if (m_startButton && m_startButton->isVisible()) {
+        qreal startButtonX = (viewSize.width() - m_startButton->boundingRect().width()) / 2;
+        qreal startButtonY;
+        if (m_titleItem && m_titleItem->isVisible() && !m_titleItem->pixmap().isNull()) {
+            startButtonY = m_titleItem->y() + m_titleItem->boundingRect().height() + TITLE_TO_START_BUTTON_SPACING_PIXELS;
+        } else {
+            startButtonY = viewSize.height() * FALLBACK_Y_FACTOR_START_BUTTON;
+            if (verbose) qWarning() << "StartScene: Title item is not available for start button positioning, using fallback Y for start button.";
+        }
+        m_startButton->setPos(startButtonX, startButtonY);
+    }
+
+    if (m_tutorialButton && m_tutorialButton->isVisible()) {
         qreal tutorialButtonX = (viewSize.width() - m_tutorialButton->boundingRect().width()) / 2;
         qreal tutorialButtonY;
         if (m_startButton && m_startButton->isVisible() && !m_startButton->pixmap().isNull()) {
             tutorialButtonY = m_startButton->y() + m_startButton->boundingRect().height() + BUTTON_SPACING_PIXELS;
         } else if (m_titleItem && m_titleItem->isVisible() && !m_titleItem->pixmap().isNull()) {
             tutorialButtonY = m_titleItem->y() + m_titleItem->boundingRect().height() + TITLE_TO_START_BUTTON_SPACING_PIXELS + BUTTON_SPACING_PIXELS + 10;
-            qWarning() << "StartScene: Start button is not available for tutorial button positioning, using title item as fallback for tutorial button.";
+            if (verbose) qWarning() << "StartScene: Start button is not available for tutorial button positioning, using title item as fallback for tutorial button.";
         }
         else {
             tutorialButtonY = viewSize.height() * FALLBACK_Y_FACTOR_TUTORIAL_BUTTON_NO_TITLE_NO_START;
-            qWarning() << "StartScene: Neither title nor start button is available for tutorial button positioning, using fallback Y for tutorial button.";
+            if (verbose) qWarning() << "StartScene: Neither title nor start button is available for tutorial button positioning, using fallback Y for tutorial button.";
         }
         m_tutorialButton->setPos(tutorialButtonX, tutorialButtonY);
-        m_tutorialButton->setVisible(true);
-        qDebug() << "StartScene: Tutorial button created/updated. Pos:" << m_tutorialButton->pos() << "Size:" << m_tutorialButton->boundingRect().size() << "Visible:" << m_tutorialButton->isVisible() << "Enabled:" << m_tutorialButton->isEnabled();
-    } else {
-        qWarning() << "StartScene: Failed to load tutorial button image '" << tutorialButtonPath << "'. Tutorial button will not be shown.";
-        if (m_tutorialButton) {
-            m_tutorialButton->setVisible(false);
+    }
+}
+
+void StartScene::updateBackground(const QSize& viewSize, bool interactive)
+{
+    AssetRegistry* registry = AssetRegistry::instance();
+    if (interactive && !registry->hasPixmap(START_BACKGROUND_PATH, viewSize, Qt::KeepAspectRatioByExpanding)) {
+        // 拖动中：把现有背景按比例拉伸到铺满视图，由 painter 在绘制时变换，不解码也不平滑缩放
+        if (!m_backgroundPixmap.isNull()) {
+            const QSizeF covered = QSizeF(m_backgroundPixmap.size()).scaled(QSizeF(viewSize), Qt::KeepAspectRatioByExpanding);
+            QBrush brush(m_backgroundPixmap);
+            brush.setTransform(QTransform::fromScale(covered.width() / m_backgroundPixmap.width(),
+                                                     covered.height() / m_backgroundPixmap.height()));
+            setBackgroundBrush(brush);
         }
+        return;
     }
 
-    showTutorialContent(false, viewSize);
-    qDebug() << "StartScene: setupUi completed. Initial tutorial visibility:" << m_isTutorialVisible;
+    // 直接请求这个尺寸: AssetRegistry 解码原图、缩放后只缓存缩放好的这一份。
+    // 全尺寸的原图不留在缓存里（否则它会一直占着内存），换到新的尺寸时再解码一次
+    m_backgroundPixmap = registry->pixmap(START_BACKGROUND_PATH, viewSize, Qt::KeepAspectRatioByExpanding);
+    registry->releasePixmap(START_BACKGROUND_PATH, QSize()); // 以防别处按原尺寸请求过
+    if (m_backgroundPixmap.isNull()) {
+        qWarning() << "StartScene: Failed to load background image '" << START_BACKGROUND_PATH << "'. Using fallback darkGray brush.";
+        setBackgroundBrush(Qt::darkGray);
+        return;
+    }
+    setBackgroundBrush(QBrush(m_backgroundPixmap));
+
+    // 只保留最近用过的几个尺寸，拖动窗口停在过的其他尺寸不会一直占着内存
+    m_backgroundSizes.removeAll(viewSize);
+    m_backgroundSizes.append(viewSize);
+    while (m_backgroundSizes.size() > MAX_CACHED_BACKGROUND_SIZES) {
+        registry->releasePixmap(START_BACKGROUND_PATH, m_backgroundSizes.takeFirst(), Qt::KeepAspectRatioByExpanding);
+    }
+    if (!interactive) qDebug() << "StartScene: Background image '" << START_BACKGROUND_PATH << "' set for" << viewSize;
 }
 
 void StartScene::showTutorialContent(bool show, const QSize& viewSize) {
@@ -238,6 +287,7 @@ void StartScene::showTutorialContent(bool show, const QSize& viewSize) {
                                        "<p><span style=\"font-family: '%1';\">按 <span style=\"font-family: '%2'; font-weight: bold;\">K</span> 键切换到下一条轨道</span></p>"
                                        "<p><span style=\"font-family: '%1'; color: #FFA500;\">在他处乱按 <span style=\"font-family: '%2'; font-weight: bold;\">K</span> 会扣血哦，</span></p>"
                                        "<p><span style=\"font-family: '%1'; color: #FFA500;\">请确保飞船到达切换点再按下!</span></p>"
+                                       "<p><span style=\"font-family: '%1';\">在开始界面按 <span style=\"font-family: '%2'; font-weight: bold;\">E</span> 键进入无尽模式</span></p>"
                                        //"<br><p><span style=\"font-family: '%1';\">点击下方关闭按钮返回</span></p>"
                                        "</div>")
                                        .arg(m_chineseFontFamily) // %1 对应中文字体
@@ -248,15 +298,12 @@ void StartScene::showTutorialContent(bool show, const QSize& viewSize) {
             m_tutorialText->setTextWidth(m_tutorialPanel->rect().width() * 0.9);
 
             const QString closeButtonPath = ":/images/close_button.png";
-            QPixmap closeButtonPixmapOriginal(closeButtonPath);
-            qDebug() << "StartScene: Attempting to load close button image '" << closeButtonPath << "'. IsNull:" << closeButtonPixmapOriginal.isNull() << "Size:" << closeButtonPixmapOriginal.size();
-            if(closeButtonPixmapOriginal.isNull()) {
+            const int closeButtonSize = static_cast<int>(DESIRED_CLOSE_BUTTON_SIZE);
+            QPixmap closeButtonPixmapScaled = AssetRegistry::instance()->pixmap(closeButtonPath, QSize(closeButtonSize, closeButtonSize));
+            qDebug() << "StartScene: Attempting to load close button image '" << closeButtonPath << "'. IsNull:" << closeButtonPixmapScaled.isNull() << "Size:" << closeButtonPixmapScaled.size();
+            if(closeButtonPixmapScaled.isNull()) {
                 qWarning() << "StartScene: Failed to load close button image '" << closeButtonPath << "'. Close button for tutorial will not be shown.";
             } else {
-                QPixmap closeButtonPixmapScaled = closeButtonPixmapOriginal.scaled(
-                    DESIRED_CLOSE_BUTTON_SIZE, DESIRED_CLOSE_BUTTON_SIZE,
-                    Qt::KeepAspectRatio, Qt::SmoothTransformation
-                    );
                 if (!m_tutorialCloseButton) {
                     m_tutorialCloseButton = new CustomClickableItem(closeButtonPixmapScaled, m_tutorialPanel);
                     connect(m_tutorialCloseButton, &CustomClickableItem::clicked, [this](){
@@ -319,3 +366,15 @@ void StartScene::showTutorialContent(bool show, const QSize& viewSize) {
         qDebug() << "StartScene: Main screen buttons (start/tutorial) enabled.";
     }
 }
+
+void StartScene::keyPressEvent(QKeyEvent *event)
+{
+    // 教程面板打开时不响应，与按钮被禁用一致
+    if (event->key() == Qt::Key_E && !event->isAutoRepeat() && !m_isTutorialVisible) {
+        qDebug() << "StartScene: E pressed, starting endless mode.";
+        emit endlessGameClicked();
+        event->accept();
+        return;
+    }
+    QGraphicsScene::keyPressEvent(event);
+}
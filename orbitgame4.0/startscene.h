@@ -3,11 +3,14 @@
 
 #include <QGraphicsScene>
 #include <QString> // <--- 添加 QString 头文件
+#include <QList>
+#include <QPixmap>
 
 class QGraphicsPixmapItem;
 class CustomClickableItem;
 class QGraphicsRectItem;
 class QGraphicsTextItem;
+class QKeyEvent;
 class QFontDatabase; // 前向声明或包含完整头文件，这里选择不包含以保持头文件简洁
 
 class StartScene : public QGraphicsScene
@@ -17,15 +20,25 @@ public:
     explicit StartScene(QObject *parent = nullptr);
     ~StartScene();
 
-    void setupUi(const QSize& viewSize); // 根据视图大小调整布局
+    // 根据视图大小调整布局。与上一次布局的尺寸相同时只收起教程面板，不重新布局。
+    // interactive 为 true 时（正在拖动窗口边缘）不做平滑缩放也不打日志：背景先拉伸已有的图片，
+    // 标题和按钮只重新摆放，停下来后再 setupUi(viewSize)
+    void setupUi(const QSize& viewSize, bool interactive = false);
 
 signals:
     void startGameClicked();
     void tutorialClicked();
+    void endlessGameClicked(); // 在开始界面按 E 键
+
+protected:
+    void keyPressEvent(QKeyEvent *event) override;
 
 private:
     void loadCustomFonts(); // <--- 新增：加载自定义字体的辅助方法
     void showTutorialContent(bool show, const QSize& viewSize);
+    void updateBackground(const QSize& viewSize, bool interactive);
+    // 按视图大小摆放标题和按钮（只用已经设置好的图片）。verbose 为 false 时不打日志，拖动窗口时使用
+    void positionItems(const QSize& viewSize, bool verbose);
 
     QGraphicsPixmapItem *m_backgroundItem;
     QGraphicsPixmapItem *m_titleItem;
@@ -38,6 +51,10 @@ private:
     CustomClickableItem* m_tutorialCloseButton;
     bool m_isTutorialVisible;
 
+    QSize m_layoutSize;                 // 上一次完整布局时的视图大小，无效表示需要重新布局
+    QPixmap m_backgroundPixmap;         // 当前背景（按 m_backgroundSizes.last() 缩放）
+    QList<QSize> m_backgroundSizes;     // AssetRegistry 里缓存着的背景尺寸，最近用过的在最后
+
     // 自定义字体家族名称
     QString m_chineseFontFamily; // <--- 新增：存储中文字体家族名称
     QString m_englishFontFamily; // <--- 新增：存储英文字体家族名称
@@ -0,0 +1,28 @@
+#ifndef THREADPOOLTASK_H
+#define THREADPOOLTASK_H
+
+#include <memory>
+#include <QFuture>
+#include <QPromise>
+#include <QThreadPool>
+
+// ==========================================================================
+// runInThreadPool: 在全局线程池里运行 task，返回的 QFuture 给出它的结果（AssetRegistry 在后台解码图片，
+// LevelPrefetcher 在后台预读下一关）。task 只使用按值捕获的参数，结果由调用者在主线程取走；
+// 调用者保证 task 用到的其他东西（例如 LevelPrefetcher 的 .orbl 映射）活到 future 结束。
+// 持有 future 的对象析构时会等它们结束，只是为了退出时不留下还在跑的线程。
+// ==========================================================================
+template <typename T, typename Task>
+QFuture<T> runInThreadPool(Task task)
+{
+    auto promise = std::make_shared<QPromise<T>>();
+    QFuture<T> future = promise->future();
+    promise->start();
+    QThreadPool::globalInstance()->start([promise, task]() {
+        promise->addResult(task());
+        promise->finish();
+    });
+    return future;
+}
+
+#endif // THREADPOOLTASK_H
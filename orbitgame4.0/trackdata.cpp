@@ -1 +1,470 @@
 #include "trackdata.h"
+
+#include <cstring>
+
+namespace {
+
+// 单遍流式读取关卡 JSON：直接扫描 UTF-8 字节，边读边填 TrackSegmentData，
+// 不经过 QString / QJsonDocument。字段含义与 fromJsonObject 完全一致：
+// 缺少或不是数字的字段按 0 处理，未知字段跳过，非对象的数组元素跳过。
+class LevelJsonReader
+{
+public:
+    LevelJsonReader(const char* begin, const char* end)
+        : m_begin(begin), m_pos(begin), m_end(end), m_errorPos(nullptr)
+    {
+    }
+
+    bool read(TrackData* level);
+    // "line L, column C: message"
+    QString errorString() const;
+
+private:
+    static const int MAX_DEPTH = 256; // 与 QJsonDocument 的嵌套上限同一量级，防止恶意文件把栈耗尽
+
+    bool fail(const char* message);
+    void skipWhitespace();
+    bool consume(char c);
+    bool readKey(const char** key, int* length);
+    bool readNumber(double* value);
+    bool readNumberField(double* value);
+    bool skipValue(int depth);
+    bool readSegments(std::vector<TrackSegmentData>* segments);
+    bool readSegment(TrackSegmentData* segment);
+    bool readScenery(std::vector<SceneryData>* scenery);
+    bool readSceneryItem(SceneryData* item);
+    bool readEndTrigger(EndTriggerData* endTrigger);
+    bool readPath(QString* path);
+    bool readItem(double* angleDegrees, double* radialOffset);
+    template <typename Item>
+    bool readItems(std::vector<Item>* scratch, std::vector<Item>* out);
+
+    static bool keyIs(const char* key, int length, const char* name)
+    {
+        return static_cast<int>(std::strlen(name)) == length && std::memcmp(key, name, length) == 0;
+    }
+
+    const char* m_begin;
+    const char* m_pos;
+    const char* m_end;
+    const char* m_errorPos;
+    const char* m_errorMessage = nullptr;
+    // 每条轨道的物品先读进可复用的缓冲，再一次性按准确大小拷进轨道，避免逐个 push_back 扩容
+    std::vector<CollectibleData> m_collectibleScratch;
+    std::vector<ObstacleData> m_obstacleScratch;
+};
+
+bool LevelJsonReader::fail(const char* message)
+{
+    if (!m_errorPos) {
+        m_errorPos = m_pos;
+        m_errorMessage = message;
+    }
+    return false;
+}
+
+QString LevelJsonReader::errorString() const
+{
+    if (!m_errorPos) return QString();
+    int line = 1;
+    int column = 1;
+    for (const char* p = m_begin; p < m_errorPos; ++p) {
+        if (*p == '\n') {
+            ++line;
+            column = 1;
+        } else if ((static_cast<unsigned char>(*p) & 0xC0) != 0x80) { // 按字符而不是 UTF-8 字节计列
+            ++column;
+        }
+    }
+    return QString("line %1, column %2: %3").arg(line).arg(column).arg(QString::fromUtf8(m_errorMessage));
+}
+
+void LevelJsonReader::skipWhitespace()
+{
+    while (m_pos < m_end && (*m_pos == ' ' || *m_pos == '\n' || *m_pos == '\r' || *m_pos == '\t')) ++m_pos;
+}
+
+bool LevelJsonReader::consume(char c)
+{
+    skipWhitespace();
+    if (m_pos < m_end && *m_pos == c) {
+        ++m_pos;
+        return true;
+    }
+    return false;
+}
+
+// 读取一个字符串，返回引号之间的原始字节（转义不展开；关卡里用到的键都不含转义）
+bool LevelJsonReader::readKey(const char** key, int* length)
+{
+    skipWhitespace();
+    if (m_pos >= m_end || *m_pos != '"') return fail("expected a string");
+    const char* start = ++m_pos;
+    while (m_pos < m_end && *m_pos != '"') {
+        const unsigned char c = static_cast<unsigned char>(*m_pos);
+        if (c < 0x20) return fail("control character in string");
+        if (c == '\\') {
+            if (++m_pos >= m_end) break;
+            if (!std::strchr("\"\\/bfnrtu", *m_pos)) return fail("invalid escape sequence");
+        }
+        ++m_pos;
+    }
+    if (m_pos >= m_end) return fail("unterminated string");
+    *key = start;
+    *length = static_cast<int>(m_pos - start);
+    ++m_pos; // 结尾的引号
+    return true;
+}
+
+bool LevelJsonReader::readNumber(double* value)
+{
+    skipWhitespace();
+    const char* start = m_pos;
+    const char* p = m_pos;
+    auto digits = [&p, this]() {
+        const char* first = p;
+        while (p < m_end && *p >= '0' && *p <= '9') ++p;
+        return p > first;
+    };
+    if (p < m_end && *p == '-') ++p;
+    if (p < m_end && *p == '0') {
+        ++p;
+    } else if (!digits()) {
+        return fail("invalid number");
+    }
+    if (p < m_end && *p == '.') {
+        ++p;
+        if (!digits()) return fail("invalid number");
+    }
+    if (p < m_end && (*p == 'e' || *p == 'E')) {
+        ++p;
+        if (p < m_end && (*p == '+' || *p == '-')) ++p;
+        if (!digits()) return fail("invalid number");
+    }
+    // fromRawData 不拷贝；QByteArray::toDouble 与区域设置无关
+    bool ok = false;
+    *value = QByteArray::fromRawData(start, static_cast<int>(p - start)).toDouble(&ok);
+    if (!ok) return fail("number out of range");
+    m_pos = p;
+    return true;
+}
+
+// 数字字段：不是数字时与 QJsonValue::toDouble() 一样当作 0
+bool LevelJsonReader::readNumberField(double* value)
+{
+    skipWhitespace();
+    if (m_pos < m_end && (*m_pos == '-' || (*m_pos >= '0' && *m_pos <= '9'))) return readNumber(value);
+    *value = 0;
+    return skipValue(1);
+}
+
+bool LevelJsonReader::skipValue(int depth)
+{
+    if (depth > MAX_DEPTH) return fail("nesting too deep");
+    skipWhitespace();
+    if (m_pos >= m_end) return fail("unexpected end of data");
+
+    const char c = *m_pos;
+    if (c == '{' || c == '[') {
+        const char close = (c == '{') ? '}' : ']';
+        ++m_pos;
+        if (consume(close)) return true;
+        do {
+            if (c == '{') {
+                const char* key;
+                int length;
+                if (!readKey(&key, &length)) return false;
+                if (!consume(':')) return fail("expected ':'");
+            }
+            if (!skipValue(depth + 1)) return false;
+        } while (consume(','));
+        if (!consume(close)) return fail(c == '{' ? "expected ',' or '}'" : "expected ',' or ']'");
+        return true;
+    }
+    if (c == '"') {
+        const char* key;
+        int length;
+        return readKey(&key, &length);
+    }
+    if (c == '-' || (c >= '0' && c <= '9')) {
+        double ignored;
+        return readNumber(&ignored);
+    }
+    for (const char* literal : {"true", "false", "null"}) {
+        const size_t length = std::strlen(literal);
+        if (static_cast<size_t>(m_end - m_pos) >= length && std::memcmp(m_pos, literal, length) == 0) {
+            m_pos += length;
+            return true;
+        }
+    }
+    return fail("unexpected character");
+}
+
+bool LevelJsonReader::readItem(double* angleDegrees, double* radialOffset)
+{
+    *angleDegrees = 0;
+    *radialOffset = 0; // 没有 radialOffset 时默认在轨道线上
+    ++m_pos; // '{'
+    if (consume('}')) return true;
+    do {
+        const char* key;
+        int length;
+        if (!readKey(&key, &length)) return false;
+        if (!consume(':')) return fail("expected ':'");
+        if (keyIs(key, length, "angleDegrees")) {
+            if (!readNumberField(angleDegrees)) return false;
+        } else if (keyIs(key, length, "radialOffset")) {
+            if (!readNumberField(radialOffset)) return false;
+        } else if (!skipValue(3)) {
+            return false;
+        }
+    } while (consume(','));
+    if (!consume('}')) return fail("expected ',' or '}'");
+    return true;
+}
+
+template <typename Item>
+bool LevelJsonReader::readItems(std::vector<Item>* scratch, std::vector<Item>* out)
+{
+    skipWhitespace();
+    if (m_pos >= m_end || *m_pos != '[') {
+        // 与 fromJsonObject 相同：不是数组就当作没有物品
+        out->clear();
+        return skipValue(2);
+    }
+    ++m_pos;
+    scratch->clear();
+    if (!consume(']')) {
+        do {
+            skipWhitespace();
+            if (m_pos < m_end && *m_pos == '{') {
+                Item item;
+                if (!readItem(&item.angleDegrees, &item.radialOffset)) return false;
+                scratch->push_back(item);
+            } else if (!skipValue(3)) {
+                return false;
+            }
+        } while (consume(','));
+        if (!consume(']')) return fail("expected ',' or ']'");
+    }
+    out->assign(scratch->begin(), scratch->end());
+    return true;
+}
+
+bool LevelJsonReader::readSegment(TrackSegmentData* segment)
+{
+    segment->centerX = 0;
+    segment->centerY = 0;
+    segment->radius = 0;
+    segment->tangentAngleDegrees = 0;
+    ++m_pos; // '{'
+    if (consume('}')) return true;
+    do {
+        const char* key;
+        int length;
+        if (!readKey(&key, &length)) return false;
+        if (!consume(':')) return fail("expected ':'");
+        if (keyIs(key, length, "centerX")) {
+            if (!readNumberField(&segment->centerX)) return false;
+        } else if (keyIs(key, length, "centerY")) {
+            if (!readNumberField(&segment->centerY)) return false;
+        } else if (keyIs(key, length, "radius")) {
+            if (!readNumberField(&segment->radius)) return false;
+        } else if (keyIs(key, length, "tangentAngleDegrees")) {
+            if (!readNumberField(&segment->tangentAngleDegrees)) return false;
+        } else if (keyIs(key, length, "collectibles")) {
+            if (!readItems(&m_collectibleScratch, &segment->collectibles)) return false;
+        } else if (keyIs(key, length, "obstacles")) {
+            if (!readItems(&m_obstacleScratch, &segment->obstacles)) return false;
+        } else if (!skipValue(2)) {
+            return false;
+        }
+    } while (consume(','));
+    if (!consume('}')) return fail("expected ',' or '}'");
+    return true;
+}
+
+// 轨道数组，调用时 m_pos 指向 '['
+bool LevelJsonReader::readSegments(std::vector<TrackSegmentData>* segments)
+{
+    ++m_pos; // '['
+    // 按文件大小预留轨道表（压缩后的 JSON 每条轨道也至少有上百字节），避免读大关卡时反复扩容
+    segments->reserve(static_cast<size_t>(m_end - m_begin) / 128 + 1);
+    if (!consume(']')) {
+        do {
+            skipWhitespace();
+            if (m_pos < m_end && *m_pos == '{') {
+                segments->emplace_back();
+                if (!readSegment(&segments->back())) return false;
+            } else {
+                qWarning() << "Encountered non-object value in segments array. Skipping.";
+                if (!skipValue(1)) return false;
+            }
+        } while (consume(','));
+        if (!consume(']')) return fail("expected ',' or ']'");
+    }
+    return true;
+}
+
+// 图片路径只按原样取出，不支持转义（资源路径里用不到）
+bool LevelJsonReader::readPath(QString* path)
+{
+    skipWhitespace();
+    const char* start = m_pos;
+    const char* key;
+    int length;
+    if (!readKey(&key, &length)) return false;
+    if (std::memchr(key, '\\', length)) {
+        m_pos = start;
+        return fail("escape sequences are not supported in image paths");
+    }
+    *path = QString::fromUtf8(key, length);
+    return true;
+}
+
+bool LevelJsonReader::readSceneryItem(SceneryData* item)
+{
+    item->x = 0;
+    item->y = 0;
+    item->width = 0;
+    item->height = 0;
+    item->z = DEFAULT_SCENERY_Z;
+    ++m_pos; // '{'
+    if (consume('}')) return true;
+    do {
+        const char* key;
+        int length;
+        if (!readKey(&key, &length)) return false;
+        if (!consume(':')) return fail("expected ':'");
+        if (keyIs(key, length, "image")) {
+            if (!readPath(&item->image)) return false;
+        } else if (keyIs(key, length, "x")) {
+            if (!readNumberField(&item->x)) return false;
+        } else if (keyIs(key, length, "y")) {
+            if (!readNumberField(&item->y)) return false;
+        } else if (keyIs(key, length, "width")) {
+            if (!readNumberField(&item->width)) return false;
+        } else if (keyIs(key, length, "height")) {
+            if (!readNumberField(&item->height)) return false;
+        } else if (keyIs(key, length, "z")) {
+            if (!readNumberField(&item->z)) return false;
+        } else if (!skipValue(3)) {
+            return false;
+        }
+    } while (consume(','));
+    if (!consume('}')) return fail("expected ',' or '}'");
+    return true;
+}
+
+bool LevelJsonReader::readScenery(std::vector<SceneryData>* scenery)
+{
+    skipWhitespace();
+    if (m_pos >= m_end || *m_pos != '[') return skipValue(1); // 不是数组就当作没有装饰
+    ++m_pos;
+    if (consume(']')) return true;
+    do {
+        skipWhitespace();
+        if (m_pos < m_end && *m_pos == '{') {
+            SceneryData item;
+            if (!readSceneryItem(&item)) return false;
+            if (item.image.isEmpty() || item.width <= 0 || item.height <= 0) {
+                qWarning() << "Skipping scenery without an image or a size at" << item.x << item.y;
+            } else {
+                scenery->push_back(item);
+            }
+        } else if (!skipValue(2)) {
+            return false;
+        }
+    } while (consume(','));
+    if (!consume(']')) return fail("expected ',' or ']'");
+    return true;
+}
+
+bool LevelJsonReader::readEndTrigger(EndTriggerData* endTrigger)
+{
+    skipWhitespace();
+    if (m_pos >= m_end || *m_pos != '{') return skipValue(1); // null 等: 没有通关点
+    endTrigger->radius = DEFAULT_END_TRIGGER_RADIUS;
+    ++m_pos;
+    if (consume('}')) return true;
+    do {
+        const char* key;
+        int length;
+        if (!readKey(&key, &length)) return false;
+        if (!consume(':')) return fail("expected ':'");
+        if (keyIs(key, length, "x")) {
+            if (!readNumberField(&endTrigger->x)) return false;
+        } else if (keyIs(key, length, "y")) {
+            if (!readNumberField(&endTrigger->y)) return false;
+        } else if (keyIs(key, length, "radius")) {
+            if (!readNumberField(&endTrigger->radius)) return false;
+        } else if (!skipValue(2)) {
+            return false;
+        }
+    } while (consume(','));
+    if (!consume('}')) return fail("expected ',' or '}'");
+    return true;
+}
+
+bool LevelJsonReader::read(TrackData* level)
+{
+    // 跳过 UTF-8 BOM
+    if (m_end - m_pos >= 3 && std::memcmp(m_pos, "\xEF\xBB\xBF", 3) == 0) m_pos += 3;
+    skipWhitespace();
+    if (m_pos < m_end && *m_pos == '[') {
+        if (!readSegments(&level->segments)) return false; // 旧格式: 只有轨道
+    } else if (m_pos < m_end && *m_pos == '{') {
+        ++m_pos;
+        if (!consume('}')) {
+            do {
+                const char* key;
+                int length;
+                if (!readKey(&key, &length)) return false;
+                if (!consume(':')) return fail("expected ':'");
+                skipWhitespace();
+                if (keyIs(key, length, "segments")) {
+                    if (m_pos >= m_end || *m_pos != '[') return fail("\"segments\" must be an array of track segments");
+                    if (!readSegments(&level->segments)) return false;
+                } else if (keyIs(key, length, "scenery")) {
+                    if (!readScenery(&level->scenery)) return false;
+                } else if (keyIs(key, length, "endTrigger")) {
+                    if (!readEndTrigger(&level->endTrigger)) return false;
+                } else if (!skipValue(1)) {
+                    return false;
+                }
+            } while (consume(','));
+            if (!consume('}')) return fail("expected ',' or '}'");
+        }
+    } else {
+        return fail("level must be a JSON array of track segments or an object with \"segments\"");
+    }
+    skipWhitespace();
+    if (m_pos != m_end) return fail("unexpected data after the level");
+    return true;
+}
+
+} // namespace
+
+bool TrackData::loadLevelFromUtf8(const QByteArray& json, QString* errorString)
+{
+    segments.clear(); // 清除旧数据
+    scenery.clear();
+    endTrigger = EndTriggerData();
+    LevelJsonReader reader(json.constData(), json.constData() + json.size());
+    if (!reader.read(this)) {
+        const QString error = reader.errorString();
+        qWarning() << "Failed to parse level JSON at" << error;
+        if (errorString) *errorString = error;
+        segments.clear();
+        scenery.clear();
+        endTrigger = EndTriggerData();
+        return false;
+    }
+    if (segments.empty()) {
+        qWarning() << "JSON array for level segments is empty. Loading as an empty level.";
+        // 允许空关卡, 如果返回false则空关卡加载失败
+    }
+    qDebug() << "Successfully loaded" << segments.size() << "track segments and" << scenery.size()
+             << "scenery items from JSON.";
+    return true;
+}
@@ -4,6 +4,7 @@
 
 #include <vector>
 #include <QString>
+#include <QByteArray>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QFile>
@@ -86,10 +87,60 @@ struct TrackSegmentData {
     }
 };
 
+// 关卡热重载: 把一条轨道上的新物品与旧物品按 (角度, 径向偏移) 配对（Data 为 CollectibleData 或 ObstacleData）。
+// 返回每个新物品配上的旧物品编号 oldFirst + j，新增的物品为 -1；每个旧物品最多配上一次
+template <typename Data>
+std::vector<int> matchSegmentItems(const std::vector<Data>& oldData, const std::vector<Data>& newData, int oldFirst)
+{
+    std::vector<bool> matched(oldData.size(), false);
+    std::vector<int> origin(newData.size(), -1);
+    for (size_t k = 0; k < newData.size(); ++k) {
+        for (size_t j = 0; j < oldData.size(); ++j) {
+            if (!matched[j] && oldData[j].angleDegrees == newData[k].angleDegrees
+                && oldData[j].radialOffset == newData[k].radialOffset) {
+                matched[j] = true;
+                origin[k] = oldFirst + static_cast<int>(j);
+                break;
+            }
+        }
+    }
+    return origin;
+}
+
+// 场景装饰（太阳、行星等），只影响画面，不参与判定
+struct SceneryData {
+    QString image;   // 图片路径（通常是资源路径，如 ":/images/earth.png"）
+    double x;        // 图片中心的场景坐标
+    double y;
+    double width;    // 保持比例缩放到不超过 width x height
+    double height;
+    double z;        // 叠放次序，默认在轨道之下
+};
+
+const double DEFAULT_SCENERY_Z = -0.5;
+const double DEFAULT_END_TRIGGER_RADIUS = 5.0; // 关卡文件里的通关点没写半径时使用
+
+// 通关触发点。radius <= 0 表示这一关没有通关点
+struct EndTriggerData {
+    double x = 0;
+    double y = 0;
+    double radius = 0;
+
+    bool isEnabled() const { return radius > 0; }
+};
+
 // TrackData 类用于加载和管理所有轨道段数据
+//
+// 关卡 JSON 有两种写法:
+//   [ 轨道, 轨道, ... ]                       只有轨道（旧格式），没有装饰和通关点
+//   { "segments": [ 轨道, ... ],
+//     "scenery": [ { "image": ":/images/sun.png", "x": 0, "y": 0, "width": 450, "height": 450, "z": -0.5 }, ... ],
+//     "endTrigger": { "x": 0, "y": -16913, "radius": 5 } }
 class TrackData {
 public:
     std::vector<TrackSegmentData> segments; // 存储所有轨道段的列表
+    std::vector<SceneryData> scenery;       // 装饰，GameScene 在镜头接近时才加载图片
+    EndTriggerData endTrigger;
 
     // 默认构造函数
     TrackData() = default;
@@ -98,48 +149,24 @@ public:
     // 参数: jsonString - 包含关卡数据的JSON格式字符串
     // 返回: 如果加载成功则为true，否则为false
     bool loadLevelFromJson(const QString& jsonString) {
-        QJsonParseError parseError;
-        QJsonDocument doc = QJsonDocument::fromJson(jsonString.toUtf8(), &parseError);
-
-        if (doc.isNull()) {
-            qWarning() << "Failed to parse JSON: Document is null. Error:" << parseError.errorString()
-            << "at offset" << parseError.offset;
-            return false;
-        }
-        if (!doc.isArray()) {
-            qWarning() << "Failed to parse JSON: Document is not an array.";
-            return false;
-        }
-
-        segments.clear(); // 清除旧数据
-        QJsonArray levelArray = doc.array();
-
-        if (levelArray.isEmpty()) {
-            qWarning() << "JSON array for level segments is empty. Loading as an empty level.";
-            // 允许空关卡, 如果返回false则空关卡加载失败
-        }
-
-        for (const QJsonValue& segmentValue : levelArray) {
-            if (segmentValue.isObject()) {
-                segments.push_back(TrackSegmentData::fromJsonObject(segmentValue.toObject()));
-            } else {
-                qWarning() << "Encountered non-object value in segments array. Skipping.";
-            }
-        }
-        qDebug() << "Successfully loaded" << segments.size() << "track segments from JSON string.";
-        return true;
+        return loadLevelFromUtf8(jsonString.toUtf8());
     }
 
+    // 从 UTF-8 编码的 JSON 加载关卡数据（单遍流式读取，不构建 QJsonDocument，见 trackdata.cpp）
+    // 参数: json - 关卡 JSON 的原始字节; errorString - 失败时写入 "line L, column C: 原因"
+    // 返回: 如果加载成功则为true，否则为false
+    bool loadLevelFromUtf8(const QByteArray& json, QString* errorString = nullptr);
+
     // 从文件加载关卡数据
     // 参数: filePath - 关卡JSON文件的路径
     // 返回: 如果加载成功则为true，否则为false
     bool loadLevelFromFile(const QString& filePath) {
         QFile file(filePath);
-        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (!file.open(QIODevice::ReadOnly)) {
             qWarning() << "Couldn't open level file:" << filePath << "Error:" << file.errorString();
             return false;
         }
-        QString jsonData = file.readAll();
+        const QByteArray jsonData = file.readAll(); // 直接按字节读取，不转成 QString
         file.close();
 
         // 检查读取到的jsonData是否为空
@@ -150,11 +177,18 @@ public:
             } else {
                 qWarning() << "Level file is empty:" << filePath << ". Loading as an empty level.";
                 segments.clear(); // 确保如果是空文件，segments也是空的
+                scenery.clear();
+                endTrigger = EndTriggerData();
                 return true; // 视为空关卡，加载成功
             }
         }
         qDebug() << "Loading level from file:" << filePath;
-        return loadLevelFromJson(jsonData);
+        QString error;
+        if (!loadLevelFromUtf8(jsonData, &error)) {
+            qWarning() << "Level file" << filePath << "is not valid:" << error;
+            return false;
+        }
+        return true;
     }
 };
 
@@ -0,0 +1,106 @@
+// 文件: trackgenerator.cpp
+#include "trackgenerator.h"
+#include "orbitsimulation.h"
+#include "orbitcollision.h"
+#include <cmath>
+
+namespace {
+
+// angle 与 center 的最小角度差是否小于 halfWidth（弧度）
+bool nearAngle(qreal angle, qreal center, qreal halfWidth)
+{
+    qreal delta = std::fmod(angle - center, 2.0 * M_PI);
+    if (delta < 0) delta += 2.0 * M_PI;
+    return qMin(delta, 2.0 * M_PI - delta) < halfWidth;
+}
+
+} // namespace
+
+TrackGenerator::TrackGenerator(quint32 seed)
+{
+    reset(seed);
+}
+
+void TrackGenerator::reset(quint32 seed)
+{
+    m_random.seed(seed);
+    m_seed = seed;
+    m_generatedCount = 0;
+    m_previousRadius = 0;
+    m_tangentX = 0;
+    m_tangentY = 0;
+}
+
+TrackSegmentData TrackGenerator::next(int speedLevel)
+{
+    TrackSegmentData segment;
+    segment.tangentAngleDegrees = 0;
+
+    if (m_generatedCount == 0) {
+        // 起点轨道与第一关相同：圆心在原点，没有物品
+        segment.centerX = 0;
+        segment.centerY = 0;
+        segment.radius = TRACKGEN_FIRST_RADIUS;
+    } else {
+        const qreal difficulty = qBound(0, speedLevel, TRACKGEN_MAX_DIFFICULTY) / qreal(TRACKGEN_MAX_DIFFICULTY);
+        const qreal maxRadius = TRACKGEN_MAX_RADIUS_EASY + (TRACKGEN_MAX_RADIUS_HARD - TRACKGEN_MAX_RADIUS_EASY) * difficulty;
+        segment.radius = std::round(TRACKGEN_MIN_RADIUS + m_random.generateDouble() * (maxRadius - TRACKGEN_MIN_RADIUS));
+        // 新轨道的底部 (ANGLE_BOTTOM) 落在上一条轨道的判定点上
+        segment.centerX = m_tangentX;
+        segment.centerY = m_tangentY - segment.radius;
+        placeItems(&segment, speedLevel);
+    }
+
+    m_previousRadius = segment.radius;
+    m_tangentX = segment.centerX;
+    m_tangentY = segment.centerY - segment.radius;
+    ++m_generatedCount;
+    return segment;
+}
+
+void TrackGenerator::placeItems(TrackSegmentData* segment, int speedLevel)
+{
+    const qreal difficulty = qBound(0, speedLevel, TRACKGEN_MAX_DIFFICULTY) / qreal(TRACKGEN_MAX_DIFFICULTY);
+    const qreal itemChance = TRACKGEN_ITEM_CHANCE_EASY + (TRACKGEN_ITEM_CHANCE_HARD - TRACKGEN_ITEM_CHANCE_EASY) * difficulty;
+    const qreal obstacleShare = TRACKGEN_OBSTACLE_SHARE_EASY + (TRACKGEN_OBSTACLE_SHARE_HARD - TRACKGEN_OBSTACLE_SHARE_EASY) * difficulty;
+    const qreal radius = segment->radius;
+
+    // 物品位沿轨道等距分布: 相邻两个物品的命中范围之间至少留出 TRACKGEN_MIN_ITEM_GAP_SECONDS 的飞行距离
+    const qreal linearSpeed = BASE_LINEAR_SPEED * qPow(SPEEDUP_FACTOR, speedLevel);
+    const qreal itemReach = BALL_RADIUS + qMax(COLLECTIBLE_HIT_RADIUS, OBSTACLE_HIT_RADIUS);
+    const qreal spacing = 2.0 * itemReach + TRACKGEN_MIN_ITEM_GAP_SECONDS * linearSpeed;
+    const int slotCount = static_cast<int>(2.0 * M_PI * radius / spacing);
+    if (slotCount < 1) return;
+
+    // 切点附近外侧会撞到相邻轨道，只能走内侧，这里的物品要么拿不到、要么躲不开，所以留空。
+    // 禁区 = 外侧撞轨道的角度范围 + 内侧物品的命中范围 + 余量；下一条轨道还没生成，按最大半径估算
+    const qreal outerOrbit = radius + BALL_RADIUS + ORBIT_PADDING;
+    const qreal innerOrbit = radius - (BALL_RADIUS + ORBIT_PADDING);
+    const qreal ringReach = BALL_RADIUS * TRACK_COLLISION_EFFECTIVE_RADIUS_FACTOR;
+    qreal previousRingHalfWidth = 0;
+    qreal nextRingHalfWidth = 0;
+    qreal itemHalfWidth = M_PI;
+    orbitHitWindow(outerOrbit, radius + m_previousRadius, m_previousRadius + ringReach, &previousRingHalfWidth);
+    orbitHitWindow(outerOrbit, radius + TRACKGEN_MAX_RADIUS_EASY, TRACKGEN_MAX_RADIUS_EASY + ringReach, &nextRingHalfWidth);
+    orbitHitWindow(qMax(innerOrbit, BALL_RADIUS), radius - TRACKGEN_ITEM_RADIAL_OFFSET, itemReach, &itemHalfWidth);
+    const qreal margin = qDegreesToRadians(TRACKGEN_TANGENT_MARGIN_DEGREES);
+    const qreal bottomClearance = previousRingHalfWidth + itemHalfWidth + margin;
+    const qreal topClearance = nextRingHalfWidth + itemHalfWidth + margin;
+
+    const qreal slotAngle = 2.0 * M_PI / slotCount;
+    const qreal phase = m_random.generateDouble() * slotAngle;
+    for (int slot = 0; slot < slotCount; ++slot) {
+        const qreal angle = phase + slot * slotAngle;
+        if (nearAngle(angle, ANGLE_BOTTOM, bottomClearance) || nearAngle(angle, ANGLE_TOP, topClearance)) continue;
+        if (m_random.generateDouble() >= itemChance) continue;
+
+        // 每个物品位只放一个物品，另一侧总是空的
+        const bool isObstacle = m_random.generateDouble() < obstacleShare;
+        const qreal radialOffset = (m_random.generateDouble() < 0.5) ? -TRACKGEN_ITEM_RADIAL_OFFSET : TRACKGEN_ITEM_RADIAL_OFFSET;
+        if (isObstacle) {
+            segment->obstacles.push_back({qRadiansToDegrees(angle), radialOffset});
+        } else {
+            segment->collectibles.push_back({qRadiansToDegrees(angle), radialOffset});
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef TRACKGENERATOR_H
+#define TRACKGENERATOR_H
+
+#include <QtGlobal>
+#include <QRandomGenerator>
+
+#include "trackdata.h"
+
+// ==========================================================================
+// TrackGenerator: 无尽模式的轨道生成器（OrbitGame1.0 generateNextTrack 的升级版）。
+// 每次生成一条新轨道，外切在上一条轨道的判定点 ANGLE_TOP 上（换轨后飞船从新轨道的 ANGLE_BOTTOM 出发，
+// 两点必须重合），半径和物品由带种子的随机数决定：同一个种子、同样的速度等级序列，生成的轨道完全相同。
+// 只记住上一条轨道的切点，内存与已生成的轨道数无关。
+// 难度随速度等级上升：轨道变小（角速度更快）、物品更密、障碍物比例更高。
+// ==========================================================================
+
+const qreal TRACKGEN_FIRST_RADIUS = 400.0;          // 第一条轨道（起点，没有物品），与第一关相同
+const qreal TRACKGEN_MIN_RADIUS = 60.0;
+const qreal TRACKGEN_MAX_RADIUS_EASY = 260.0;       // 难度 0 时的最大半径
+const qreal TRACKGEN_MAX_RADIUS_HARD = 140.0;       // 最高难度时的最大半径
+const int TRACKGEN_MAX_DIFFICULTY = 10;             // 速度等级超过这个值后难度不再上升
+const qreal TRACKGEN_ITEM_CHANCE_EASY = 0.25;       // 每个物品位放物品的概率
+const qreal TRACKGEN_ITEM_CHANCE_HARD = 0.6;
+const qreal TRACKGEN_OBSTACLE_SHARE_EASY = 0.3;     // 物品中障碍物的比例
+const qreal TRACKGEN_OBSTACLE_SHARE_HARD = 0.7;
+const qreal TRACKGEN_ITEM_RADIAL_OFFSET = 10.0;     // 物品放在轨道内侧 (-) 或外侧 (+)，与关卡文件一致
+const qreal TRACKGEN_MIN_ITEM_GAP_SECONDS = 0.35;   // 相邻两个物品之间至少留给玩家按 J 的时间
+const qreal TRACKGEN_TANGENT_MARGIN_DEGREES = 5.0; // 切点附近禁放物品的范围之外再留的余量
+
+class TrackGenerator
+{
+public:
+    explicit TrackGenerator(quint32 seed = 0);
+
+    // 从第一条轨道重新开始
+    void reset(quint32 seed);
+    quint32 seed() const { return m_seed; }
+    // 已经生成的轨道数，也就是下一条轨道的编号
+    int generatedCount() const { return m_generatedCount; }
+
+    // 生成下一条轨道。speedLevel 为生成时飞船的速度等级 (OrbitSimState::speedLevel)
+    TrackSegmentData next(int speedLevel);
+
+private:
+    void placeItems(TrackSegmentData* segment, int speedLevel);
+
+    QRandomGenerator m_random;
+    quint32 m_seed;
+    int m_generatedCount;
+    qreal m_previousRadius;
+    qreal m_tangentX; // 上一条轨道的判定点（下一条轨道的底部）
+    qreal m_tangentY;
+};
+
+#endif // TRACKGENERATOR_H
@@ -0,0 +1,124 @@
+// 文件: trackspatialgrid.cpp
+#include "trackspatialgrid.h"
+#include <algorithm>
+#include <cmath>
+#include <QtMath>
+
+// 网格格子数不超过轨道数的这个倍数（再加一个常数），防止稀疏关卡把网格撑得过大
+const int GRID_MAX_CELLS_PER_TRACK = 8;
+const int GRID_MIN_CELLS = 1024;
+
+TrackSpatialGrid::TrackSpatialGrid()
+    : m_originX(0),
+    m_originY(0),
+    m_cellSize(1),
+    m_columns(0),
+    m_rows(0)
+{
+}
+
+void TrackSpatialGrid::clear()
+{
+    m_columns = 0;
+    m_rows = 0;
+    m_cellStart.clear();
+    m_cellTracks.clear();
+}
+
+void TrackSpatialGrid::build(const std::vector<TrackCircle>& tracks, qreal margin)
+{
+    clear();
+    if (tracks.empty()) return;
+
+    // Bounding box of all (expanded) circles
+    qreal minX = tracks[0].centerX, maxX = minX;
+    qreal minY = tracks[0].centerY, maxY = minY;
+    std::vector<qreal> radii;
+    radii.reserve(tracks.size());
+    for (const TrackCircle& t : tracks) {
+        const qreal r = t.radius + margin;
+        minX = qMin(minX, t.centerX - r);
+        maxX = qMax(maxX, t.centerX + r);
+        minY = qMin(minY, t.centerY - r);
+        maxY = qMax(maxY, t.centerY + r);
+        radii.push_back(t.radius + margin);
+    }
+
+    // Cell size ~ the typical ring diameter, so most rings cover only a handful of cells
+    std::nth_element(radii.begin(), radii.begin() + radii.size() / 2, radii.end());
+    m_cellSize = qMax<qreal>(2.0 * radii[radii.size() / 2], 1.0);
+
+    const qreal width = maxX - minX;
+    const qreal height = maxY - minY;
+    const qint64 maxCells = static_cast<qint64>(tracks.size()) * GRID_MAX_CELLS_PER_TRACK + GRID_MIN_CELLS;
+    while ((static_cast<qint64>(width / m_cellSize) + 1) * (static_cast<qint64>(height / m_cellSize) + 1) > maxCells) {
+        m_cellSize *= 2.0;
+    }
+
+    m_originX = minX;
+    m_originY = minY;
+    m_columns = static_cast<int>(width / m_cellSize) + 1;
+    m_rows = static_cast<int>(height / m_cellSize) + 1;
+    const int cellCount = m_columns * m_rows;
+
+    // Two passes: count tracks per cell, then fill (CSR)
+    m_cellStart.assign(cellCount + 1, 0);
+    for (int pass = 0; pass < 2; ++pass) {
+        std::vector<int> fill;
+        if (pass == 1) {
+            for (int c = 0; c < cellCount; ++c) m_cellStart[c + 1] += m_cellStart[c];
+            m_cellTracks.assign(m_cellStart[cellCount], -1);
+            fill.assign(m_cellStart.begin(), m_cellStart.end() - 1);
+        }
+        for (size_t i = 0; i < tracks.size(); ++i) {
+            const TrackCircle& t = tracks[i];
+            const qreal r = t.radius + margin;
+            const int col0 = static_cast<int>((t.centerX - r - m_originX) / m_cellSize);
+            const int col1 = qMin(m_columns - 1, static_cast<int>((t.centerX + r - m_originX) / m_cellSize));
+            const int row0 = static_cast<int>((t.centerY - r - m_originY) / m_cellSize);
+            const int row1 = qMin(m_rows - 1, static_cast<int>((t.centerY + r - m_originY) / m_cellSize));
+            for (int row = row0; row <= row1; ++row) {
+                for (int col = col0; col <= col1; ++col) {
+                    const int cell = row * m_columns + col;
+                    if (pass == 0) m_cellStart[cell + 1]++;
+                    else m_cellTracks[fill[cell]++] = static_cast<int>(i);
+                }
+            }
+        }
+    }
+}
+
+void TrackSpatialGrid::tracksNear(qreal x, qreal y, qreal radius, std::vector<int>* out) const
+{
+    if (isEmpty()) return;
+
+    const int col0 = qMax(0, static_cast<int>(std::floor((x - radius - m_originX) / m_cellSize)));
+    const int col1 = qMin(m_columns - 1, static_cast<int>(std::floor((x + radius - m_originX) / m_cellSize)));
+    const int row0 = qMax(0, static_cast<int>(std::floor((y - radius - m_originY) / m_cellSize)));
+    const int row1 = qMin(m_rows - 1, static_cast<int>(std::floor((y + radius - m_originY) / m_cellSize)));
+
+    const size_t firstNew = out->size();
+    for (int row = row0; row <= row1; ++row) {
+        for (int col = col0; col <= col1; ++col) {
+            const int cell = row * m_columns + col;
+            out->insert(out->end(), m_cellTracks.begin() + m_cellStart[cell], m_cellTracks.begin() + m_cellStart[cell + 1]);
+        }
+    }
+    std::sort(out->begin() + firstNew, out->end());
+    out->erase(std::unique(out->begin() + firstNew, out->end()), out->end());
+}
+
+void TrackSpatialGrid::candidatesAt(qreal x, qreal y, const int** begin, const int** end) const
+{
+    *begin = nullptr;
+    *end = nullptr;
+    if (isEmpty()) return;
+
+    const qreal fx = (x - m_originX) / m_cellSize;
+    const qreal fy = (y - m_originY) / m_cellSize;
+    if (fx < 0 || fy < 0 || fx >= m_columns || fy >= m_rows) return;
+
+    const int cell = static_cast<int>(fy) * m_columns + static_cast<int>(fx);
+    *begin = m_cellTracks.data() + m_cellStart[cell];
+    *end = m_cellTracks.data() + m_cellStart[cell + 1];
+}
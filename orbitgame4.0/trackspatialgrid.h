@@ -0,0 +1,49 @@
+#ifndef TRACKSPATIALGRID_H
+#define TRACKSPATIALGRID_H
+
+#include <vector>
+#include <QtGlobal>
+
+// 一条轨道的外接圆（场景坐标）
+struct TrackCircle {
+    qreal centerX;
+    qreal centerY;
+    qreal radius;
+};
+
+// TrackSpatialGrid: 轨道外接圆上的均匀网格索引。
+// 每个轨道被登记到它（外扩 margin 后的）包围盒覆盖的所有格子里，
+// 因此查询一个点只需要看它所在的那一个格子，每帧只测试附近的几条轨道，
+// 与关卡总轨道数无关。
+// 关卡加载和换驻留窗口时构建。构建本身不打日志，整关加载时由 OrbitSimulation 输出统计。
+class TrackSpatialGrid
+{
+public:
+    TrackSpatialGrid();
+
+    // margin: 查询时使用的最大额外半径（例如飞船的碰撞半径）
+    void build(const std::vector<TrackCircle>& tracks, qreal margin);
+    void clear();
+
+    // 返回 (x, y) 所在格子中的候选轨道索引；点在网格外时返回空区间
+    void candidatesAt(qreal x, qreal y, const int** begin, const int** end) const;
+    // 把包围盒与圆 (x, y, radius) 的包围盒相交的所有格子里的轨道索引追加到 out（升序、去重）
+    void tracksNear(qreal x, qreal y, qreal radius, std::vector<int>* out) const;
+
+    bool isEmpty() const { return m_columns == 0 || m_rows == 0; }
+    int columns() const { return m_columns; }
+    int rows() const { return m_rows; }
+    qreal cellSize() const { return m_cellSize; }
+    int entryCount() const { return static_cast<int>(m_cellTracks.size()); }
+
+private:
+    qreal m_originX;
+    qreal m_originY;
+    qreal m_cellSize;
+    int m_columns;
+    int m_rows;
+    std::vector<int> m_cellStart;   // 每个格子在 m_cellTracks 中的起点（CSR 布局，长度为格子数 + 1）
+    std::vector<int> m_cellTracks;  // 所有格子的轨道索引，按格子顺序连续存放
+};
+
+#endif // TRACKSPATIALGRID_H